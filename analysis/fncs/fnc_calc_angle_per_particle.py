@@ -8,10 +8,13 @@ from scipy.stats import norm, skewnorm
 
 # Extracts and returns actual inital particle source angles
 from fnc_findSourceAngle import findSourceAngle
+from fnc_getDetectorHitData import readEventStream
 
-def calculateAnglePerParticle(gap_in_cm):
+# data_directory: where the run wrote hits and init_pos (a run directory
+# with /pinhole/output/perRun); the row is appended to ./data/results.txt
+def calculateAnglePerParticle(gap_in_cm, data_directory='./data'):
     # Read in raw hit data
-    detector_hits = pd.read_csv('./data/hits.csv',
+    detector_hits = readEventStream(data_directory, 'hits',
                                names=["x", "y", "z","energy"],
                                dtype={"x":np.float64,
                                "y": np.float64, "z":np.float64, "energy":np.float64},
@@ -47,7 +50,7 @@ def calculateAnglePerParticle(gap_in_cm):
         mu_phi, std_phi = None, None
         p_phi = None
 
-    theta_actual, phi_actual, numberOfParticles = findSourceAngle()
+    theta_actual, phi_actual, numberOfParticles = findSourceAngle(data_directory)
 
     with open('./data/results.txt', 'a') as f:
         f.write(str(numberOfParticles) +
@@ -3,12 +3,14 @@
 import pandas as pd
 import numpy as np
 
+from fnc_getDetectorHitData import readEventStream
 
-def findSourceAngle():
 
-    initial_params = pd.read_csv('./data/init_pos.csv',
-                                 names=["x","y","z","momX","momY","momZ"],
-                                 dtype=np.float64)
+def findSourceAngle(data_directory='./data'):
+
+    initial_params = readEventStream(data_directory, 'init_pos',
+                                     names=["x","y","z","momX","momY","momZ"],
+                                     dtype=np.float64)
 
     # Only samples first particle since all have same direction from a point source
     theta_actual = round(np.rad2deg(np.arctan2(initial_params['momZ'][0], initial_params['momY'][0])), 4)
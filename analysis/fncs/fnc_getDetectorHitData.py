@@ -1,10 +1,25 @@
 #!/usr/bin/python3.5
 
 
+import glob
+import os
+
 import pandas as pd
 import numpy as np
 
 
+# Rows of one event stream (hits, init_pos) in a data directory: the shared
+# <stem>.csv, or the per-thread <stem>.t<thread>.<seq>.csv files of a run
+# directory (/pinhole/output/perRun)
+def readEventStream(data_directory, stem, names, **kwargs):
+    files = sorted(glob.glob(os.path.join(data_directory, stem + '.csv')) +
+                   glob.glob(os.path.join(data_directory, stem + '.t*.csv')))
+    if not files:
+        return pd.DataFrame(columns=names)
+    return pd.concat([pd.read_csv(f, names=names, **kwargs) for f in files],
+                     ignore_index=True)
+
+
 def getDetectorHitData(detector=None):
     detector_hits = pd.read_csv('./data/hits.csv',
                                  names=["x", "y", "z","energy"],
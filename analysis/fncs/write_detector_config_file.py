@@ -1,8 +1,17 @@
 #!/usr/bin/python3.5
 
-def writeConfigFile(pinhole_rad_mm, window_gap_mm, window_t_um, foil_t_um):
+# layers: optional silicon telescope, a list of (thickness_um, spacing_mm)
+# with detector1 first; the spacing is the centre distance to the previous
+# layer and is ignored for detector1. Without it detector1 is alone.
+# Example, the old two-detector setup: [(2000., 0.), (2000., 5.2)]
+def writeConfigFile(pinhole_rad_mm, window_gap_mm, window_t_um, foil_t_um, layers=None):
     with open('../src/pinhole_config.txt','w') as f:
         f.write(str(pinhole_rad_mm) + '\n')
         f.write(str(window_gap_mm) + '\n')
         f.write(str(window_t_um) + '\n')
         f.write(str(foil_t_um) + '\n')
+
+        if layers:
+            f.write(str(len(layers)) + '\n')
+            for thickness_um, spacing_mm in layers:
+                f.write(str(thickness_um) + ' ' + str(spacing_mm) + '\n')
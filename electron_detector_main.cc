@@ -27,24 +27,13 @@
 /// \file electron_detector_main.cc
 /// \brief Main program of the electron detector simulation
 
-// Base simulation building classes
-#include "DetectorConstruction.hh"
-#include "ActionInitialization.hh"
-#include "RunAction.hh"
+// Run manager, physics, geometry and actions live in pinhole_core
+#include "PinholeSimulation.hh"
+#include "CheckpointManager.hh"
+#include "OutputManager.hh"
+#include "ResultCache.hh"
 
-
-// Multithreading header support
-#ifdef G4MULTITHREADED
-#include "G4MTRunManager.hh"
-#else
-#include "G4RunManager.hh"
-#endif
-
-// Physics lists
 #include "G4UImanager.hh"
-#include "FTFP_BERT.hh"
-#include "G4EmLivermorePhysics.hh"
-#include "G4PhysListFactory.hh"
 
 #ifdef G4VIS_USE
 #include "G4VisExecutive.hh"
@@ -55,49 +44,184 @@
 #endif
 
 #include "G4SystemOfUnits.hh"
-#include "Randomize.hh"
+#include "G4Version.hh"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <sys/time.h>
+
+namespace
+{
+  // Commands that do not change the simulated output
+  G4bool IsCosmetic(const G4String& command)
+  {
+    const char* prefixes[] = { "/control/verbose", "/run/verbose",
+      "/event/verbose", "/tracking/verbose", "/run/printProgress",
+      "/run/numberOfThreads", "/control/saveHistory", "/vis/", "/gui/",
+      "/pinhole/source/list", "/pinhole/telemetry/", "/perf/" };
+    for (size_t i = 0; i < sizeof(prefixes)/sizeof(prefixes[0]); i++) {
+      if (command.compare(0, std::string(prefixes[i]).size(), prefixes[i]) == 0)
+        return true;
+    }
+    return false;
+  }
+
+  // Macro commands with comments, blank lines and cosmetic commands removed
+  // and whitespace collapsed; /control/execute is followed into the file
+  void CanonicalMacro(const G4String& fileName, std::ostream& out, G4int depth)
+  {
+    std::ifstream macro(fileName.c_str());
+    if (!macro.is_open() || depth > 8) {
+      out << "missing " << fileName << "\n";
+      return;
+    }
+
+    std::string line;
+    while (std::getline(macro, line)) {
+      std::istringstream tokens(line);
+      std::string token, canonical;
+      while (tokens >> token) {
+        if (token[0] == '#') break;
+        if (!canonical.empty()) canonical += ' ';
+        canonical += token;
+      }
+      if (canonical.empty() || IsCosmetic(canonical)) continue;
 
+      if (canonical.compare(0, 17, "/control/execute ") == 0) {
+        CanonicalMacro(canonical.substr(17), out, depth + 1);
+      }
+      else {
+        out << canonical << "\n";
+      }
+    }
+  }
+
+  // Canonical description of every input of a batch run
+  G4String BuildCacheKey(const G4String& macroName, const G4String& configName)
+  {
+    std::ostringstream key;
+    key << "pinhole-cache-key 1\n";
+    key << "macro " << macroName << "\n";
+
+    // The executable itself and the Geant4 release it was built against
+    key << "binary " << ResultCache::ToHex(
+      ResultCache::HashFile("/proc/self/exe",
+                            ResultCache::Hash(__DATE__ " " __TIME__))) << "\n";
+    key << "geant4 " << G4Version << "\n";
+    key << "physics " << PinholeSimulation::GetPhysicsListName() << " cuts "
+        << PinholeSimulation::GetLowEnergyLimit()/eV << " eV "
+        << PinholeSimulation::GetHighEnergyLimit()/eV << " eV\n";
+    key << "engine RanecuEngine\n";
 
+    // Values, not text, so that formatting changes do not miss the cache
+    std::ifstream configFile(configName.c_str());
+    G4double value;
+    key << "config";
+    while (configFile >> value) key << " " << value;
+    key << "\n";
+
+    CanonicalMacro(macroName, key, 0);
+    return key.str();
+  }
+
+  G4double WallSeconds()
+  {
+    timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec + 1.e-6*now.tv_usec;
+  }
+
+  void Usage()
+  {
+    G4cerr << "usage: main [--output <dir>] [--config <file>] [--cache]"
+           << " [--cache-dir <dir>]\n"
+           << "            [--cache-max-mb <n>] [macro]\n"
+           << "       main [--output <dir>] [--config <file>] --resume <macro>\n"
+           << "       main [--cache-dir <dir>] --cache-list\n"
+           << "       main [--cache-dir <dir>] --cache-query <macro>" << G4endl;
+  }
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 int main(int argc,char** argv)
 {
+  // Command line: optional output, geometry and result cache flags, then
+  // the macro
+  G4String macroName;
+  G4String outputDirectory = "../analysis/data";
+  G4String configName = "../src/pinhole_config.txt";
+  G4String cacheDirectory = "../analysis/cache";
+  G4double cacheMaxMB = 2048.;
+  G4bool   useCache = false;
+  G4bool   listCache = false;
+  G4bool   resume = false;
+  G4String queryMacro;
 
-  // Detect interactive mode (if no arguments) and define UI session
-  G4UIExecutive* ui = 0;
-  if ( argc == 1 ) {
-    ui = new G4UIExecutive(argc, argv);
+  for (G4int i = 1; i < argc; i++) {
+    G4String arg = argv[i];
+    G4bool hasValue = i + 1 < argc;
+    if      (arg == "--output" && hasValue) outputDirectory = argv[++i];
+    else if (arg == "--config" && hasValue) configName = argv[++i];
+    else if (arg == "--cache") useCache = true;
+    else if (arg == "--cache-dir" && hasValue) cacheDirectory = argv[++i];
+    else if (arg == "--cache-max-mb" && hasValue) cacheMaxMB = std::atof(argv[++i]);
+    else if (arg == "--cache-list") listCache = true;
+    else if (arg == "--cache-query" && hasValue) queryMacro = argv[++i];
+    else if (arg == "--resume") resume = true;
+    else if (arg.compare(0, 2, "--") == 0 || !macroName.empty()) {
+      Usage();
+      return 1;
+    }
+    else macroName = arg;
   }
 
-  // Choose the Random engine
-  G4Random::setTheEngine(new CLHEP::RanecuEngine);
-
-  // Construct the default run manager
-#ifndef G4MULTITHREADED
-  G4MTRunManager* runManager = new G4MTRunManager;
-  runManager->SetNumberOfThreads(4);  // (Grant's computer)
-#else
-  G4RunManager* runManager = new G4RunManager;
-#endif
-
+  // A resumed job only produces the rest of the outputs
+  if (resume && (useCache || macroName.empty())) {
+    Usage();
+    return 1;
+  }
 
-  // Physics list
-  // G4VModularPhysicsList* physicsList = new FTFP_BERT; //QBBC;
-  G4PhysListFactory factory;
-  G4VModularPhysicsList* physicsList = factory.GetReferencePhysList("FTFP_BERT_LIV");
-  physicsList->SetVerboseLevel(1);
-  runManager->SetUserInitialization(new DetectorConstruction());
-  runManager->SetUserInitialization(physicsList);
-  runManager->SetUserInitialization(new ActionInitialization());
+  ResultCache cache(cacheDirectory, cacheMaxMB*1024.*1024.);
+  if (listCache) {
+    cache.List(G4cout);
+    return 0;
+  }
+  if (!queryMacro.empty()) {
+    G4String key = BuildCacheKey(queryMacro, configName);
+    G4cout << ResultCache::ToHex(ResultCache::Hash(key))
+           << (cache.Contains(key) ? " hit" : " miss") << G4endl;
+    return 0;
+  }
 
-  G4double lowLimit = 250. * eV;
-  G4double highLimit = 100. * GeV;
-  G4ProductionCutsTable::GetProductionCutsTable()->SetEnergyRange(lowLimit, highLimit);
+  // Identical inputs: replay the stored outputs instead of simulating
+  G4String cacheKey;
+  G4double startTime = WallSeconds();
+  if (useCache && !macroName.empty()) {
+    cacheKey = BuildCacheKey(macroName, configName);
+    if (cache.Restore(cacheKey, outputDirectory)) {
+      G4cout << "Result cache hit " << ResultCache::ToHex(
+        ResultCache::Hash(cacheKey)) << ", outputs restored to "
+        << outputDirectory << G4endl;
+      return 0;
+    }
+    cache.Snapshot(outputDirectory);
+  }
 
-  // runManager->SetUserInitialization(new PhysicsList);
+  // Detect interactive mode (if no macro) and define UI session
+  G4UIExecutive* ui = 0;
+  if ( macroName.empty() ) {
+    ui = new G4UIExecutive(argc, argv);
+  }
 
-  RunAction* theRunAction = new RunAction;
+  // Random engine, run manager, physics list, geometry, actions and the
+  // job-wide singletons
+  PinholeSimulation* simulation = new PinholeSimulation(4);  // (Grant's computer)
+  CheckpointManager::Instance()->SetResume(resume);
+  OutputManager::Instance()->SetRootDirectory(outputDirectory);
+  G4String outputRoot = OutputManager::Instance()->GetRootDirectory();
+  simulation->SetGeometryFile(configName);
 
 
   // Initialize visualization
@@ -114,9 +238,7 @@ int main(int argc,char** argv)
   if ( ! ui ) {
     // batch mode
     G4String command = "/control/execute ";
-    G4String fileName = argv[1];
-    theRunAction->getFilenameToRunAction(fileName);
-    UImanager->ApplyCommand(command+fileName);
+    UImanager->ApplyCommand(command+macroName);
   }
   else {
     // interactive mode
@@ -130,8 +252,28 @@ int main(int argc,char** argv)
   // owned and deleted by the run manager, so they should not be deleted
   // in the main() program !
 
+  // Only outputs in the root of the command line are cached: its files
+  // and the run directories created in it
+  const OutputManager* output = OutputManager::Instance();
+  G4bool cacheable = output->GetRootDirectory() == outputRoot;
+
   delete visManager;
-  delete runManager;
+  delete simulation;
+
+  // Outputs are complete once the run manager has closed its files
+  if (!cacheKey.empty() && !cacheable) {
+    G4cerr << "Result cache: redirected outputs are not stored"
+           << G4endl;
+  }
+  else if (!cacheKey.empty()) {
+    if (cache.Store(cacheKey, outputDirectory, WallSeconds() - startTime)) {
+      cache.Evict();
+    }
+    else {
+      G4cerr << "Result cache: could not store the outputs in "
+             << cacheDirectory << G4endl;
+    }
+  }
 
   return 0;
 }
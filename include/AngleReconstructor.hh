@@ -0,0 +1,105 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file AngleReconstructor.hh
+/// \brief Definition of the AngleReconstructor class
+
+#ifndef AngleReconstructor_h
+#define AngleReconstructor_h 1
+
+#include <vector>
+
+class ResponseLibrary;
+
+/// Maximum-likelihood source angles of a detector1 image.
+///
+/// The observed counts are compared with the response library templates
+/// by a binned Poisson likelihood in which the source intensity is
+/// profiled out analytically, so only the image shape is fitted:
+///
+///   ln L(theta, phi) = sum_i n_i ln t_i + N ln(N/T) - N,  T = sum_i t_i
+///
+/// The search scans the library nodes first (every other node, then the
+/// neighbours of the best), using precomputed log templates so that each
+/// node costs one dot product. It then refines a shrinking 3x3 pattern
+/// around the best point with bilinear template interpolation, down to the
+/// requested tolerance. Uncertainties come from the curvature of ln L at
+/// the optimum. Only pixels with counts enter the sums, so the cost scales
+/// with the occupied pixels, not the image size.
+///
+/// Fit() does not modify the reconstructor and may be called from several
+/// threads at once.
+
+class AngleReconstructor
+{
+  public:
+    struct Result
+    {
+      double theta;        // degrees
+      double phi;
+      double sigmaTheta;
+      double sigmaPhi;
+      double logLikelihood;
+      double counts;
+      int    evaluations;
+    };
+
+    // Templates are the library responses interpolated at energy (keV)
+    AngleReconstructor(const ResponseLibrary& library, double energy);
+
+    // Stop refining once the grid step is below tolerance (degrees)
+    void SetTolerance(double tolerance) { fTolerance = tolerance; }
+
+    // image: nz*nx counts, row-major, on the library pixel grid
+    Result Fit(const double* image) const;
+
+  private:
+    struct Observed
+    {
+      std::vector<int>    pixels;
+      std::vector<double> counts;
+      double total;
+    };
+
+    double LogLikelihood(double theta, double phi, const Observed& observed,
+                         std::vector<double>& scratch) const;
+    double NodeLogLikelihood(int iTheta, int iPhi, const Observed& observed)
+      const;
+
+    std::vector<double> fThetas;
+    std::vector<double> fPhis;
+    int fPixels;
+
+    std::vector<float>  fTemplates;   // [theta][phi][pixel]
+    std::vector<float>  fLogTemplates;
+    std::vector<double> fTotals;      // [theta][phi]
+
+    double fTolerance;
+    double fFloor;                    // lower bound on template values
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,130 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file CheckpointManager.hh
+/// \brief Definition of the CheckpointManager class
+
+#ifndef CheckpointManager_h
+#define CheckpointManager_h 1
+
+#include "globals.hh"
+
+#include <utility>
+#include <vector>
+
+class Run;
+class CheckpointMessenger;
+
+/// Runs a long job as a sequence of shorter runs with checkpoints between
+/// them, so that a crash only loses the chunk in progress.
+///
+/// /pinhole/checkpoint/beamOn N simulates N events in chunks of at least
+/// /pinhole/checkpoint/events. Each chunk is a run, and the end of a run
+/// waits for every worker, so with /pinhole/checkpoint/interval the chunks
+/// are sized from the measured event rate to last the interval: the job
+/// only stops its workers where a checkpoint is written. The master
+/// RunAction hands every merged chunk to Collect() instead of writing its
+/// outputs, and the image and results.txt row are written once for the
+/// whole job. After a chunk the
+/// workers are idle, so the checkpoint is written then: the master engine
+/// status (workers are reseeded from it for every event), the merged
+/// results so far and the sizes of the appended hit files. A job started
+/// with main --resume continues from the last complete checkpoint with the
+/// same event seeds it would have had without the interruption. Jobs of
+/// the macro that had completed are skipped.
+///
+/// With a target error (/pinhole/estimator/beamOnUntil) N is only the
+/// budget: the job also ends after the first chunk at which the standard
+/// errors of the merged theta and phi means are both below the target.
+/// The check needs the merged run, so such jobs keep chunks of
+/// /pinhole/checkpoint/events and write a checkpoint after the first chunk
+/// past each interval.
+
+class CheckpointManager
+{
+  public:
+    static CheckpointManager* Instance();
+    ~CheckpointManager();
+
+    // True during BeamOn(), checked by the master RunAction
+    static G4bool IsRunning() { return fgInstance && fgInstance->fRunning; }
+
+    void SetChunkSize(G4int n) { fChunkSize = n; }
+    // Wall time between checkpoints, sets the chunk size from the event
+    // rate; 0 for chunks of SetChunkSize events
+    void SetInterval(G4double seconds) { fInterval = seconds; }
+    void SetFileName(const G4String& name) { fFileName = name; }
+    void SetResume(G4bool resume) { fResume = resume; }
+
+    // targetError: standard error of the mean angles (deg) that ends the
+    // job early, 0 to always simulate nEvents
+    void BeamOn(G4int nEvents, G4double targetError = 0.);
+
+    // Adds the merged run of the chunk that just ended to the job totals
+    void Collect(const Run* run);
+
+  private:
+    CheckpointManager();
+
+    G4bool Converged() const;
+    G4bool Save(G4int nEvents, G4int nDone);
+    G4bool ReadCheckpoint();
+    void   Restore();
+    void   Remove(const G4String& fileName) const;
+    G4String Versioned(G4int nDone, const char* extension) const;
+
+    static CheckpointManager* fgInstance;
+
+    CheckpointMessenger* fMessenger;
+
+    G4int    fChunkSize;
+    G4double fInterval;
+    G4String fFileName;
+    G4bool   fResume;
+
+    G4bool   fRunning;
+    G4double fTargetError;
+    Run*     fTotal;
+    G4int    fFirstRunID;
+    // Checkpointed beamOn commands so far, to find the job to resume
+    G4int    fJob;
+
+    // Contents of the checkpoint being resumed
+    G4int    fResumeJob;
+    G4int    fResumeTotal;
+    G4double fResumeTargetError;
+    G4int    fResumeDone;
+    G4int    fResumeFirstRunID;
+    std::vector<std::pair<G4String, long> > fResumeFiles;
+    G4String fResumeOutput;
+
+    // Files written by the last checkpoint, removed by the next one
+    G4String fRngFile;
+    G4String fStateFile;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
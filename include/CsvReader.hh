@@ -0,0 +1,79 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file CsvReader.hh
+/// \brief Definition of the CsvReader class
+
+#ifndef CsvReader_h
+#define CsvReader_h 1
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// Streaming reader for the numeric CSV files written by the simulation
+/// (hits.csv, init_pos.csv).
+///
+/// The file is read in fixed-size blocks, lines are found with memchr and
+/// numbers are parsed in place, eight digits at a time where possible, so
+/// memory stays bounded whatever the file size. Values that the fast path
+/// cannot convert exactly fall back to strtod, so the result is always the
+/// correctly rounded double. Lines that do not parse (text tags, truncated
+/// writes) are skipped, like pandas' error_bad_lines=False.
+
+class CsvReader
+{
+  public:
+    CsvReader(const std::string& fileName, std::size_t blockSize = 1 << 20);
+    ~CsvReader();
+
+    bool IsOpen() const { return fFile >= 0; }
+
+    // Parses the next non-empty line into values. Returns the number of
+    // fields, or -1 at end of file. Lines with a non-numeric field are
+    // counted as bad and skipped.
+    int ReadLine(double* values, int maxFields);
+
+    long GetLines() const { return fLines; }
+    long GetBadLines() const { return fBadLines; }
+
+    // Parses one number at p, advancing p past it; false if not a number
+    static bool ParseDouble(const char*& p, const char* end, double& value);
+
+  private:
+    bool FillBuffer();
+
+    int               fFile;
+    std::vector<char> fBuffer;
+    std::size_t       fBegin;
+    std::size_t       fEnd;
+    bool              fEof;
+    long              fLines;
+    long              fBadLines;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -32,16 +32,43 @@
 #define DetectorConstruction_h 1
 
 #include "G4VUserDetectorConstruction.hh"
+#include "G4ThreeVector.hh"
 #include "globals.hh"
 
+#include <vector>
+
 class G4VPhysicalVolume;
 class G4LogicalVolume;
+class G4Material;
+class G4VSolid;
+class DetectorMessenger;
+class MaskParameterisation;
 
 /// Detector construction class to define materials and geometry.
+///
+/// pinhole_config.txt holds the pinhole radius (mm), window gap (mm),
+/// window thickness (um) and foil thickness (um), optionally followed by
+/// the silicon telescope: the number of layers, then one "thickness_um
+/// spacing_mm" line per layer, the spacing being the centre distance to
+/// the previous layer along the beam (+y). The first layer is detector1 at
+/// the origin, its spacing is ignored. Without the telescope lines there
+/// is detector1 alone, 2 mm thick.
+///
+/// The file is read on every Construct(), so a changed configuration takes
+/// effect with G4RunManager::ReinitializeGeometry(); materials and elements
+/// made by an earlier construction are reused.
+///
+/// Instead of the single knife-edge pinhole the window can carry a coded
+/// aperture mask (/pinhole/mask/): a MURA or a pattern file, one knife-edge
+/// aperture per open cell. The window is then a plain box and the apertures
+/// one G4PVParameterised inside it, never boolean solids, so the navigator
+/// voxelises them and the cost of a step barely grows with their number.
 
 class DetectorConstruction : public G4VUserDetectorConstruction
 {
   public:
+    enum MaskType { kPinhole, kMURA, kPatternFile };
+
     DetectorConstruction();
     virtual ~DetectorConstruction();
 
@@ -49,11 +76,98 @@ class DetectorConstruction : public G4VUserDetectorConstruction
     
     G4LogicalVolume* GetScoringVolume() const { return fScoringVolume; }
 
+    // Half extents of detector1 in its readout plane (x, z)
+    G4double GetDetectorHalfX() const { return fDetectorHalfX; }
+    G4double GetDetectorHalfZ() const { return fDetectorHalfZ; }
+
+    // Values read from pinhole_config.txt
+    G4double GetPinholeRadius() const { return fPinholeRadius; }
+    G4double GetWindowGap() const { return fWindowGap; }
+    G4double GetWindowThickness() const { return fWindowThickness; }
+    G4double GetFoilThickness() const { return fFoilThickness; }
+
+    // Distance used to turn hit positions into angles, as in run_over_angles
+    G4double GetAngleGap() const;
+
+    // Silicon layers, detector1 first; placed volumes are detector1..N
+    G4int    GetNumberOfLayers() const { return G4int(fLayerVolumes.size()); }
+    G4double GetLayerPosition(G4int layer) const { return fLayerY[layer]; }
+    G4double GetLayerThickness(G4int layer) const { return fLayerThickness[layer]; }
+    const G4VPhysicalVolume* GetLayerVolume(G4int layer) const
+    { return fLayerVolumes[layer]; }
+    // Layer of a placed volume, -1 if it is not a layer
+    inline G4int GetLayerIndex(const G4VPhysicalVolume* volume) const;
+
+    // Configuration file, ../src/pinhole_config.txt by default
+    void SetConfigFileName(const G4String& name) { fConfigFileName = name; }
+    const G4String& GetConfigFileName() const { return fConfigFileName; }
+
+    // Pixel pitch of the virtual detector1 readout, 0 when disabled
+    void     SetReadoutPitch(G4double pitch) { fReadoutPitch = pitch; }
+    G4double GetReadoutPitch() const { return fReadoutPitch; }
+
+    // Aperture mask in the window; the radius defaults (0) to the pinhole
+    // radius of the configuration file
+    void SetMaskType(MaskType type) { fMaskType = type; }
+    void SetMaskRank(G4int rank) { fMaskRank = rank; }
+    void SetMaskFileName(const G4String& name) { fMaskFileName = name; }
+    void SetMaskPitch(G4double pitch) { fMaskPitch = pitch; }
+    void SetApertureRadius(G4double radius) { fApertureRadius = radius; }
+    MaskType GetMaskType() const { return fMaskType; }
+    G4int    GetMaskRank() const { return fMaskRank; }
+    const G4String& GetMaskFileName() const { return fMaskFileName; }
+    G4double GetMaskPitch() const { return fMaskPitch; }
+    G4double GetApertureRadius() const { return fApertureRadius; }
+    G4int    GetNumberOfApertures() const { return fNumberOfApertures; }
+
   protected:
     G4LogicalVolume*  fScoringVolume;
+
+  private:
+    void ConstructPinhole(G4LogicalVolume* mother, G4VSolid* windowSolid,
+                          G4Material* material, const G4ThreeVector& position,
+                          G4bool checkOverlaps);
+    void ConstructMask(G4LogicalVolume* mother, G4double halfX,
+                       G4double halfZ, G4Material* material,
+                       const G4ThreeVector& position, G4bool checkOverlaps);
+
+    DetectorMessenger* fMessenger;
+    G4String           fConfigFileName;
+
+    G4double fDetectorHalfX;
+    G4double fDetectorHalfZ;
+    G4double fPinholeRadius;
+    G4double fWindowGap;
+    G4double fWindowThickness;
+    G4double fFoilThickness;
+    G4double fReadoutPitch;
+
+    MaskType              fMaskType;
+    G4int                 fMaskRank;
+    G4String              fMaskFileName;
+    G4double              fMaskPitch;
+    G4double              fApertureRadius;
+    G4int                 fNumberOfApertures;
+    MaskParameterisation* fMaskParameterisation;
+
+    std::vector<G4VPhysicalVolume*> fLayerVolumes;
+    std::vector<G4double>           fLayerY;
+    std::vector<G4double>           fLayerThickness;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+inline G4int DetectorConstruction::GetLayerIndex(
+  const G4VPhysicalVolume* volume) const
+{
+  // A handful of layers: a linear scan beats any lookup structure
+  for (size_t i = 0; i < fLayerVolumes.size(); i++) {
+    if (fLayerVolumes[i] == volume) return G4int(i);
+  }
+  return -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 #endif
 
@@ -0,0 +1,71 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file DetectorMessenger.hh
+/// \brief Definition of the DetectorMessenger class
+
+#ifndef DetectorMessenger_h
+#define DetectorMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class DetectorConstruction;
+class G4UIdirectory;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithAString;
+
+/// Messenger for detector settings (/pinhole/readout/, /pinhole/mask/).
+///
+/// The detector construction is shared by all threads, so the commands
+/// only run on the master and are not broadcast. Mask commands given after
+/// initialisation rebuild the geometry before the next run.
+
+class DetectorMessenger : public G4UImessenger
+{
+  public:
+    DetectorMessenger(DetectorConstruction* detector);
+    virtual ~DetectorMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+  private:
+    DetectorConstruction* fDetector;
+
+    G4UIdirectory*             fReadoutDir;
+    G4UIcmdWithADoubleAndUnit* fPitchCmd;
+
+    G4UIdirectory*             fMaskDir;
+    G4UIcmdWithAString*        fMaskTypeCmd;
+    G4UIcmdWithAnInteger*      fMaskRankCmd;
+    G4UIcmdWithAString*        fMaskFileCmd;
+    G4UIcmdWithADoubleAndUnit* fMaskPitchCmd;
+    G4UIcmdWithADoubleAndUnit* fApertureRadiusCmd;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,63 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file DigitizerMessenger.hh
+/// \brief Definition of the DigitizerMessenger class
+
+#ifndef DigitizerMessenger_h
+#define DigitizerMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class G4UIdirectory;
+class G4UIcmdWithABool;
+class G4UIcmdWithADoubleAndUnit;
+
+/// Messenger for the detector1 digitization (/pinhole/digi/).
+///
+/// Created by the master RunAction only; the commands are not broadcast.
+
+class DigitizerMessenger : public G4UImessenger
+{
+  public:
+    DigitizerMessenger();
+    virtual ~DigitizerMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+  private:
+    G4UIdirectory*             fDigiDir;
+    G4UIcmdWithABool*          fEnableCmd;
+    G4UIcmdWithADoubleAndUnit* fPitchCmd;
+    G4UIcmdWithABool*          fStripsCmd;
+    G4UIcmdWithADoubleAndUnit* fDiffusionCmd;
+    G4UIcmdWithADoubleAndUnit* fNoiseCmd;
+    G4UIcmdWithADoubleAndUnit* fThresholdCmd;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,102 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file DistributionTest.hh
+/// \brief Definition of the DistributionTest class
+
+#ifndef DistributionTest_h
+#define DistributionTest_h 1
+
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+/// Fixed-binning histogram and the two-sample tests that compare two of
+/// them: chi-square for binned data with unequal totals and a binned
+/// Kolmogorov-Smirnov test, both returning the p-value of the hypothesis
+/// that the samples share one distribution.
+///
+/// Like the other statistics helpers it has no Geant4 dependency.
+
+class DistributionTest
+{
+  public:
+    DistributionTest();
+    DistributionTest(const std::string& name, int nBins, double min,
+                     double max);
+
+    // Entries outside [min, max) go to the first and last bin, so a shift
+    // beyond the range still shows
+    inline void Fill(double value);
+
+    const std::string& GetName() const { return fName; }
+    int    GetNbins() const { return int(fCounts.size()); }
+    double GetMin() const { return fMin; }
+    double GetMax() const { return fMax; }
+    double GetEntries() const;
+    double GetCount(int bin) const { return fCounts[bin]; }
+
+    // Empty histogram with the same name and binning
+    DistributionTest Clone() const;
+
+    // "histogram <name> <nbins> <min> <max> <counts...>"
+    void Write(std::ostream& out) const;
+    bool Read(std::istream& in);
+
+    // p-values; chi2 and ndf are also returned. Adjacent bins are merged
+    // until both samples together have at least 10 entries, so sparse
+    // tails do not break the chi-square approximation
+    static double ChiSquare(const DistributionTest& a,
+                            const DistributionTest& b,
+                            double& chi2, int& ndf);
+    static double KolmogorovSmirnov(const DistributionTest& a,
+                                    const DistributionTest& b,
+                                    double& distance);
+
+    // Two-sided p-value of the difference of two Poisson rates n1/t1 and
+    // n2/t2 in the normal approximation
+    static double RateDifference(double n1, double t1, double n2, double t2);
+
+  private:
+    std::string         fName;
+    double              fMin;
+    double              fMax;
+    std::vector<double> fCounts;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void DistributionTest::Fill(double value)
+{
+  int nBins = int(fCounts.size());
+  int bin = int((value - fMin)/(fMax - fMin)*nBins);
+  if (!(bin >= 0)) bin = 0;
+  if (bin >= nBins) bin = nBins - 1;
+  fCounts[bin] += 1.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
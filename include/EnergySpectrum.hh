@@ -0,0 +1,73 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file EnergySpectrum.hh
+/// \brief Definition of the EnergySpectrum class
+
+#ifndef EnergySpectrum_h
+#define EnergySpectrum_h 1
+
+#include <string>
+
+/// Analytic energy spectrum on a bounded interval.
+///
+/// Used both as the reference spectrum of the multi-energy source mode and
+/// as the target spectrum of the reweighting tool. It has no Geant4
+/// dependency so that the command-line tools can share it; energies are in
+/// whatever unit the caller uses consistently (MeV in the output files).
+
+class EnergySpectrum
+{
+  public:
+    enum Shape { kPowerLaw, kExponential };
+
+    EnergySpectrum();
+    EnergySpectrum(Shape shape, double emin, double emax, double param);
+
+    // Inverse CDF for a uniform deviate u in [0,1)
+    double Sample(double u) const;
+
+    // Normalised probability density on [emin, emax], zero outside
+    double Density(double energy) const;
+
+    Shape  GetShape() const { return fShape; }
+    double GetMin() const { return fMin; }
+    double GetMax() const { return fMax; }
+    double GetParameter() const { return fParameter; }
+
+    // "powerlaw <emin> <emax> <index>" or "exponential <emin> <emax> <efold>"
+    std::string ToString() const;
+    static bool FromString(const std::string& text, EnergySpectrum& spectrum);
+
+  private:
+    Shape  fShape;
+    double fMin;
+    double fMax;
+    double fParameter;  // power-law index or exponential e-folding energy
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -32,42 +32,133 @@
 #define EventAction_h 1
 
 #include "G4UserEventAction.hh"
+#include "G4ThreeVector.hh"
+#include "TrackFitter.hh"
+#include "PixelDigitizer.hh"
 #include "globals.hh"
-#include "G4AccumulableManager.hh"
 
+#include <vector>
 
 class RunAction;
+class DetectorConstruction;
+class PerfCounters;
 
 /// Event action class
 ///
+/// Detector1 entries are buffered during the event by the stepping action.
+/// At the end of the event the trigger classifies the event from them and
+/// only accepted events are written to hits.csv, the analysis ntuples and
+/// the online estimator; the primary row in init_pos.csv is written for
+/// every event unless /pinhole/trigger/filterPrimaries is set. The event
+/// classes are counted per thread and merged at the end of the run.
+///
+/// With a multi-layer telescope the entries of all layers are buffered,
+/// the trigger still looks at detector1, and an accepted event gives one
+/// straight-track record in tracks.csv instead of its raw hits (which can
+/// still be written, tagged by layer, with /pinhole/tracks/rawHits).
+///
+/// With /pinhole/digi/enable the energy deposits in detector1 are buffered
+/// as well, and an accepted event is digitized (see PixelDigitizer) and
+/// written to digis.csv instead of its raw detector1 hits.
 
 class EventAction : public G4UserEventAction
 {
   public:
+    // Trigger classes, from the detector1 entries of the event
+    enum EventClass {
+      kNoHit,          // nothing entered detector1
+      kSingleHit,      // the primary entered once, nothing else did
+      kDoubleHit,      // the primary entered more than once (backscatter)
+      kSecondaryOnly,  // only secondaries entered
+      kMultiHit,       // the primary and secondaries entered
+      kNEventClasses
+    };
+
     EventAction(RunAction* runAction);
     virtual ~EventAction();
 
     virtual void BeginOfEventAction(const G4Event* event);
     virtual void EndOfEventAction(const G4Event* event);
 
-    // Setter methods for per event detector hits
-    void incrementDetector1Flag(){ det1_hitFlag++;}
-    void incrementDetector2Flag(){ det2_hitFlag++;}
-
-    void resetDetector1Flag(){det1_hitFlag = 0;}
-    void resetDetector2Flag(){det2_hitFlag = 0;}
+    // Called by the stepping action for every layer entry
+    void AddHit(G4int layer, const G4ThreeVector& pos, const G4ThreeVector& dir,
+                G4double energy, G4bool isPrimary);
 
     void AddEdep(G4double edep) { fEdep += edep; }
 
+    // Called by the stepping action for energy deposits in detector1,
+    // only when digitizing
+    inline void AddDeposit(const G4ThreeVector& pos, G4double edep);
+
+    RunAction* GetRunAction() const { return fRunAction; }
+
+    // Profiling counters of the current run, 0 unless /perf/enable
+    PerfCounters* GetPerf() const { return fPerf; }
+
+    // Primary kinematics of the current event, used to tag hits
+    G4double GetPrimaryEnergy() const { return fPrimaryEnergy; }
+    G4double GetPrimaryWeight() const { return fPrimaryWeight; }
+
+    // Job-wide trigger settings, changed on the master between runs only
+    static void   SetTriggerMask(G4int mask) { fgTriggerMask = mask; }
+    static G4int  GetTriggerMask() { return fgTriggerMask; }
+    static void   SetFilterPrimaries(G4bool val) { fgFilterPrimaries = val; }
+    static void   SetWriteRawHits(G4bool val) { fgWriteRawHits = val; }
+    // Off for library drivers that read the hit buffer instead of the
+    // hits.csv, tracks.csv and init_pos.csv rows
+    static void   SetWriteFiles(G4bool val) { fgWriteFiles = val; }
+    static const char* GetClassName(G4int eventClass);
+    static G4int  GetClassByName(const G4String& name);
+
+  private:
+    struct Hit
+    {
+      G4int         layer;
+      G4ThreeVector position;
+      G4ThreeVector direction;
+      G4double      energy;
+    };
+
+    EventClass Classify() const;
+    void WriteEvent(const G4Event* event, G4bool accepted);
+    void WriteAccepted(const G4Event* event);
+    void WriteHits(G4bool tagLayers) const;
+    void WriteTrack();
+    void WriteDigis(const G4Event* event);
+    void WritePrimary(const G4Event* event) const;
+
+    RunAction* fRunAction;
+    G4double   fEdep;
+    G4double   fPrimaryEnergy;
+    G4double   fPrimaryWeight;
+
+    const DetectorConstruction* fDetector;
+
+    PerfCounters* fPerf;
+    G4double      fEventStartTime;
+
+    // Layer entries of the current event; the counts are for detector1
+    std::vector<Hit> fHits;
+    G4int            fPrimaryEntries;
+    G4int            fSecondaryEntries;
+    TrackFitter      fTrackFitter;
+
+    // Owned by the thread's G4DigiManager
+    PixelDigitizer* fDigitizer;
+    G4int           fDigiCollectionID;
+
+    static G4int  fgTriggerMask;
+    static G4bool fgFilterPrimaries;
+    static G4bool fgWriteRawHits;
+    static G4bool fgWriteFiles;
+};
 
-private:
-  RunAction* fRunAction;
-  G4double   fEdep;
-  G4int det1_hitFlag;
-  G4int det2_hitFlag;
-
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-};
+inline void EventAction::AddDeposit(const G4ThreeVector& pos, G4double edep)
+{
+  fDigitizer->AddDeposit(pos, edep);
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -0,0 +1,95 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file HistoManager.hh
+/// \brief Definition of the HistoManager class
+
+#ifndef HistoManager_h
+#define HistoManager_h 1
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+class G4VAnalysisManager;
+class HistoMessenger;
+
+/// Online histograms and ntuples through the Geant4 analysis managers.
+///
+/// One instance per thread, owned by the RunAction. The output backend
+/// (root, csv, xml or hdf5 when Geant4 was built with it) is chosen at
+/// run time with /pinhole/analysis/fileType; the default "none" books
+/// nothing and costs nothing. Histograms are merged over the threads by
+/// Geant4, ntuples too for the root backend.
+///
+/// Booked objects:
+///   H1 0  hit kinetic energy at detector1 entry   [MeV]
+///   H1 1  incident angle on detector1             [deg]
+///   H1 2  primary kinetic energy                  [MeV]
+///   H2 0  detector1 hit map, x vs z               [cm]
+///   Ntuple 0 "hits"      x, y, z, energy, angle, E0
+///   Ntuple 1 "primaries" x0, y0, z0, px, py, pz, E0
+
+class HistoManager
+{
+  public:
+    HistoManager();
+    ~HistoManager();
+
+    void Open(G4int runID);
+    void Save();
+
+    G4bool IsActive() const { return fManager != 0; }
+
+    void FillHit(const G4ThreeVector& pos, const G4ThreeVector& dir,
+                 G4double energy, G4double primaryEnergy);
+    void FillPrimary(const G4ThreeVector& pos, const G4ThreeVector& dir,
+                     G4double energy);
+
+    // Job-wide settings, changed on the master between runs only
+    static void SetFileType(const G4String& type) { fgFileType = type; }
+    static void SetFileName(const G4String& name) { fgFileName = name; }
+    static const G4String& GetFileType() { return fgFileType; }
+
+  private:
+    void Book();
+
+    static G4String fgFileType;
+    static G4String fgFileName;
+
+    HistoMessenger*     fMessenger;
+    G4VAnalysisManager* fManager;
+    G4String            fManagerType;
+
+    G4int fHitEnergyH1;
+    G4int fHitAngleH1;
+    G4int fPrimaryEnergyH1;
+    G4int fHitMapH2;
+    G4int fHitsNtuple;
+    G4int fPrimariesNtuple;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,114 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file HitIndex.hh
+/// \brief Definition of the HitIndex class
+
+#ifndef HitIndex_h
+#define HitIndex_h 1
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Spatial index over the detector1 hits of a hits.csv file.
+///
+/// Build() turns the hit file into one binary file: a uniform grid of
+/// 2^bits x 2^bits cells over the (x, z) extent of the hits, whose cell
+/// table is laid out in Morton (Z) order and records for every cell the
+/// range of its hits and their energy min/max, followed by the hits sorted
+/// by cell. Neighbouring cells are mostly neighbours in the file too, so a
+/// region maps onto a few contiguous blocks. The file is memory-mapped by
+/// Open(); a query visits only the cells whose box and energy range overlap
+/// the selection, and cells entirely inside it are counted without looking
+/// at their hits. Build() reads the CSV three times and only keeps the cell
+/// table in memory.
+///
+/// Units are those of hits.csv: cm and MeV. Telescope files (rows tagged
+/// with the layer) only contribute their layer 1 hits.
+
+class HitIndex
+{
+  public:
+    struct Hit
+    {
+      double x, y, z, energy;
+      double primaryEnergy;   // 0 unless a multi-energy run
+      double weight;          // 1 unless a multi-energy run
+    };
+
+    // A box in (x, z), optionally cut to a circle, and an energy range
+    struct Query
+    {
+      Query();
+      void SetBox(double x0, double x1, double z0, double z1);
+      void SetCircle(double x, double z, double r);
+      void SetEnergy(double e0, double e1) { eMin = e0; eMax = e1; }
+
+      double xMin, xMax, zMin, zMax;
+      double centreX, centreZ, radius;   // radius < 0: box only
+      double eMin, eMax;
+    };
+
+    struct Result
+    {
+      long   hits;           // selected hits
+      long   cellsVisited;   // cells whose hits were touched or counted
+      long   hitsScanned;    // hits tested one by one
+    };
+
+    HitIndex();
+    ~HitIndex();
+
+    static bool Build(const std::string& csvName, const std::string& indexName,
+                      int bits, std::string& error);
+
+    bool Open(const std::string& indexName, std::string& error);
+    void Close();
+
+    // Appends the selected hits to hits if it is not null
+    Result Select(const Query& query, std::vector<Hit>* hits) const;
+
+    long   GetNumberOfHits() const;
+    int    GetCellsPerSide() const;
+    void   GetExtent(double& xMin, double& xMax, double& zMin, double& zMax) const;
+
+    static uint32_t Morton(uint32_t ix, uint32_t iz);
+
+  private:
+    struct Header;
+    struct Cell;
+
+    const Header* fHeader;
+    const Cell*   fCells;
+    const Hit*    fHits;
+    void*         fMap;
+    std::size_t   fMapSize;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
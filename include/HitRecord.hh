@@ -0,0 +1,53 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file HitRecord.hh
+/// \brief Definition of the HitRecord struct
+
+#ifndef HitRecord_h
+#define HitRecord_h 1
+
+#include <cstdint>
+
+/// One layer entry of an accepted event, as kept in the in-memory hit
+/// buffer of a run (see PinholeSimulation).
+///
+/// Plain data in the units of hits.csv (cm, MeV) so that the buffer can be
+/// handed out as one contiguous array; the layout is mirrored by the
+/// buffer format of the Python module.
+
+struct HitRecord
+{
+  double  x, y, z;
+  double  energy;          // kinetic energy at the entry
+  double  primaryEnergy;   // of the event's primary
+  double  weight;          // of the event's primary, 1 unless reweighted
+  int32_t event;
+  int32_t layer;           // 0 is detector1
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
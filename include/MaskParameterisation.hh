@@ -0,0 +1,68 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file MaskParameterisation.hh
+/// \brief Definition of the MaskParameterisation class
+
+#ifndef MaskParameterisation_h
+#define MaskParameterisation_h 1
+
+#include "G4VPVParameterisation.hh"
+#include "G4ThreeVector.hh"
+#include "G4RotationMatrix.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class MaskPattern;
+
+/// Places one aperture cell on every open cell of a mask pattern.
+///
+/// The cells sit on a square grid of the given pitch centred in the mask
+/// plate, all with the same solid turned from z onto the beam axis (y).
+/// Only open cells are copies, so a closed cell costs nothing; with
+/// kUndefined the navigator voxelises the copies like placed daughters.
+
+class MaskParameterisation : public G4VPVParameterisation
+{
+  public:
+    MaskParameterisation(const MaskPattern& pattern, G4double pitch);
+    virtual ~MaskParameterisation();
+
+    virtual void ComputeTransformation(const G4int copyNo,
+                                       G4VPhysicalVolume* physVol) const;
+
+    G4int GetNumberOfCells() const { return G4int(fPositions.size()); }
+    const G4ThreeVector& GetPosition(G4int copyNo) const
+    { return fPositions[copyNo]; }
+
+  private:
+    std::vector<G4ThreeVector> fPositions;
+    G4RotationMatrix*          fRotation;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,68 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file MaskPattern.hh
+/// \brief Definition of the MaskPattern class
+
+#ifndef MaskPattern_h
+#define MaskPattern_h 1
+
+#include <string>
+#include <vector>
+
+/// Open/closed cell pattern of a coded-aperture mask.
+///
+/// Either the square MURA of a prime rank p = 4m+1 (Gottesman & Fenimore),
+/// with cell (i, j) open when i != 0 and j == 0, or when i, j != 0 and both
+/// or neither are quadratic residues mod p; or read from a text file of
+/// rows of '1' (open) and '0' (closed) characters, '#' starting a comment.
+/// Row i runs along z and column j along x. Like EnergySpectrum it has no
+/// Geant4 dependency so that the reconstruction tools can share it.
+
+class MaskPattern
+{
+  public:
+    MaskPattern();
+
+    // Valid MURA ranks are primes of the form 4m+1
+    static bool IsMURARank(int rank);
+    static bool MakeMURA(int rank, MaskPattern& pattern);
+    static bool FromFile(const std::string& fileName, MaskPattern& pattern);
+
+    int  GetRows() const { return fRows; }
+    int  GetColumns() const { return fColumns; }
+    bool IsOpen(int row, int column) const
+    { return fOpen[size_t(row)*fColumns + column] != 0; }
+    int  GetNumberOfOpen() const;
+
+  private:
+    int fRows;
+    int fColumns;
+    std::vector<char> fOpen;  // row major
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,97 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file OutputFile.hh
+/// \brief Definition of the OutputFile class
+
+#ifndef OutputFile_h
+#define OutputFile_h 1
+
+#include "globals.hh"
+
+#include <fstream>
+#include <sstream>
+
+/// One event-stream output (hits.csv, tracks.csv, init_pos.csv) of one
+/// thread, kept open for the whole run instead of reopened per event.
+///
+/// Shared layout: all threads append to <directory>/<stem><extension>. The
+/// rows of an event are formatted into a per-thread buffer and handed to
+/// the unbuffered file in one write at the end of the event, so rows of
+/// different threads never interleave, however long the event.
+///
+/// Per-thread layout (per-run output directories): every thread writes its
+/// own <stem>.t<thread>.<sequence><extension>, with no sharing and no
+/// locking. The file is named <...>.part while it is written and renamed
+/// once complete; with a size limit the file is completed, and the next
+/// sequence number started, at the first event boundary past the limit.
+///
+/// The file is only created by the first row, so streams a job does not
+/// use (tracks.csv without a telescope) leave no file behind.
+
+class OutputFile
+{
+  public:
+    OutputFile(const G4String& stem, const G4String& extension = ".csv");
+    ~OutputFile();
+
+    // Start of a run; rotateBytes 0 for no size limit
+    void Open(const G4String& directory, G4bool perThread, G4int thread,
+              long rotateBytes);
+
+    // Stream for the rows of the current event
+    std::ostream& Stream()
+    {
+      if (!fPerThread) return fEvent;
+      if (!fStream.is_open()) OpenNext();
+      return fStream;
+    }
+
+    void EndEvent();
+
+    // End of the run: flushes the shared file, completes the own one
+    void Close();
+
+  private:
+    void OpenNext();
+    void Complete();
+
+    G4String fStem;
+    G4String fExtension;
+
+    G4String fDirectory;
+    G4bool   fPerThread;
+    G4int    fThread;
+    long     fRotateBytes;
+
+    std::ofstream fStream;
+    std::ostringstream fEvent;   // rows of the event, shared layout
+    G4String      fFileName;   // the final name of the open file
+    G4int         fSequence;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,114 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file OutputManager.hh
+/// \brief Definition of the OutputManager class
+
+#ifndef OutputManager_h
+#define OutputManager_h 1
+
+#include "globals.hh"
+
+#include <utility>
+#include <vector>
+
+class OutputMessenger;
+
+/// Where the job writes its files.
+///
+/// Everything goes below one output root, ../analysis/data by default
+/// (main --output, /pinhole/output/directory). Job-wide files stay in the
+/// root: results.txt, status.json. By default the per-run files (hits.csv,
+/// init_pos.csv, tracks.csv, digis.csv, spectrum.txt, images, ntuples) go
+/// there too, and the event streams of all runs and threads are appended
+/// to the same files, as the analysis scripts expect.
+///
+/// With /pinhole/output/perRun every run gets its own directory in the
+/// root, run<ID>_<config hash>, claimed with mkdir so that concurrent jobs
+/// sharing a root never write to the same directory: a job that finds the
+/// name taken adds -1, -2, ... Each thread then writes its own event
+/// stream files (see OutputFile), which are renamed from .part when
+/// complete and rotated at /pinhole/output/rotateMB, so no file is shared
+/// and nothing has to be cleaned up between runs. A checkpointed job keeps
+/// one directory for all of its chunks.
+
+class OutputManager
+{
+  public:
+    static OutputManager* Instance();
+    ~OutputManager();
+
+    void SetRootDirectory(const G4String& directory);
+    const G4String& GetRootDirectory() const { return fRoot; }
+
+    void   SetPerRun(G4bool perRun) { fPerRun = perRun; }
+    G4bool IsPerRun() const { return fPerRun; }
+    void   SetRotateBytes(long bytes) { fRotateBytes = bytes; }
+    long   GetRotateBytes() const { return fRotateBytes; }
+
+    // Master RunAction, before the workers start the run
+    void BeginRun(G4int runID);
+
+    // Directory of the current run: its own one or the root
+    const G4String& GetRunDirectory() const { return fRunDirectory; }
+    G4String GetRunPath(const G4String& name) const
+    { return fRunDirectory + "/" + name; }
+    G4String GetJobPath(const G4String& name) const
+    { return fRoot + "/" + name; }
+
+    // Checkpointed jobs: one run directory for all chunks
+    void HoldRunDirectory(G4bool hold) { fHold = hold; fClaimed = false; }
+    // Directory of the held job, empty before its first chunk or if the
+    // runs share the root
+    G4String GetHeldDirectory() const
+    { return fPerRun && fHold && fClaimed ? fRunDirectory : G4String(); }
+    // Complete files with their sizes, to be kept on resume
+    std::vector<std::pair<G4String, long> > GetCheckpointFiles() const;
+    // Back into the directory of an interrupted job; files not in the
+    // checkpoint are from the lost chunk and are removed
+    void Resume(const G4String& runDirectory,
+                const std::vector<std::pair<G4String, long> >& files);
+
+  private:
+    OutputManager();
+
+    G4String ConfigHash() const;
+
+    static OutputManager* fgInstance;
+
+    OutputMessenger* fMessenger;
+
+    G4String fRoot;
+    G4bool   fPerRun;
+    long     fRotateBytes;
+
+    G4String fRunDirectory;
+    G4bool   fHold;
+    G4bool   fClaimed;   // the held job has its directory
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,144 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file PerfCounters.hh
+/// \brief Definition of the PerfCounters class
+
+#ifndef PerfCounters_h
+#define PerfCounters_h 1
+
+#include "globals.hh"
+
+#include <chrono>
+#include <ostream>
+#include <vector>
+
+class G4LogicalVolume;
+class G4ParticleDefinition;
+
+/// Hot-path instrumentation of the user actions (/perf/enable).
+///
+/// Each Run owns one instance when profiling is enabled, so a thread only
+/// ever touches its own counters; they are merged into the master run
+/// like the image and the estimator, and summed over the runs since
+/// profiling was enabled for /perf/report. The actions only check for a
+/// null pointer when profiling is off.
+///
+/// Counted are steps and wall time per logical volume (the time between
+/// two steps of a track goes to the volume of the step), tracks per
+/// particle type, time in GeneratePrimaries, time writing the event
+/// outputs, and a histogram of the event times (begin to end of event).
+
+class PerfCounters
+{
+  public:
+    PerfCounters();
+
+    static G4double Now()
+    {
+      return std::chrono::duration<G4double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Counters of the current run of this thread, 0 if profiling is off
+    static PerfCounters* Current();
+
+    // Called by the tracking and stepping actions
+    void StartTrack(const G4ParticleDefinition* particle);
+    inline void CountStep(const G4LogicalVolume* volume);
+
+    void AddPrimaryTime(G4double seconds) { fPrimarySeconds += seconds; }
+    void AddOutputTime(G4double seconds) { fOutputSeconds += seconds; }
+    void AddEvent(G4double seconds);
+
+    void Merge(const PerfCounters& other);
+    void Print(std::ostream& out) const;
+
+    // Job-wide switch and totals, master only
+    static void   SetEnabled(G4bool enabled);
+    static G4bool IsEnabled() { return fgEnabled; }
+    static void   AddToTotal(const PerfCounters& run) { fgTotal.Merge(run); }
+    static void   Report(std::ostream& out);
+
+  private:
+    struct VolumeEntry
+    {
+      const G4LogicalVolume* volume;
+      G4String               name;
+      G4long                 steps;
+      G4double               seconds;
+    };
+
+    struct ParticleEntry
+    {
+      const G4ParticleDefinition* particle;
+      G4String                    name;
+      G4long                      tracks;
+    };
+
+    VolumeEntry& AddVolume(const G4LogicalVolume* volume);
+
+    // Event times in log bins, 4 per decade from 1 us to 100 s
+    static const G4int kNTimeBins = 32;
+    G4double BinLowEdge(G4int bin) const;
+    G4double TimeQuantile(G4double fraction) const;
+
+    std::vector<VolumeEntry>   fVolumes;
+    std::vector<ParticleEntry> fParticles;
+    G4double fLastStepTime;
+
+    G4long   fEvents;
+    G4double fEventSeconds;
+    G4double fPrimarySeconds;
+    G4double fOutputSeconds;
+    G4long   fEventTimes[kNTimeBins];
+
+    static G4bool       fgEnabled;
+    static PerfCounters fgTotal;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void PerfCounters::CountStep(const G4LogicalVolume* volume)
+{
+  // A handful of volumes, a linear search beats any map
+  VolumeEntry* entry = 0;
+  for (size_t i = 0; i < fVolumes.size(); i++) {
+    if (fVolumes[i].volume == volume) {
+      entry = &fVolumes[i];
+      break;
+    }
+  }
+  if (!entry) entry = &AddVolume(volume);
+
+  G4double now = Now();
+  entry->steps++;
+  entry->seconds += now - fLastStepTime;
+  fLastStepTime = now;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
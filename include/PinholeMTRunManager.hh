@@ -0,0 +1,106 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file PinholeMTRunManager.hh
+/// \brief Definition of the PinholeMTRunManager class
+
+#ifndef PinholeMTRunManager_h
+#define PinholeMTRunManager_h 1
+
+#include "G4MTRunManager.hh"
+#include "globals.hh"
+
+#include <mutex>
+#include <vector>
+
+class SchedulerMessenger;
+
+/// Multi-threaded run manager with adaptive event batches
+/// (/pinhole/schedule/).
+///
+/// Event cost varies by orders of magnitude here (a 3 MeV electron that
+/// showers behind the window against one stopped in it), so the fixed
+/// batches of G4MTRunManager leave threads idle at the end of a run while
+/// others still work through a long batch. In guided mode every request
+/// of a worker gets ceil(remaining/(chunks*threads)) events, at most the
+/// event modulo and at least the minimum batch: full batches while there
+/// is plenty of work, single events at the end for whoever is free.
+///
+/// Batches are claimed from the one event counter under a lock, together
+/// with their seeds, so with the default per-event seeding event i gets
+/// the same seeds whatever the batch sizes. For both modes the time each
+/// worker waits for the last one to finish is printed at the end of the
+/// run.
+
+class PinholeMTRunManager : public G4MTRunManager
+{
+  public:
+    enum Scheduling { kFixed, kGuided };
+
+    PinholeMTRunManager();
+    virtual ~PinholeMTRunManager();
+
+    virtual void  InitializeEventLoop(G4int n_event, const char* macroFile = 0,
+                                      G4int n_select = -1);
+    virtual G4int SetUpNEvents(G4Event* evt, G4SeedsQueue* seedsQueue,
+                               G4bool reseedRequired = true);
+    virtual void  RunTermination();
+
+    void SetScheduling(Scheduling scheduling) { fScheduling = scheduling; }
+    void SetMinBatch(G4int events) { fMinBatch = events; }
+    void SetChunksPerThread(G4int chunks) { fChunksPerThread = chunks; }
+    Scheduling GetScheduling() const { return fScheduling; }
+    G4int GetMinBatch() const { return fMinBatch; }
+    G4int GetChunksPerThread() const { return fChunksPerThread; }
+
+    // Of the last run, per worker thread
+    G4int    GetNumberOfWorkers() const { return G4int(fWorkers.size()); }
+    G4double GetIdleSeconds(G4int thread) const;
+
+  private:
+    // Written by its own worker only; read by the master after the loop
+    struct WorkerLoad
+    {
+      G4int    events;
+      G4int    batches;
+      G4double finished;   // when it was told there is no more work
+    };
+
+    G4int GuidedBatchSize() const;
+    void  PrintLoad() const;
+
+    SchedulerMessenger* fMessenger;
+    Scheduling          fScheduling;
+    G4int               fMinBatch;
+    G4int               fChunksPerThread;
+
+    std::mutex              fSetUpMutex;
+    std::vector<WorkerLoad> fWorkers;
+    G4double                fLoopStart;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,126 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file PinholeSimulation.hh
+/// \brief Definition of the PinholeSimulation class
+
+#ifndef PinholeSimulation_h
+#define PinholeSimulation_h 1
+
+#include "HitRecord.hh"
+#include "globals.hh"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+class G4RunManager;
+class DetectorConstruction;
+class SourceDefinition;
+class SchedulerMessenger;
+
+/// In-process driver of the simulation, the C++ API of pinhole_core.
+///
+/// Owns everything main sets up: the run manager with the physics list,
+/// geometry and actions, and the job-wide singletons (source definition,
+/// response builder, checkpoint manager, telemetry). Geant4 allows one run
+/// manager per process, so there is at most one instance.
+///
+/// A driver configures the geometry (SetGeometryFile) and the source (GPS
+/// or shared-source commands through Execute, or GetSource), then calls
+/// BeamOn repeatedly on the same initialised kernel. With SetKeepHits the
+/// layer entries of accepted events are collected in one contiguous buffer
+/// per run, which GetHits hands out without copying; with SetFileOutput
+/// false no CSV rows are written at all. Hits from several threads follow
+/// the order in which the worker runs were merged.
+
+class PinholeSimulation
+{
+  public:
+    struct Summary
+    {
+      G4int       runID;
+      G4int       events;
+      G4int       acceptedEvents;
+      std::size_t hits;          // records in the hit buffer
+      G4double    seconds;       // wall time of BeamOn
+      G4bool      hasEstimate;   // only with /pinhole/estimator/enable
+      G4double    theta, thetaError;   // median and its std error,
+      G4double    phi, phiError;       // 1.2533 sigmaG/sqrt(n), degrees
+    };
+
+    typedef std::vector<HitRecord>        HitBuffer;
+    typedef std::shared_ptr<const HitBuffer> HitBufferPtr;
+
+    // nThreads is ignored by sequential Geant4 builds
+    explicit PinholeSimulation(G4int nThreads = 4);
+    ~PinholeSimulation();
+
+    static PinholeSimulation* Instance() { return fgInstance; }
+
+    // Physics settings, also part of main's result cache key
+    static const char* GetPhysicsListName() { return "FTFP_BERT_LIV"; }
+    static G4double    GetLowEnergyLimit();
+    static G4double    GetHighEnergyLimit();
+
+    // Any UI command; returns the G4UImanager status, 0 on success
+    G4int Execute(const G4String& command);
+
+    // Geometry configuration file, rebuilt before the next run if changed
+    void SetGeometryFile(const G4String& fileName);
+    SourceDefinition* GetSource() const { return fSource; }
+
+    void SetKeepHits(G4bool keep);
+    void SetFileOutput(G4bool write);
+
+    void Initialize();
+    const Summary& BeamOn(G4int nEvents);
+
+    const Summary& GetSummary() const { return fSummary; }
+
+    // Hit buffer of the last BeamOn; the pointer keeps it alive after the
+    // next run has replaced it
+    HitBufferPtr GetHits() const { return fHits; }
+
+    G4RunManager* GetRunManager() const { return fRunManager; }
+
+  private:
+    static PinholeSimulation* fgInstance;
+
+    G4RunManager*         fRunManager;
+    DetectorConstruction* fDetector;
+    SourceDefinition*     fSource;
+    // /pinhole/schedule/ without the MT run manager, so that shared macros
+    // run in sequential builds too
+    SchedulerMessenger*   fSchedulerMessenger;
+    G4bool                fInitialized;
+
+    Summary      fSummary;
+    HitBufferPtr fHits;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,84 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file PixelDigi.hh
+/// \brief Definition of the PixelDigi class
+
+#ifndef PixelDigi_h
+#define PixelDigi_h 1
+
+#include "G4VDigi.hh"
+#include "G4TDigiCollection.hh"
+#include "G4Allocator.hh"
+#include "globals.hh"
+
+/// One detector1 readout channel above threshold in an event: a pixel, or
+/// a strip along z (iz is then 0). The signal includes the readout noise,
+/// the charge is the collected deposit it was made from.
+
+class PixelDigi : public G4VDigi
+{
+  public:
+    PixelDigi(G4int ix, G4int iz, G4double charge, G4double signal)
+    : G4VDigi(), fIx(ix), fIz(iz), fCharge(charge), fSignal(signal) {}
+    virtual ~PixelDigi() {}
+
+    inline void* operator new(size_t);
+    inline void  operator delete(void* digi);
+
+    G4int    GetIx() const { return fIx; }
+    G4int    GetIz() const { return fIz; }
+    G4double GetCharge() const { return fCharge; }
+    G4double GetSignal() const { return fSignal; }
+
+  private:
+    G4int    fIx;
+    G4int    fIz;
+    G4double fCharge;   // energy equivalent, without noise
+    G4double fSignal;   // energy equivalent, with noise
+};
+
+typedef G4TDigiCollection<PixelDigi> PixelDigiCollection;
+
+extern G4ThreadLocal G4Allocator<PixelDigi>* PixelDigiAllocator;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void* PixelDigi::operator new(size_t)
+{
+  if (!PixelDigiAllocator) PixelDigiAllocator = new G4Allocator<PixelDigi>;
+  return (void*)PixelDigiAllocator->MallocSingle();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void PixelDigi::operator delete(void* digi)
+{
+  PixelDigiAllocator->FreeSingle((PixelDigi*)digi);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
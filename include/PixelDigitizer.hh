@@ -0,0 +1,118 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file PixelDigitizer.hh
+/// \brief Definition of the PixelDigitizer class
+
+#ifndef PixelDigitizer_h
+#define PixelDigitizer_h 1
+
+#include "G4VDigitizerModule.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <utility>
+#include <vector>
+
+/// Digitization of detector1: turns the energy deposited in an event into
+/// the signals of a pixel or strip readout (/pinhole/digi/).
+///
+/// Each deposit drifts to the readout face (+y) and arrives as a Gaussian
+/// charge cloud of width diffusion*sqrt(drift/thickness), the diffusion
+/// width being that of a deposit on the opposite face. The fraction in a
+/// channel is the difference of the error function at its two edges, over
+/// the channels within 4 sigma; strips run along z and only share in x.
+/// Charge beyond the sensor edge is lost. Gaussian readout noise is added
+/// to every channel that collected charge (noise-only channels are not
+/// simulated) and channels below threshold are dropped. Energies are
+/// energy equivalents, as the deposits.
+///
+/// The deposits of an event are kept as separate coordinate arrays and
+/// every stage runs as one loop over an event's deposits or a deposit's
+/// channel edges, which the compiler can vectorise. The channels above
+/// threshold are stored as the PixelDigis collection of the event.
+
+class PixelDigitizer : public G4VDigitizerModule
+{
+  public:
+    PixelDigitizer();
+    virtual ~PixelDigitizer();
+
+    virtual void Digitize();
+
+    // Deposits of the current event, from the stepping action
+    void Clear()
+    {
+      fX.clear(); fY.clear(); fZ.clear(); fEdep.clear();
+    }
+    void AddDeposit(const G4ThreeVector& pos, G4double edep)
+    {
+      fX.push_back(pos.x()); fY.push_back(pos.y()); fZ.push_back(pos.z());
+      fEdep.push_back(edep);
+    }
+
+    // Centre of a channel of the last Digitize(), 0 along strips
+    G4double GetChannelX(G4int ix) const { return fXmin + (ix + 0.5)*fPitch; }
+    G4double GetChannelZ(G4int iz) const
+    { return fgStrips ? 0. : fZmin + (iz + 0.5)*fPitch; }
+
+    // Job-wide settings, changed on the master between runs only
+    static void     SetEnabled(G4bool val) { fgEnabled = val; }
+    static G4bool   IsEnabled() { return fgEnabled; }
+    static void     SetPitch(G4double pitch) { fgPitch = pitch; }
+    static void     SetStrips(G4bool val) { fgStrips = val; }
+    static void     SetDiffusion(G4double sigma) { fgDiffusion = sigma; }
+    static void     SetNoise(G4double sigma) { fgNoise = sigma; }
+    static void     SetThreshold(G4double energy) { fgThreshold = energy; }
+
+  private:
+    // Charge fractions of the channels along one axis, from channel first
+    void Share(G4double u, G4double sigma, G4double min, G4int nChannels,
+               std::vector<G4double>& fractions, G4int& first);
+
+    // Deposits: position and energy
+    std::vector<G4double> fX, fY, fZ, fEdep;
+    std::vector<G4double> fSigma;
+
+    // Work arrays, kept to avoid allocations per event
+    std::vector<G4double> fEdges;
+    std::vector<G4double> fFractionsX, fFractionsZ;
+    std::vector<std::pair<G4int, G4double> > fCharges;
+
+    G4double fXmin;
+    G4double fZmin;
+    G4double fPitch;
+
+    static G4bool   fgEnabled;
+    static G4double fgPitch;
+    static G4bool   fgStrips;
+    static G4double fgDiffusion;
+    static G4double fgNoise;
+    static G4double fgThreshold;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
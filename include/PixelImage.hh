@@ -0,0 +1,107 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file PixelImage.hh
+/// \brief Definition of the PixelImage class
+
+#ifndef PixelImage_h
+#define PixelImage_h 1
+
+#include "globals.hh"
+
+#include <iosfwd>
+
+/// Dense count and deposited-energy image over a virtual pixel grid.
+///
+/// Rows are padded to a whole number of cache lines and the buffers are
+/// cache-line aligned, so that images owned by different worker threads
+/// never share a line. Memory is fixed by the grid size, independent of
+/// the number of hits.
+
+class PixelImage
+{
+  public:
+    PixelImage(G4int nx, G4int nz, G4double xmin, G4double zmin,
+               G4double pitch);
+    ~PixelImage();
+
+    // Returns false when (x, z) falls outside the grid
+    inline G4bool Fill(G4double x, G4double z, G4double counts, G4double edep);
+
+    void Add(const PixelImage& other);
+    void Reset();
+
+    // Raw binary state, for checkpoints; Read needs the same grid
+    void   Write(std::ostream& out) const;
+    G4bool Read(std::istream& in);
+
+    // Writes a (2, nz, nx) float64 .npy array: [0] counts, [1] edep in MeV
+    G4bool WriteNpy(const G4String& fileName) const;
+
+    G4int    GetNx() const { return fNx; }
+    G4int    GetNz() const { return fNz; }
+    G4double GetXmin() const { return fXmin; }
+    G4double GetZmin() const { return fZmin; }
+    G4double GetPitch() const { return fPitch; }
+    G4double GetCounts(G4int ix, G4int iz) const { return fCounts[iz*fStride + ix]; }
+    G4double GetEdep(G4int ix, G4int iz) const { return fEdep[iz*fStride + ix]; }
+
+  private:
+    PixelImage(const PixelImage&);
+    PixelImage& operator=(const PixelImage&);
+
+    G4int     fNx;
+    G4int     fNz;
+    G4int     fStride;   // padded row length
+    G4double  fXmin;
+    G4double  fZmin;
+    G4double  fPitch;
+    G4double  fInvPitch;
+    G4double* fCounts;
+    G4double* fEdep;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline G4bool PixelImage::Fill(G4double x, G4double z,
+                               G4double counts, G4double edep)
+{
+  G4double u = (x - fXmin)*fInvPitch;
+  G4double v = (z - fZmin)*fInvPitch;
+  if (u < 0. || v < 0.) return false;
+
+  G4int ix = G4int(u);
+  G4int iz = G4int(v);
+  if (ix >= fNx || iz >= fNz) return false;
+
+  G4int index = iz*fStride + ix;
+  fCounts[index] += counts;
+  fEdep[index]   += edep;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
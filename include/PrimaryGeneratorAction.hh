@@ -36,15 +36,25 @@
 #include "G4GeneralParticleSource.hh"
 #include "globals.hh"
 
+#include <vector>
+
 // class G4ParticleGun;
 class G4GeneralParticleSource;
 class G4Event;
 class G4Box;
+class SourceDefinition;
 
 /// The primary generator action class with particle gun.
 ///
-/// The default kinematic is a 6 MeV gamma, randomly distribued 
-/// in front of the phantom across 80% of the (X,Y) phantom size.
+/// By default each thread owns a G4GeneralParticleSource driven by /gps/
+/// commands. With /pinhole/source/enable primaries are sampled from the
+/// shared, read-only SourceDefinition with a lightweight particle gun instead,
+/// and if it is set before the workers are built their GPS is never created.
+///
+/// With /pinhole/source/block n the shared-source primaries are pre-sampled
+/// n at a time into per-thread arrays: one array draw from the engine, then
+/// the disc, smear and energy transforms in straight loops. Each event takes
+/// the next entry; the block is refilled when exhausted or at a new run.
 
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 {
@@ -59,7 +69,21 @@ class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
     const G4GeneralParticleSource* GetParticleGun() const { return fParticleGun; }
   
   private:
+    void GenerateFromSharedSource(G4Event*);
+    void FillBlock(size_t n);
+
     G4GeneralParticleSource*  fParticleGun; // pointer a to G4 gun class
+    G4ParticleGun*            fSharedSourceGun; // used with the shared source
+    const SourceDefinition*   fSourceDefinition;
+
+    // Pre-sampled block (structure of arrays) and its random numbers
+    std::vector<G4double>     fBlockX;
+    std::vector<G4double>     fBlockY;
+    std::vector<G4double>     fBlockZ;
+    std::vector<G4double>     fBlockEnergy;
+    std::vector<G4double>     fUniform;
+    size_t                    fBlockNext;
+    G4int                     fBlockRunID;
     // G4GeneralParticleSource* fParticleGun;
     // G4Box* fEnvelopeBox;
 };
@@ -0,0 +1,88 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file ResponseBuilder.hh
+/// \brief Definition of the ResponseBuilder class
+
+#ifndef ResponseBuilder_h
+#define ResponseBuilder_h 1
+
+#include "ResponseLibrary.hh"
+
+#include "globals.hh"
+
+class PixelImage;
+class ResponseMessenger;
+
+/// Fills a ResponseLibrary for the current detector configuration.
+///
+/// On /pinhole/response/build the master loops over the (theta, phi,
+/// energy) grid, aims the shared source through the pinhole as
+/// run_over_angles does, runs the requested number of events per node and
+/// stores the merged detector1 readout image normalised per primary. The
+/// pixel grid is the one set with /pinhole/readout/pitch.
+
+class ResponseBuilder
+{
+  public:
+    static ResponseBuilder* Instance();
+    ~ResponseBuilder();
+
+    // True while Build() is running, checked by the master RunAction
+    static G4bool IsCollecting() { return fgInstance && fgInstance->fCollecting; }
+
+    void SetThetaAxis(G4int n, G4double min, G4double max);
+    void SetPhiAxis(G4int n, G4double min, G4double max);
+    void SetEnergyAxis(G4int n, G4double min, G4double max);
+    void SetEventsPerNode(G4int n) { fEventsPerNode = n; }
+
+    void Build(const G4String& fileName);
+
+    // Stores the merged image of the run that just ended in the current node
+    void Collect(const PixelImage& image, G4int nEvents);
+
+  private:
+    ResponseBuilder();
+
+    static ResponseBuilder* fgInstance;
+
+    ResponseMessenger* fMessenger;
+    ResponseLibrary    fLibrary;
+
+    // Grid nodes, degrees and keV as stored in the library
+    std::vector<G4double> fThetas;
+    std::vector<G4double> fPhis;
+    std::vector<G4double> fEnergies;
+    G4int  fEventsPerNode;
+
+    G4bool fCollecting;
+    G4int  fTheta;
+    G4int  fPhi;
+    G4int  fEnergy;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,117 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file ResponseLibrary.hh
+/// \brief Definition of the ResponseLibrary class
+
+#ifndef ResponseLibrary_h
+#define ResponseLibrary_h 1
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/// Precomputed detector1 response over a (theta, phi, energy) grid.
+///
+/// Every grid node holds the hit-position image of a mono-energetic beam
+/// aimed through the pinhole, as expected hits per primary and pixel, so an
+/// image for any source distribution is a weighted sum of interpolated
+/// nodes. The file is a fixed header followed by one float32 image per
+/// node, laid out so that it can be memory-mapped read-only and used in
+/// place. Angles are in degrees, energies in keV and lengths in cm, as in
+/// the analysis scripts; theta and phi are the run_over_angles source
+/// angles. No Geant4 dependency, so the tools use the same code.
+
+class ResponseLibrary
+{
+  public:
+    ResponseLibrary();
+    ~ResponseLibrary();
+
+    // Allocates an empty library; config holds the four pinhole_config.txt
+    // values it was built for
+    void Create(const std::vector<double>& thetas,
+                const std::vector<double>& phis,
+                const std::vector<double>& energies,
+                int nx, int nz, double xmin, double zmin, double pitch,
+                const double config[4]);
+    bool Write(const std::string& fileName) const;
+
+    // Maps an existing library file read-only
+    bool Open(const std::string& fileName);
+    void Close();
+
+    // Adds weight times the interpolated response at (theta, phi, energy)
+    // to image (nz*nx values, row-major); trilinear, log-linear in energy,
+    // clamped to the grid
+    void Accumulate(double theta, double phi, double energy, double weight,
+                    double* image) const;
+
+    // Node image, writable only for libraries made with Create()
+    float*       GetNode(int iTheta, int iPhi, int iEnergy);
+    const float* GetNode(int iTheta, int iPhi, int iEnergy) const;
+
+    const std::vector<double>& GetThetas() const { return fThetas; }
+    const std::vector<double>& GetPhis() const { return fPhis; }
+    const std::vector<double>& GetEnergies() const { return fEnergies; }
+    int    GetNx() const { return fNx; }
+    int    GetNz() const { return fNz; }
+    double GetXmin() const { return fXmin; }
+    double GetZmin() const { return fZmin; }
+    double GetPitch() const { return fPitch; }
+    const double* GetConfig() const { return fConfig; }
+
+    // Lower node and fraction for linear interpolation on an increasing
+    // axis, clamped to its ends
+    static void Locate(const std::vector<double>& axis, double value,
+                       int& index, double& fraction);
+
+  private:
+    ResponseLibrary(const ResponseLibrary&);
+    ResponseLibrary& operator=(const ResponseLibrary&);
+
+    std::size_t NodeIndex(int iTheta, int iPhi, int iEnergy) const;
+    void BuildLogEnergies();
+
+    std::vector<double> fThetas;
+    std::vector<double> fPhis;
+    std::vector<double> fEnergies;
+    std::vector<double> fLogEnergies;
+    int    fNx;
+    int    fNz;
+    double fXmin;
+    double fZmin;
+    double fPitch;
+    double fConfig[4];
+
+    std::vector<float> fOwned;    // Create()
+    void*        fMapping;        // Open()
+    std::size_t  fMappingSize;
+    const float* fData;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
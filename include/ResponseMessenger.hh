@@ -0,0 +1,68 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file ResponseMessenger.hh
+/// \brief Definition of the ResponseMessenger class
+
+#ifndef ResponseMessenger_h
+#define ResponseMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class ResponseBuilder;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithAnInteger;
+class G4UIcmdWithAString;
+
+/// Messenger for the response library builder (/pinhole/response/).
+///
+/// All commands run on the master only and are not broadcast.
+
+class ResponseMessenger : public G4UImessenger
+{
+  public:
+    ResponseMessenger(ResponseBuilder* builder);
+    virtual ~ResponseMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+  private:
+    G4UIcommand* MakeAxisCommand(const char* name, const char* defaultUnit);
+
+    ResponseBuilder* fBuilder;
+
+    G4UIdirectory*        fResponseDir;
+    G4UIcommand*          fThetaCmd;
+    G4UIcommand*          fPhiCmd;
+    G4UIcommand*          fEnergyCmd;
+    G4UIcmdWithAnInteger* fEventsCmd;
+    G4UIcmdWithAString*   fBuildCmd;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,95 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file ResultCache.hh
+/// \brief Definition of the ResultCache class
+
+#ifndef ResultCache_h
+#define ResultCache_h 1
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+
+/// Content-addressed cache of simulation outputs.
+///
+/// A run is identified by the FNV-1a hash of a canonical text describing
+/// all of its inputs (see BuildKey in the main program). Before a run the
+/// sizes of the files in the data directory are recorded; afterwards the
+/// bytes every file gained (the simulation appends to its outputs) and the
+/// files it created are stored under <cache>/<hash>/. A later run with the
+/// same key replays them into the data directory instead of simulating.
+///
+/// Directories the run created in the data directory (the run<ID>_<hash>
+/// directories of /pinhole/output/perRun) are stored whole. A replay
+/// claims a new directory for each of them the way the OutputManager does,
+/// appending -1, -2, ... to a name that is taken, so it never writes into
+/// the directory of an earlier run.
+///
+/// Entries are written to a temporary directory and renamed into place, so
+/// an interrupted run never leaves a partial entry. The least recently
+/// used entries are evicted when the cache grows beyond its size bound.
+
+class ResultCache
+{
+  public:
+    ResultCache(const std::string& directory, double maxBytes);
+
+    // 64-bit FNV-1a, optionally continuing from a previous hash
+    static uint64_t Hash(const std::string& text,
+                         uint64_t hash = 14695981039346656037ULL);
+    static uint64_t HashFile(const std::string& fileName,
+                             uint64_t hash = 14695981039346656037ULL);
+    static std::string ToHex(uint64_t hash);
+
+    // Replays the entry for key into dataDirectory; false on a miss
+    bool Restore(const std::string& keyText, const std::string& dataDirectory);
+
+    // Records the data directory before a run, then stores what it gained
+    void Snapshot(const std::string& dataDirectory);
+    bool Store(const std::string& keyText, const std::string& dataDirectory,
+               double seconds);
+
+    // Removes least recently used entries until the cache fits maxBytes
+    void Evict();
+
+    // One line per entry: hash, size, last use, run time, first macro line
+    void List(std::ostream& out) const;
+    bool Contains(const std::string& keyText) const;
+
+  private:
+    std::string EntryPath(const std::string& keyText) const;
+
+    std::string fDirectory;
+    double      fMaxBytes;
+    std::map<std::string, long long> fSizesBefore;
+    std::set<std::string>            fDirectoriesBefore;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
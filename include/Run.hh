@@ -0,0 +1,87 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file Run.hh
+/// \brief Definition of the Run class
+
+#ifndef Run_h
+#define Run_h 1
+
+#include "G4Run.hh"
+#include "G4ThreeVector.hh"
+#include "HitRecord.hh"
+#include "globals.hh"
+
+#include <iosfwd>
+#include <vector>
+
+class PixelImage;
+class AngleEstimator;
+class PerfCounters;
+
+/// Run class
+///
+/// Holds the per-thread results that are merged into the master run at the
+/// end of the run: the pixelated detector1 readout image, which only exists
+/// when a readout pitch is set (/pinhole/readout/pitch), and the streaming
+/// angle estimator (/pinhole/estimator/enable), the hot-path counters
+/// (/perf/enable) and the in-memory hit buffer of library drivers
+/// (PinholeSimulation); worker buffers are appended in merge order.
+
+class Run : public G4Run
+{
+  public:
+    Run();
+    virtual ~Run();
+
+    virtual void RecordEvent(const G4Event*);
+    virtual void Merge(const G4Run*);
+
+    // Binary state of the merged results, for checkpoints. Read needs a
+    // run made with the same readout and estimator settings.
+    void   WriteState(std::ostream& out) const;
+    G4bool ReadState(std::istream& in);
+
+    PixelImage*     GetImage() const { return fImage; }
+    AngleEstimator* GetEstimator() const { return fEstimator; }
+    PerfCounters*   GetPerf() const { return fPerf; }
+    std::vector<HitRecord>* GetHitBuffer() const { return fHitBuffer; }
+
+    // Source direction of the earliest event, for the "actual" angles
+    const G4ThreeVector& GetSourceDirection() const { return fSourceDirection; }
+
+  private:
+    PixelImage*     fImage;
+    AngleEstimator* fEstimator;
+    PerfCounters*   fPerf;
+    std::vector<HitRecord>* fHitBuffer;
+
+    G4int         fFirstEventID;
+    G4ThreeVector fSourceDirection;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
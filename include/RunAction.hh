@@ -33,14 +33,19 @@
 
 #include "G4UserRunAction.hh"
 #include "G4Accumulable.hh"
+#include "G4ThreeVector.hh"
+#include "OutputFile.hh"
 #include "globals.hh"
 
-// Choose your fighter:
-// #include "g4root.hh"
-#include "g4xml.hh"
-// #include "g4csv.hh"
+#include <vector>
 
 class G4Run;
+class HistoManager;
+class RunMessenger;
+class PerfMessenger;
+class DigitizerMessenger;
+class PixelImage;
+class AngleEstimator;
 
 /// Run action class
 ///
@@ -54,20 +59,57 @@ class RunAction : public G4UserRunAction
     RunAction();
     virtual ~RunAction();
 
-    // virtual G4Run* GenerateRun();
+    virtual G4Run* GenerateRun();
     virtual void BeginOfRunAction(const G4Run*);
     virtual void   EndOfRunAction(const G4Run*);
 
     void AddEdep (G4double edep);
 
+    // Trigger bookkeeping, one call per event from the EventAction
+    void CountEvent(G4int eventClass, G4bool accepted)
+    {
+      *fClassCounts[eventClass] += 1;
+      if (accepted) fAccepted += 1;
+    }
+
     void getFilenameToRunAction(G4String fileName){fFileName = fileName;}
 
+    HistoManager* GetHistoManager() const { return fHistoManager; }
+
+    // Event streams of this thread, open for the current run
+    OutputFile& GetHitFile()     { return fHitFile; }
+    OutputFile& GetTrackFile()   { return fTrackFile; }
+    OutputFile& GetPrimaryFile() { return fPrimaryFile; }
+    OutputFile& GetDigiFile()    { return fDigiFile; }
+
+    // Job-wide settings, changed on the master between runs only
+    static void   SetEstimatorEnabled(G4bool val) { fgEstimatorEnabled = val; }
+    static G4bool IsEstimatorEnabled() { return fgEstimatorEnabled; }
+    static void   SetResultsFileName(const G4String& name) { fgResultsFileName = name; }
+    // results.txt in the output root unless set
+    static G4String GetResultsFileName();
+    static void   SetHitBufferEnabled(G4bool val) { fgHitBufferEnabled = val; }
+    static G4bool IsHitBufferEnabled() { return fgHitBufferEnabled; }
+
+    // Events the trigger accepted; merged over threads on the master
+    G4int GetAcceptedEvents() const { return fAccepted.GetValue(); }
+
+    // End-of-run outputs, also used for checkpointed jobs spanning runs
+    static void WriteImage(const PixelImage& image, G4int runID);
+    static void WriteResults(const AngleEstimator& estimator,
+                             const G4ThreeVector& sourceDirection,
+                             G4int nEvents);
+
 
 
   private:
     G4Accumulable<G4double> fEdep;
     G4Accumulable<G4double> fEdep2;
 
+    // Events per trigger class and accepted events, merged over threads
+    std::vector<G4Accumulable<G4int>*> fClassCounts;
+    G4Accumulable<G4int>               fAccepted;
+
     G4String fFileName;
 
     G4String asciiFileName;
@@ -75,6 +117,20 @@ class RunAction : public G4UserRunAction
 
     G4String histFileName;
 
+    HistoManager* fHistoManager;
+    RunMessenger* fMessenger;
+    PerfMessenger* fPerfMessenger;
+    DigitizerMessenger* fDigiMessenger;
+
+    OutputFile fHitFile;
+    OutputFile fTrackFile;
+    OutputFile fPrimaryFile;
+    OutputFile fDigiFile;
+
+    static G4bool   fgEstimatorEnabled;
+    static G4String fgResultsFileName;
+    static G4bool   fgHitBufferEnabled;
+
 };
 
 #endif
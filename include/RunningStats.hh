@@ -0,0 +1,139 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file RunningStats.hh
+/// \brief Definition of the RunningStats and QuantileSketch classes
+
+#ifndef RunningStats_h
+#define RunningStats_h 1
+
+#include <cstddef>
+#include <iosfwd>
+#include <vector>
+
+/// Mergeable streaming mean and variance (Welford, with the Chan et al.
+/// update for combining partial results from several threads).
+///
+/// Like the other statistics helpers it has no Geant4 dependency, so the
+/// command-line tools use the same code as the simulation.
+
+class RunningStats
+{
+  public:
+    RunningStats();
+
+    inline void Add(double value);
+    void Merge(const RunningStats& other);
+    void Reset();
+
+    // Raw binary state, for checkpoints
+    void Write(std::ostream& out) const;
+    bool Read(std::istream& in);
+
+    long   GetEntries() const { return fN; }
+    double GetMean() const { return fMean; }
+    // Population variance, as numpy.var / numpy.std with ddof=0
+    double GetVariance() const { return fN > 0 ? fM2/fN : 0.; }
+    double GetStdDev() const;
+    double GetMin() const { return fMin; }
+    double GetMax() const { return fMax; }
+
+  private:
+    long   fN;
+    double fMean;
+    double fM2;
+    double fMin;
+    double fMax;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void RunningStats::Add(double value)
+{
+  fN++;
+  double delta = value - fMean;
+  fMean += delta/fN;
+  fM2   += delta*(value - fMean);
+  if (value < fMin) fMin = value;
+  if (value > fMax) fMax = value;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/// Mergeable quantile sketch: a fine fixed-width histogram over a known
+/// range, with linear interpolation inside the bin holding the quantile.
+/// The quantile error is bounded by the bin width; memory is fixed.
+
+class QuantileSketch
+{
+  public:
+    QuantileSketch(double min, double max, double binWidth);
+
+    inline void Add(double value);
+    void Merge(const QuantileSketch& other);
+    void Reset();
+
+    // Raw binary state, for checkpoints; Read needs the same binning
+    void Write(std::ostream& out) const;
+    bool Read(std::istream& in);
+
+    double Quantile(double q) const;
+    // Entries below value, interpolated inside its bin (inverse of Quantile)
+    double Cumulative(double value) const;
+    double GetEntries() const { return fTotal; }
+
+    // Robust width estimate, 0.7413 times the interquartile range
+    double SigmaG() const { return 0.7413*(Quantile(0.75) - Quantile(0.25)); }
+
+  private:
+    double fMin;
+    double fMax;
+    double fInvWidth;
+    double fWidth;
+    double fUnderflow;
+    double fOverflow;
+    double fTotal;
+    double fLowest;
+    double fHighest;
+    std::vector<double> fBins;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void QuantileSketch::Add(double value)
+{
+  fTotal += 1.;
+  if (value < fLowest) fLowest = value;
+  if (value > fHighest) fHighest = value;
+
+  if (value < fMin) { fUnderflow += 1.; return; }
+  std::size_t bin = std::size_t((value - fMin)*fInvWidth);
+  if (bin >= fBins.size()) { fOverflow += 1.; return; }
+  fBins[bin] += 1.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
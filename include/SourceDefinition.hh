@@ -0,0 +1,138 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file SourceDefinition.hh
+/// \brief Definition of the SourceDefinition class
+
+#ifndef SourceDefinition_h
+#define SourceDefinition_h 1
+
+#include "EnergySpectrum.hh"
+
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <vector>
+
+class G4ParticleDefinition;
+class SourceMessenger;
+
+/// Shared, read-only description of the primary beam.
+///
+/// The definition is built once on the master thread from /pinhole/source/
+/// commands and read concurrently by the worker PrimaryGeneratorActions, which
+/// keep only their own random engine as sampling state. It mirrors the
+/// subset of G4GeneralParticleSource used by the run macros (Beam/Circle
+/// position, planar direction, mono or histogram energy) with the energy
+/// spectrum precomputed into a flat CDF table.
+///
+/// In multi-energy mode energies are drawn from a broad analytic reference
+/// spectrum instead, and every hit is tagged with its primary energy and
+/// weight so that tools/reweight can fold in any target spectrum afterwards.
+
+class SourceDefinition
+{
+  public:
+    static SourceDefinition* Instance();
+    ~SourceDefinition();
+
+    // Setters, only called from the master thread between runs
+    void SetEnabled(G4bool val) { fEnabled = val; }
+    void SetParticle(const G4String& name);
+    void SetCentre(const G4ThreeVector& centre) { fCentre = centre; }
+    void SetDirection(const G4ThreeVector& dir) { fDirection = dir.unit(); }
+    void SetRotation1(const G4ThreeVector& rot1);
+    void SetRotation2(const G4ThreeVector& rot2);
+    void SetRadius(G4double radius) { fRadius = radius; }
+    void SetSigmaR(G4double sigma) { fSigmaR = sigma; }
+    void SetMonoEnergy(G4double energy);
+    void AddEnergyHistogramPoint(G4double energy, G4double weight);
+    void ResetEnergyHistogram();
+    void SetReferenceSpectrum(const EnergySpectrum& spectrum);
+    // Primaries pre-sampled per thread in blocks of n, 0 for one at a time
+    void SetBlockSize(G4int n) { fBlockSize = n; }
+
+    void Print() const;
+
+    // Read-only accessors used by the worker threads
+    G4bool IsEnabled() const { return fEnabled; }
+    G4ParticleDefinition* GetParticleDefinition() const { return fParticle; }
+    const G4ThreeVector& GetCentre() const { return fCentre; }
+    const G4ThreeVector& GetDirection() const { return fDirection; }
+    const G4ThreeVector& GetAxisX() const { return fAxisX; }
+    const G4ThreeVector& GetAxisY() const { return fAxisY; }
+    G4double GetRadius() const { return fRadius; }
+    G4double GetSigmaR() const { return fSigmaR; }
+    G4int    GetBlockSize() const { return fBlockSize; }
+
+    // Multi-energy mode: hits carry the primary energy and weight
+    G4bool IsMultiEnergy() const { return fEnabled && fMultiEnergy; }
+    const EnergySpectrum& GetReferenceSpectrum() const { return fReference; }
+
+    // Inverse CDF lookup of the energy spectrum for a uniform deviate u
+    G4double SampleEnergy(G4double u) const;
+
+  private:
+    SourceDefinition();
+
+    void BuildAxes();
+    void BuildEnergyTable();
+
+    static SourceDefinition* fgInstance;
+
+    SourceMessenger* fMessenger;
+
+    G4bool  fEnabled;
+    G4ParticleDefinition* fParticle;
+
+    // Position: Beam/Circle in the plane spanned by rot1 and rot2
+    G4ThreeVector fCentre;
+    G4ThreeVector fRotation1;
+    G4ThreeVector fRotation2;
+    G4ThreeVector fAxisX;
+    G4ThreeVector fAxisY;
+    G4double fRadius;
+    G4double fSigmaR;
+
+    // Direction: planar
+    G4ThreeVector fDirection;
+
+    // Energy: mono when the histogram is empty
+    G4double fMonoEnergy;
+    std::vector<G4double> fHistEnergies;
+    std::vector<G4double> fHistWeights;
+    std::vector<G4double> fEnergyEdges;
+    std::vector<G4double> fEnergyCDF;
+
+    // Energy: reference spectrum in multi-energy mode (energies in MeV)
+    G4bool fMultiEnergy;
+    EnergySpectrum fReference;
+
+    G4int fBlockSize;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
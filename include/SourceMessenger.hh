@@ -0,0 +1,82 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file SourceMessenger.hh
+/// \brief Definition of the SourceMessenger class
+
+#ifndef SourceMessenger_h
+#define SourceMessenger_h 1
+
+#include "G4UImessenger.hh"
+#include "globals.hh"
+
+class SourceDefinition;
+class G4UIdirectory;
+class G4UIcommand;
+class G4UIcmdWithABool;
+class G4UIcmdWithAString;
+class G4UIcmdWith3Vector;
+class G4UIcmdWith3VectorAndUnit;
+class G4UIcmdWithADoubleAndUnit;
+class G4UIcmdWithoutParameter;
+class G4UIcmdWithAnInteger;
+
+/// Messenger for the shared source definition (/pinhole/source/).
+///
+/// Commands are executed on the master only; workers read the resulting
+/// SourceDefinition directly, so none of them are broadcast.
+
+class SourceMessenger : public G4UImessenger
+{
+  public:
+    SourceMessenger(SourceDefinition* source);
+    virtual ~SourceMessenger();
+
+    virtual void SetNewValue(G4UIcommand*, G4String);
+
+  private:
+    SourceDefinition* fSource;
+
+    G4UIdirectory*              fPinholeDir;
+    G4UIdirectory*              fSourceDir;
+    G4UIcmdWithABool*           fEnableCmd;
+    G4UIcmdWithAString*         fParticleCmd;
+    G4UIcmdWith3VectorAndUnit*  fCentreCmd;
+    G4UIcmdWith3Vector*         fDirectionCmd;
+    G4UIcmdWith3Vector*         fRot1Cmd;
+    G4UIcmdWith3Vector*         fRot2Cmd;
+    G4UIcmdWithADoubleAndUnit*  fRadiusCmd;
+    G4UIcmdWithADoubleAndUnit*  fSigmaRCmd;
+    G4UIcmdWithADoubleAndUnit*  fEnergyCmd;
+    G4UIcommand*                fHistPointCmd;
+    G4UIcmdWithoutParameter*    fHistResetCmd;
+    G4UIcommand*                fReferenceCmd;
+    G4UIcmdWithAnInteger*       fBlockCmd;
+    G4UIcmdWithoutParameter*    fListCmd;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
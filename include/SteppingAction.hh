@@ -35,6 +35,7 @@
 #include "globals.hh"
 
 class EventAction;
+class DetectorConstruction;
 
 class G4LogicalVolume;
 
@@ -55,6 +56,7 @@ public:
 
   private:
     EventAction*  fEventAction;
+    const DetectorConstruction* fDetector;
     // G4LogicalVolume* fScoringVolume;
 };
 
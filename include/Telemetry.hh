@@ -0,0 +1,145 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file Telemetry.hh
+/// \brief Definition of the Telemetry class
+
+#ifndef Telemetry_h
+#define Telemetry_h 1
+
+#include "G4Threading.hh"
+#include "globals.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class TelemetryMessenger;
+
+/// Live progress of the job in a JSON status file.
+///
+/// Every thread counts its events and detector1 hits in its own cache line
+/// of relaxed atomics, so the workers never wait on each other or on the
+/// publisher. With /pinhole/telemetry/enable a background thread of the
+/// master samples the counters every /pinhole/telemetry/interval and
+/// rewrites the status file (write to a temporary file, then rename):
+/// event and hit rates, per-thread progress, events of the run not yet
+/// processed, estimated time to completion and resident memory. The file
+/// is read with tools/runstatus.
+///
+/// A checkpointed job (/pinhole/checkpoint/beamOn, beamOnUntil) runs as a
+/// sequence of chunks, each a run of its own; while it runs, the events to
+/// process, events done, average rate and ETA are those of the whole job.
+
+class Telemetry
+{
+  public:
+    static Telemetry* Instance();
+    ~Telemetry();
+
+    // Called by every thread, lock-free
+    static void CountEvent()
+    { fgCounters[Slot()].fEvents.fetch_add(1, std::memory_order_relaxed); }
+    static void CountHit()
+    { fgCounters[Slot()].fHits.fetch_add(1, std::memory_order_relaxed); }
+
+    void SetEnabled(G4bool enabled);
+    void SetFileName(const G4String& name);
+    void SetInterval(G4double seconds);
+
+    // Master RunAction
+    void BeginRun(G4int runID, G4int nEvents);
+    void EndRun();
+
+    // CheckpointManager: event budget of the job and events done before
+    // the next chunk; EndJob returns to per-run progress
+    void SetJob(G4int nEvents, G4int nDone);
+    void EndJob();
+
+  private:
+    Telemetry();
+
+    static const G4int kMaxSlots = 256;
+
+    // One cache line per thread; slot 0 is the master or sequential thread
+    struct alignas(64) Counters
+    {
+      std::atomic<long> fEvents;
+      std::atomic<long> fHits;
+    };
+
+    static G4int Slot()
+    {
+      G4int id = G4Threading::G4GetThreadId();
+      return id < 0 ? 0 : (id + 1 < kMaxSlots ? id + 1 : kMaxSlots - 1);
+    }
+
+    void Publish();
+    void Sample(const char* state);
+
+    static Telemetry* fgInstance;
+    static Counters   fgCounters[kMaxSlots];
+
+    TelemetryMessenger* fMessenger;
+
+    // Guards everything below, shared with the publisher thread
+    std::mutex              fMutex;
+    std::condition_variable fWakeUp;
+    std::thread             fPublisher;
+    G4bool                  fStop;
+
+    std::string fFileName;
+    G4bool      fFollowOutput;   // status.json in the output root
+    G4double    fInterval;
+
+    G4int    fRunID;
+    G4int    fEventsToProcess;
+    G4bool   fRunning;
+    G4int    fFirstSlot;
+    G4int    fNSlots;
+    G4double fRunStart;
+    G4double fRunEnd;
+
+    // Checkpointed job, fJobEvents = 0 outside of one
+    G4int    fJobEvents;
+    G4int    fJobDone;        // events of the finished chunks
+    G4int    fJobFirstDone;   // events done when the job (re)started
+    G4double fJobStart;
+
+    // Counter values at the start of the run and at the last sample
+    std::vector<long>     fRunEvents;
+    std::vector<long>     fRunHits;
+    std::vector<long>     fLastEvents;
+    std::vector<G4double> fLastProgress;
+    long                  fLastHits;
+    G4double              fLastSample;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,90 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file TrackFitter.hh
+/// \brief Definition of the TrackFitter class
+
+#ifndef TrackFitter_h
+#define TrackFitter_h 1
+
+#include <vector>
+
+/// Straight-line track fit through the hits of a multi-layer telescope.
+///
+/// The layers are planes of constant y. At most one hit per layer is used:
+/// every pair of hits in the first two layers that were hit seeds a line,
+/// the nearest hit of each further layer is added to it, and the seed with
+/// the smallest RMS residual of the least-squares fit wins. Angles follow
+/// calc_angle_per_particle: theta = atan(dz/dy), phi = atan(dx/dy).
+///
+/// Like the statistics helpers it has no Geant4 dependency; positions are
+/// in any consistent length unit.
+
+class TrackFitter
+{
+  public:
+    struct Track
+    {
+      int    nLayers;      // layers on the track
+      double x;            // position at the reference plane
+      double z;
+      double slopeX;       // dx/dy
+      double slopeZ;       // dz/dy
+      double rms;          // RMS distance of the hits from the line
+      int    firstPoint;   // index of the hit in the most upstream layer
+    };
+
+    TrackFitter();
+
+    void Clear() { fPoints.clear(); }
+    void AddPoint(int layer, double x, double y, double z);
+
+    // False if fewer than two layers were hit
+    bool Fit(double yReference, Track& track) const;
+
+    double GetTheta(const Track& track) const;
+    double GetPhi(const Track& track) const;
+
+  private:
+    struct Point
+    {
+      int    layer;
+      double x;
+      double y;
+      double z;
+    };
+
+    void FitSelection(double yReference, Track& track) const;
+
+    std::vector<Point> fPoints;
+
+    // Scratch space reused between events
+    mutable std::vector<int> fLayers;
+    mutable std::vector<int> fSelection;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
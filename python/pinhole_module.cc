@@ -0,0 +1,359 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file pinhole_module.cc
+/// \brief Python module driving the simulation in-process
+
+// Built with -DWITH_PYTHON=ON as pinhole.so in the build directory:
+//
+//   import numpy as np, pinhole
+//   sim = pinhole.Simulation(4)
+//   sim.set_geometry_file("../src/pinhole_config.txt")
+//   sim.execute("/gps/particle e-")
+//   sim.keep_hits(True); sim.file_output(False)
+//   summary = sim.beam_on(10000)          # dict, see Summary
+//   hits = np.asarray(sim.hits())         # structured array, no copy
+//   hits[hits["layer"] == 0]["energy"]
+//
+// The hit view keeps its run's buffer alive, also across later beam_on
+// calls. The simulation runs with the GIL held: one Simulation per process
+// (a Geant4 restriction) driven from one Python thread.
+
+#include <Python.h>
+
+#include "PinholeSimulation.hh"
+
+#include <cstddef>
+#include <exception>
+#include <new>
+
+namespace {
+
+// Mirrors HitRecord, in native alignment
+const char* const kHitFormat =
+  "T{d:x:d:y:d:z:d:energy:d:primaryEnergy:d:weight:i:event:i:layer:}";
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+// pinhole.HitView: read-only buffer over one run's hits
+
+struct HitView
+{
+  PyObject_HEAD
+  PinholeSimulation::HitBufferPtr* hits;
+  Py_ssize_t shape;
+  Py_ssize_t stride;
+};
+
+void HitView_dealloc(HitView* self)
+{
+  delete self->hits;
+  Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+Py_ssize_t HitView_len(HitView* self)
+{
+  return self->shape;
+}
+
+int HitView_getbuffer(HitView* self, Py_buffer* view, int flags)
+{
+  if ( flags & PyBUF_WRITABLE ) {
+    PyErr_SetString(PyExc_BufferError, "hit view is read-only");
+    return -1;
+  }
+  const PinholeSimulation::HitBuffer& hits = **self->hits;
+  view->buf = hits.empty() ? 0 : const_cast<HitRecord*>(hits.data());
+  view->obj = reinterpret_cast<PyObject*>(self);
+  Py_INCREF(self);
+  view->len = self->shape * self->stride;
+  view->readonly = 1;
+  view->itemsize = self->stride;
+  view->format = (flags & PyBUF_FORMAT) ? const_cast<char*>(kHitFormat) : 0;
+  view->ndim = 1;
+  view->shape = (flags & PyBUF_ND) ? &self->shape : 0;
+  view->strides = ((flags & PyBUF_STRIDES) == PyBUF_STRIDES)
+                ? &self->stride : 0;
+  view->suboffsets = 0;
+  view->internal = 0;
+  return 0;
+}
+
+PySequenceMethods HitView_sequence = {
+  reinterpret_cast<lenfunc>(HitView_len)
+};
+
+PyBufferProcs HitView_buffer = {
+  reinterpret_cast<getbufferproc>(HitView_getbuffer),
+  0
+};
+
+PyTypeObject HitViewType = { PyVarObject_HEAD_INIT(0, 0) };
+
+PyObject* NewHitView(const PinholeSimulation::HitBufferPtr& hits)
+{
+  HitView* self = PyObject_New(HitView, &HitViewType);
+  if ( !self ) return 0;
+  self->hits = new PinholeSimulation::HitBufferPtr(
+    hits ? hits : std::make_shared<const PinholeSimulation::HitBuffer>());
+  self->shape = static_cast<Py_ssize_t>((*self->hits)->size());
+  self->stride = static_cast<Py_ssize_t>(sizeof(HitRecord));
+  return reinterpret_cast<PyObject*>(self);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+// pinhole.Simulation
+
+struct Simulation
+{
+  PyObject_HEAD
+  PinholeSimulation* simulation;
+};
+
+// Fatal G4Exceptions still abort the process; C++ exceptions are raised
+// as Python exceptions
+template <typename Op>
+PyObject* Call(Simulation* self, Op op)
+{
+  if ( !self->simulation ) {
+    PyErr_SetString(PyExc_RuntimeError, "simulation is not constructed");
+    return 0;
+  }
+  try {
+    return op(self->simulation);
+  }
+  catch ( const std::bad_alloc& ) {
+    return PyErr_NoMemory();
+  }
+  catch ( const std::exception& e ) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return 0;
+  }
+}
+
+PyObject* SummaryDict(const PinholeSimulation::Summary& summary)
+{
+  PyObject* dict = Py_BuildValue(
+    "{s:i,s:i,s:i,s:n,s:d}",
+    "run", summary.runID,
+    "events", summary.events,
+    "accepted_events", summary.acceptedEvents,
+    "hits", static_cast<Py_ssize_t>(summary.hits),
+    "seconds", summary.seconds);
+  if ( !dict || !summary.hasEstimate ) return dict;
+
+  PyObject* estimate = Py_BuildValue(
+    "{s:d,s:d,s:d,s:d}",
+    "theta", summary.theta, "theta_error", summary.thetaError,
+    "phi", summary.phi, "phi_error", summary.phiError);
+  if ( !estimate || PyDict_Update(dict, estimate) < 0 ) {
+    Py_XDECREF(estimate);
+    Py_DECREF(dict);
+    return 0;
+  }
+  Py_DECREF(estimate);
+  return dict;
+}
+
+int Simulation_init(Simulation* self, PyObject* args, PyObject* kwds)
+{
+  static const char* keywords[] = { "threads", 0 };
+  int threads = 4;
+  if ( !PyArg_ParseTupleAndKeywords(args, kwds, "|i",
+                                    const_cast<char**>(keywords), &threads) )
+    return -1;
+  if ( self->simulation ) {
+    PyErr_SetString(PyExc_RuntimeError, "simulation already constructed");
+    return -1;
+  }
+  if ( PinholeSimulation::Instance() ) {
+    PyErr_SetString(PyExc_RuntimeError,
+                    "only one Simulation per process (Geant4 run manager)");
+    return -1;
+  }
+  if ( threads < 1 ) {
+    PyErr_SetString(PyExc_ValueError, "threads must be at least 1");
+    return -1;
+  }
+  try {
+    self->simulation = new PinholeSimulation(threads);
+  }
+  catch ( const std::exception& e ) {
+    PyErr_SetString(PyExc_RuntimeError, e.what());
+    return -1;
+  }
+  return 0;
+}
+
+void Simulation_dealloc(Simulation* self)
+{
+  delete self->simulation;
+  Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+PyObject* Simulation_execute(Simulation* self, PyObject* args)
+{
+  const char* command;
+  if ( !PyArg_ParseTuple(args, "s", &command) ) return 0;
+  return Call(self, [command](PinholeSimulation* simulation) {
+    return PyLong_FromLong(simulation->Execute(command));
+  });
+}
+
+PyObject* Simulation_set_geometry_file(Simulation* self, PyObject* args)
+{
+  const char* fileName;
+  if ( !PyArg_ParseTuple(args, "s", &fileName) ) return 0;
+  return Call(self, [fileName](PinholeSimulation* simulation) {
+    simulation->SetGeometryFile(fileName);
+    Py_RETURN_NONE;
+  });
+}
+
+PyObject* Simulation_keep_hits(Simulation* self, PyObject* args)
+{
+  int keep;
+  if ( !PyArg_ParseTuple(args, "p", &keep) ) return 0;
+  return Call(self, [keep](PinholeSimulation* simulation) {
+    simulation->SetKeepHits(keep != 0);
+    Py_RETURN_NONE;
+  });
+}
+
+PyObject* Simulation_file_output(Simulation* self, PyObject* args)
+{
+  int write;
+  if ( !PyArg_ParseTuple(args, "p", &write) ) return 0;
+  return Call(self, [write](PinholeSimulation* simulation) {
+    simulation->SetFileOutput(write != 0);
+    Py_RETURN_NONE;
+  });
+}
+
+PyObject* Simulation_initialize(Simulation* self, PyObject*)
+{
+  return Call(self, [](PinholeSimulation* simulation) {
+    simulation->Initialize();
+    Py_RETURN_NONE;
+  });
+}
+
+PyObject* Simulation_beam_on(Simulation* self, PyObject* args)
+{
+  int nEvents;
+  if ( !PyArg_ParseTuple(args, "i", &nEvents) ) return 0;
+  if ( nEvents < 0 ) {
+    PyErr_SetString(PyExc_ValueError, "number of events is negative");
+    return 0;
+  }
+  return Call(self, [nEvents](PinholeSimulation* simulation) {
+    return SummaryDict(simulation->BeamOn(nEvents));
+  });
+}
+
+PyObject* Simulation_summary(Simulation* self, PyObject*)
+{
+  return Call(self, [](PinholeSimulation* simulation) {
+    return SummaryDict(simulation->GetSummary());
+  });
+}
+
+PyObject* Simulation_hits(Simulation* self, PyObject*)
+{
+  return Call(self, [](PinholeSimulation* simulation) {
+    return NewHitView(simulation->GetHits());
+  });
+}
+
+PyMethodDef Simulation_methods[] = {
+  { "execute", reinterpret_cast<PyCFunction>(Simulation_execute),
+    METH_VARARGS, "execute(command) -> UI status, 0 on success" },
+  { "set_geometry_file",
+    reinterpret_cast<PyCFunction>(Simulation_set_geometry_file),
+    METH_VARARGS, "set_geometry_file(path): rebuilt before the next run" },
+  { "keep_hits", reinterpret_cast<PyCFunction>(Simulation_keep_hits),
+    METH_VARARGS, "keep_hits(bool): collect hits in memory" },
+  { "file_output", reinterpret_cast<PyCFunction>(Simulation_file_output),
+    METH_VARARGS, "file_output(bool): write the CSV files" },
+  { "initialize", reinterpret_cast<PyCFunction>(Simulation_initialize),
+    METH_NOARGS, "initialize(): done by the first beam_on otherwise" },
+  { "beam_on", reinterpret_cast<PyCFunction>(Simulation_beam_on),
+    METH_VARARGS, "beam_on(events) -> run summary dict" },
+  { "summary", reinterpret_cast<PyCFunction>(Simulation_summary),
+    METH_NOARGS, "summary() -> summary dict of the last run" },
+  { "hits", reinterpret_cast<PyCFunction>(Simulation_hits),
+    METH_NOARGS, "hits() -> buffer of the last run's hits, for np.asarray" },
+  { 0, 0, 0, 0 }
+};
+
+PyTypeObject SimulationType = { PyVarObject_HEAD_INIT(0, 0) };
+
+PyModuleDef PinholeModule = {
+  PyModuleDef_HEAD_INIT, "pinhole",
+  "In-process driver of the pinhole detector simulation", -1,
+  0, 0, 0, 0, 0
+};
+
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PyMODINIT_FUNC PyInit_pinhole()
+{
+  HitViewType.tp_name = "pinhole.HitView";
+  HitViewType.tp_basicsize = sizeof(HitView);
+  HitViewType.tp_flags = Py_TPFLAGS_DEFAULT;
+  HitViewType.tp_doc = "Read-only buffer of one run's hits";
+  HitViewType.tp_dealloc = reinterpret_cast<destructor>(HitView_dealloc);
+  HitViewType.tp_as_sequence = &HitView_sequence;
+  HitViewType.tp_as_buffer = &HitView_buffer;
+
+  SimulationType.tp_name = "pinhole.Simulation";
+  SimulationType.tp_basicsize = sizeof(Simulation);
+  SimulationType.tp_flags = Py_TPFLAGS_DEFAULT;
+  SimulationType.tp_doc = "Simulation(threads=4)";
+  SimulationType.tp_new = PyType_GenericNew;
+  SimulationType.tp_init = reinterpret_cast<initproc>(Simulation_init);
+  SimulationType.tp_dealloc = reinterpret_cast<destructor>(Simulation_dealloc);
+  SimulationType.tp_methods = Simulation_methods;
+
+  if ( PyType_Ready(&HitViewType) < 0 ) return 0;
+  if ( PyType_Ready(&SimulationType) < 0 ) return 0;
+
+  PyObject* module = PyModule_Create(&PinholeModule);
+  if ( !module ) return 0;
+
+  Py_INCREF(&SimulationType);
+  if ( PyModule_AddObject(module, "Simulation",
+                          reinterpret_cast<PyObject*>(&SimulationType)) < 0 ) {
+    Py_DECREF(&SimulationType);
+    Py_DECREF(module);
+    return 0;
+  }
+  Py_INCREF(&HitViewType);
+  PyModule_AddObject(module, "HitView",
+                     reinterpret_cast<PyObject*>(&HitViewType));
+  PyModule_AddIntConstant(module, "hit_record_size", sizeof(HitRecord));
+  return module;
+}
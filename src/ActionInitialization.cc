@@ -33,6 +33,7 @@
 #include "RunAction.hh"
 #include "EventAction.hh"
 #include "SteppingAction.hh"
+#include "TrackingAction.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -60,12 +61,13 @@ void ActionInitialization::Build() const
   SetUserAction(new PrimaryGeneratorAction);
 
   RunAction* runAction = new RunAction;
-  SetUserAction(new RunAction);
+  SetUserAction(runAction);
   
   EventAction* eventAction = new EventAction(runAction);
   SetUserAction(eventAction);
   
   SetUserAction(new SteppingAction(eventAction));
+  SetUserAction(new TrackingAction(eventAction));
 }  
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,237 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file AngleEstimator.cc
+/// \brief Implementation of the AngleEstimator class
+
+#include "AngleEstimator.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+#include <sstream>
+
+namespace
+{
+  // Angles span at most +-90 deg
+  const double kSketchMin = -90.;
+  const double kSketchMax =  90.;
+
+  const double kRadToDeg = 180./3.14159265358979323846;
+
+  // Asymptotic std error of a normal median over that of the mean,
+  // sqrt(pi/2); sigmaG stands in for the standard deviation
+  const double kMedianError = 1.2533141373155003;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+AngleEstimator::AngleEstimator(double gap, double sketchWidth)
+: fGap(gap),
+  fCoMoment(0.),
+  fThetaSketch(kSketchMin, kSketchMax, sketchWidth),
+  fPhiSketch(kSketchMin, kSketchMax, sketchWidth),
+  fSumSketch(2.*kSketchMin, 2.*kSketchMax, sketchWidth),
+  fDiffSketch(2.*kSketchMin, 2.*kSketchMax, sketchWidth)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AngleEstimator::AddAngles(double theta, double phi)
+{
+  // Co-moment update needs the theta mean before and the phi mean after
+  double dTheta = theta - fTheta.GetMean();
+  fTheta.Add(theta);
+  fPhi.Add(phi);
+  fCoMoment += dTheta*(phi - fPhi.GetMean());
+
+  fThetaSketch.Add(theta);
+  fPhiSketch.Add(phi);
+  fSumSketch.Add(theta + phi);
+  fDiffSketch.Add(theta - phi);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AngleEstimator::Merge(const AngleEstimator& other)
+{
+  long na = fTheta.GetEntries();
+  long nb = other.fTheta.GetEntries();
+  if (na > 0 && nb > 0) {
+    double dTheta = other.fTheta.GetMean() - fTheta.GetMean();
+    double dPhi   = other.fPhi.GetMean() - fPhi.GetMean();
+    fCoMoment += other.fCoMoment + dTheta*dPhi*double(na)*double(nb)/(na + nb);
+  }
+  else if (nb > 0) {
+    fCoMoment = other.fCoMoment;
+  }
+
+  fTheta.Merge(other.fTheta);
+  fPhi.Merge(other.fPhi);
+  fThetaSketch.Merge(other.fThetaSketch);
+  fPhiSketch.Merge(other.fPhiSketch);
+  fSumSketch.Merge(other.fSumSketch);
+  fDiffSketch.Merge(other.fDiffSketch);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AngleEstimator::Reset()
+{
+  fTheta.Reset();
+  fPhi.Reset();
+  fCoMoment = 0.;
+  fThetaSketch.Reset();
+  fPhiSketch.Reset();
+  fSumSketch.Reset();
+  fDiffSketch.Reset();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AngleEstimator::Write(std::ostream& out) const
+{
+  fTheta.Write(out);
+  fPhi.Write(out);
+  out.write(reinterpret_cast<const char*>(&fCoMoment), sizeof(fCoMoment));
+  fThetaSketch.Write(out);
+  fPhiSketch.Write(out);
+  fSumSketch.Write(out);
+  fDiffSketch.Write(out);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool AngleEstimator::Read(std::istream& in)
+{
+  if (!fTheta.Read(in) || !fPhi.Read(in)) return false;
+  in.read(reinterpret_cast<char*>(&fCoMoment), sizeof(fCoMoment));
+  return fThetaSketch.Read(in) && fPhiSketch.Read(in)
+      && fSumSketch.Read(in) && fDiffSketch.Read(in);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double AngleEstimator::GetCorrelation() const
+{
+  long n = fTheta.GetEntries();
+  double norm = fTheta.GetStdDev()*fPhi.GetStdDev()*n;
+  return norm > 0. ? fCoMoment/norm : 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void AngleEstimator::GetNormFit(double& sigma1, double& sigma2,
+                                double& alpha) const
+{
+  double sigmaTheta = GetThetaSigmaG();
+  double sigmaPhi   = GetPhiSigmaG();
+
+  // Var(theta + phi) - Var(theta - phi) = 4 Cov(theta, phi)
+  double sumG  = fSumSketch.SigmaG();
+  double diffG = fDiffSketch.SigmaG();
+  double cov   = 0.25*(sumG*sumG - diffG*diffG);
+  double bound = sigmaTheta*sigmaPhi;
+  if (cov >  bound) cov =  bound;
+  if (cov < -bound) cov = -bound;
+
+  double varTheta = sigmaTheta*sigmaTheta;
+  double varPhi   = sigmaPhi*sigmaPhi;
+  double mean     = 0.5*(varTheta + varPhi);
+  double half     = 0.5*(varTheta - varPhi);
+  double split    = std::sqrt(half*half + cov*cov);
+
+  sigma1 = std::sqrt(mean + split);
+  sigma2 = std::sqrt(std::max(mean - split, 0.));
+  alpha  = 0.5*std::atan2(2.*cov, varTheta - varPhi)*kRadToDeg;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double AngleEstimator::GetThetaStdError() const
+{
+  long n = fTheta.GetEntries();
+  return n > 1 ? fTheta.GetStdDev()/std::sqrt(double(n)) : 1.e30;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double AngleEstimator::GetPhiStdError() const
+{
+  long n = fPhi.GetEntries();
+  return n > 1 ? fPhi.GetStdDev()/std::sqrt(double(n)) : 1.e30;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double AngleEstimator::GetThetaMedianError() const
+{
+  long n = fTheta.GetEntries();
+  return n > 1 ? kMedianError*GetThetaSigmaG()/std::sqrt(double(n)) : 1.e30;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double AngleEstimator::GetPhiMedianError() const
+{
+  long n = fPhi.GetEntries();
+  return n > 1 ? kMedianError*GetPhiSigmaG()/std::sqrt(double(n)) : 1.e30;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::string AngleEstimator::Header()
+{
+  return "Number_Particles,Theta_actual,Phi_actual,Theta_mean,Theta_std,"
+         "Phi_mean,Phi_std,Theta_median,Phi_median,Theta_normfit,T_s_nf,"
+         "Phi_normfit,P_s_nf";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::string AngleEstimator::FormatRow(long nParticles, double thetaActual,
+                                      double phiActual) const
+{
+  double sigma1, sigma2, alpha;
+  GetNormFit(sigma1, sigma2, alpha);
+  // sigma1 lies along alpha in [-90, 90]; it is the theta width when
+  // alpha is within 45 deg of the theta axis
+  double thetaWidth = std::abs(alpha) <= 45. ? sigma1 : sigma2;
+  double phiWidth   = std::abs(alpha) <= 45. ? sigma2 : sigma1;
+
+  std::ostringstream os;
+  os << nParticles << std::fixed << std::setprecision(4)
+     << "," << thetaActual << "," << phiActual
+     << "," << fTheta.GetMean() << "," << fTheta.GetStdDev()
+     << "," << fPhi.GetMean() << "," << fPhi.GetStdDev()
+     << "," << GetThetaMedian() << "," << GetPhiMedian()
+     << "," << GetThetaMedian() << "," << thetaWidth
+     << "," << GetPhiMedian() << "," << phiWidth;
+  return os.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
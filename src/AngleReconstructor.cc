@@ -0,0 +1,316 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file AngleReconstructor.cc
+/// \brief Implementation of the AngleReconstructor class
+
+#include "AngleReconstructor.hh"
+#include "ResponseLibrary.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+  // Branch-free natural log for positive normal numbers, relative error
+  // below 1e-11, written so that the compiler can vectorise loops over it
+  inline double FastLog(double x)
+  {
+    const double kSqrt2 = 1.4142135623730951;
+    const double kLn2   = 0.6931471805599453;
+
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+
+    // Exponent through the 2^52 trick, mantissa rescaled to [1, 2)
+    uint64_t exponentBits = (bits >> 52) | 0x4330000000000000ULL;
+    double exponent;
+    std::memcpy(&exponent, &exponentBits, sizeof(exponent));
+    exponent -= 4503599627370496. + 1023.;
+
+    uint64_t mantissaBits = (bits & 0x000FFFFFFFFFFFFFULL)
+                            | 0x3FF0000000000000ULL;
+    double m;
+    std::memcpy(&m, &mantissaBits, sizeof(m));
+
+    // Centre the mantissa on 1 so that the series converges fast
+    double big = m > kSqrt2 ? 1. : 0.;
+    m *= 1. - 0.5*big;
+    exponent += big;
+
+    double s  = (m - 1.)/(m + 1.);
+    double s2 = s*s;
+    double series = 1. + s2*(1./3. + s2*(1./5. + s2*(1./7. + s2*(1./9.
+                  + s2*(1./11. + s2*(1./13.))))));
+    return 2.*s*series + exponent*kLn2;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+AngleReconstructor::AngleReconstructor(const ResponseLibrary& library,
+                                       double energy)
+: fThetas(library.GetThetas()),
+  fPhis(library.GetPhis()),
+  fPixels(library.GetNx()*library.GetNz()),
+  fTolerance(0.01),
+  fFloor(0.)
+{
+  // Collapse the energy axis once, the fit only varies the angles
+  std::size_t nNodes = fThetas.size()*fPhis.size();
+  fTemplates.assign(nNodes*fPixels, 0.f);
+  fTotals.assign(nNodes, 0.);
+
+  std::vector<double> buffer(fPixels);
+  double smallest = std::numeric_limits<double>::max();
+  for (std::size_t it = 0; it < fThetas.size(); it++) {
+    for (std::size_t ip = 0; ip < fPhis.size(); ip++) {
+      std::fill(buffer.begin(), buffer.end(), 0.);
+      library.Accumulate(fThetas[it], fPhis[ip], energy, 1., &buffer[0]);
+
+      std::size_t node = it*fPhis.size() + ip;
+      float* tmpl = &fTemplates[node*fPixels];
+      double total = 0.;
+      for (int i = 0; i < fPixels; i++) {
+        tmpl[i] = float(buffer[i]);
+        total += buffer[i];
+        if (buffer[i] > 0. && buffer[i] < smallest) smallest = buffer[i];
+      }
+      fTotals[node] = total;
+    }
+  }
+
+  // Pixels a template never reached still get a finite probability,
+  // well below one simulated hit
+  fFloor = smallest < std::numeric_limits<double>::max() ? 0.01*smallest
+                                                         : 1.e-12;
+
+  fLogTemplates.resize(fTemplates.size());
+  for (std::size_t i = 0; i < fTemplates.size(); i++) {
+    fLogTemplates[i] = float(std::log(std::max(double(fTemplates[i]), fFloor)));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double AngleReconstructor::NodeLogLikelihood(int iTheta, int iPhi,
+                                             const Observed& observed) const
+{
+  std::size_t node = std::size_t(iTheta)*fPhis.size() + iPhi;
+  const float* logTmpl = &fLogTemplates[node*fPixels];
+  double total = fTotals[node];
+  if (total <= 0.) return -std::numeric_limits<double>::max();
+
+  const int*    pixels = &observed.pixels[0];
+  const double* counts = &observed.counts[0];
+  std::size_t n = observed.pixels.size();
+
+  double sum = 0.;
+  for (std::size_t k = 0; k < n; k++) sum += counts[k]*logTmpl[pixels[k]];
+  double N = observed.total;
+  return sum + N*std::log(N/total) - N;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double AngleReconstructor::LogLikelihood(double theta, double phi,
+                                         const Observed& observed,
+                                         std::vector<double>& scratch) const
+{
+  int it, ip;
+  double ft, fp;
+  ResponseLibrary::Locate(fThetas, theta, it, ft);
+  ResponseLibrary::Locate(fPhis, phi, ip, fp);
+
+  // Up to four bilinear corners, degenerate axes have a single node
+  const float* corner[4];
+  double weight[4];
+  int nCorners = 0;
+  double total = 0.;
+  for (int dt = 0; dt < 2; dt++) {
+    double wt = dt ? ft : 1. - ft;
+    if (wt == 0. || it + dt >= int(fThetas.size())) continue;
+    for (int dp = 0; dp < 2; dp++) {
+      double wp = dp ? fp : 1. - fp;
+      if (wp == 0. || ip + dp >= int(fPhis.size())) continue;
+      std::size_t node = std::size_t(it + dt)*fPhis.size() + ip + dp;
+      corner[nCorners] = &fTemplates[node*fPixels];
+      weight[nCorners] = wt*wp;
+      total += wt*wp*fTotals[node];
+      nCorners++;
+    }
+  }
+  if (total <= 0.) return -std::numeric_limits<double>::max();
+
+  const int*    pixels = &observed.pixels[0];
+  const double* counts = &observed.counts[0];
+  std::size_t n = observed.pixels.size();
+
+  // Gather the interpolated template first, then a straight log-sum loop
+  scratch.resize(n);
+  double* t = &scratch[0];
+  for (std::size_t k = 0; k < n; k++) t[k] = weight[0]*corner[0][pixels[k]];
+  for (int c = 1; c < nCorners; c++) {
+    const float* tmpl = corner[c];
+    double w = weight[c];
+    for (std::size_t k = 0; k < n; k++) t[k] += w*tmpl[pixels[k]];
+  }
+
+  double sum = 0.;
+  for (std::size_t k = 0; k < n; k++) {
+    sum += counts[k]*FastLog(std::max(t[k], fFloor));
+  }
+  double N = observed.total;
+  return sum + N*std::log(N/total) - N;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+AngleReconstructor::Result AngleReconstructor::Fit(const double* image) const
+{
+  Result result;
+  result.theta = result.phi = std::numeric_limits<double>::quiet_NaN();
+  result.sigmaTheta = result.sigmaPhi = result.theta;
+  result.logLikelihood = result.theta;
+  result.evaluations = 0;
+
+  Observed observed;
+  observed.total = 0.;
+  for (int i = 0; i < fPixels; i++) {
+    if (image[i] > 0.) {
+      observed.pixels.push_back(i);
+      observed.counts.push_back(image[i]);
+      observed.total += image[i];
+    }
+  }
+  result.counts = observed.total;
+  if (observed.total <= 0. || fThetas.empty() || fPhis.empty()) return result;
+
+  // Coarse: every other library node, then the neighbours of the best one
+  int nTheta = int(fThetas.size());
+  int nPhi   = int(fPhis.size());
+  int strideTheta = nTheta > 4 ? 2 : 1;
+  int stridePhi   = nPhi > 4 ? 2 : 1;
+
+  double best = -std::numeric_limits<double>::max();
+  int bestTheta = 0, bestPhi = 0;
+  for (int it = 0; it < nTheta; it += strideTheta) {
+    for (int ip = 0; ip < nPhi; ip += stridePhi) {
+      double value = NodeLogLikelihood(it, ip, observed);
+      result.evaluations++;
+      if (value > best) {
+        best = value;
+        bestTheta = it;
+        bestPhi = ip;
+      }
+    }
+  }
+
+  int centreTheta = bestTheta, centrePhi = bestPhi;
+  for (int it = centreTheta - 1; it <= centreTheta + 1; it++) {
+    for (int ip = centrePhi - 1; ip <= centrePhi + 1; ip++) {
+      if (it < 0 || it >= nTheta || ip < 0 || ip >= nPhi) continue;
+      if ((it - centreTheta) % strideTheta == 0
+          && (ip - centrePhi) % stridePhi == 0) continue;
+      double value = NodeLogLikelihood(it, ip, observed);
+      result.evaluations++;
+      if (value > best) {
+        best = value;
+        bestTheta = it;
+        bestPhi = ip;
+      }
+    }
+  }
+
+  // Fine: 3x3 pattern starting at half a node spacing, halved down to the
+  // tolerance
+  std::vector<double> scratch;
+  double theta = fThetas[bestTheta];
+  double phi   = fPhis[bestPhi];
+
+  double stepTheta = 0., stepPhi = 0.;
+  if (nTheta > 1) {
+    int next = bestTheta + 1 < nTheta ? bestTheta + 1 : bestTheta - 1;
+    stepTheta = 0.5*std::abs(fThetas[next] - fThetas[bestTheta]);
+  }
+  if (nPhi > 1) {
+    int next = bestPhi + 1 < nPhi ? bestPhi + 1 : bestPhi - 1;
+    stepPhi = 0.5*std::abs(fPhis[next] - fPhis[bestPhi]);
+  }
+
+  while (stepTheta > fTolerance || stepPhi > fTolerance) {
+    double startTheta = theta, startPhi = phi;
+    for (int i = -1; i <= 1; i++) {
+      if (stepTheta == 0. && i != 0) continue;
+      double t = startTheta + i*stepTheta;
+      if (t < fThetas.front() || t > fThetas.back()) continue;
+      for (int j = -1; j <= 1; j++) {
+        if (stepPhi == 0. && j != 0) continue;
+        if (i == 0 && j == 0) continue;
+        double p = startPhi + j*stepPhi;
+        if (p < fPhis.front() || p > fPhis.back()) continue;
+
+        double value = LogLikelihood(t, p, observed, scratch);
+        result.evaluations++;
+        if (value > best) {
+          best = value;
+          theta = t;
+          phi = p;
+        }
+      }
+    }
+    stepTheta *= 0.5;
+    stepPhi   *= 0.5;
+  }
+
+  result.theta = theta;
+  result.phi   = phi;
+  result.logLikelihood = best;
+
+  // Curvature of ln L; a step of a few tolerances keeps it above the
+  // interpolation noise
+  double h = std::max(4.*fTolerance, 1.e-3);
+  if (nTheta > 1) {
+    double up   = LogLikelihood(theta + h, phi, observed, scratch);
+    double down = LogLikelihood(theta - h, phi, observed, scratch);
+    double curvature = (up + down - 2.*best)/(h*h);
+    result.evaluations += 2;
+    if (curvature < 0.) result.sigmaTheta = 1./std::sqrt(-curvature);
+  }
+  if (nPhi > 1) {
+    double up   = LogLikelihood(theta, phi + h, observed, scratch);
+    double down = LogLikelihood(theta, phi - h, observed, scratch);
+    double curvature = (up + down - 2.*best)/(h*h);
+    result.evaluations += 2;
+    if (curvature < 0.) result.sigmaPhi = 1./std::sqrt(-curvature);
+  }
+
+  return result;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,409 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file CheckpointManager.cc
+/// \brief Implementation of the CheckpointManager class
+
+#include "CheckpointManager.hh"
+#include "CheckpointMessenger.hh"
+#include "Run.hh"
+#include "RunAction.hh"
+#include "AngleEstimator.hh"
+#include "OutputManager.hh"
+#include "Telemetry.hh"
+
+#include "G4RunManager.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+CheckpointManager* CheckpointManager::fgInstance = 0;
+
+namespace
+{
+  long FileSize(const G4String& fileName)
+  {
+    struct stat info;
+    return stat(fileName.c_str(), &info) == 0 ? long(info.st_size) : 0;
+  }
+
+  G4bool FileExists(const G4String& fileName)
+  {
+    struct stat info;
+    return stat(fileName.c_str(), &info) == 0;
+  }
+
+  G4double WallSeconds()
+  {
+    timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec + 1.e-6*now.tv_usec;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CheckpointManager* CheckpointManager::Instance()
+{
+  if (!fgInstance) fgInstance = new CheckpointManager();
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CheckpointManager::CheckpointManager()
+: fMessenger(0),
+  fChunkSize(1000000),
+  fInterval(0.),
+  fFileName("../analysis/checkpoint/checkpoint.txt"),
+  fResume(false),
+  fRunning(false),
+  fTargetError(0.),
+  fTotal(0),
+  fFirstRunID(-1),
+  fJob(0),
+  fResumeJob(-1),
+  fResumeTotal(0),
+  fResumeTargetError(0.),
+  fResumeDone(0),
+  fResumeFirstRunID(-1)
+{
+  fMessenger = new CheckpointMessenger(this);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CheckpointManager::~CheckpointManager()
+{
+  delete fTotal;
+  delete fMessenger;
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CheckpointManager::BeamOn(G4int nEvents, G4double targetError)
+{
+  if (fRunning) return;
+  fJob++;
+  fTargetError = targetError;
+
+  if (fResume && fResumeJob < 0 && !ReadCheckpoint()) {
+    G4cout << "CheckpointManager: no checkpoint in " << fFileName
+           << ", starting from the beginning" << G4endl;
+    fResume = false;
+  }
+
+  // Jobs of the macro that had finished before the interruption
+  if (fResume && (fJob < fResumeJob
+                  || (fJob == fResumeJob && fResumeDone >= fResumeTotal))) {
+    G4cout << "CheckpointManager: job " << fJob
+           << " was completed before the interruption, skipped" << G4endl;
+    if (fJob == fResumeJob) fResume = false;
+    return;
+  }
+
+  // Job totals, with the readout and estimator settings of this job
+  delete fTotal;
+  fTotal = new Run;
+  fFirstRunID = -1;
+
+  // All chunks write to the run directory of the first one
+  OutputManager* output = OutputManager::Instance();
+  output->HoldRunDirectory(true);
+
+  G4int nDone = 0;
+  if (fResume) {
+    fResume = false;
+    if (fJob != fResumeJob || fResumeTotal != nEvents
+        || std::abs(fResumeTargetError - targetError) > 1.e-6*targetError) {
+      std::ostringstream message;
+      message << "Checkpoint " << fFileName << " is for job " << fResumeJob
+              << " with " << fResumeTotal << " events and target error "
+              << fResumeTargetError << " deg, the macro asks for job " << fJob
+              << " with " << nEvents << " events and target error "
+              << targetError << " deg.";
+      G4Exception("CheckpointManager::BeamOn()", "Checkpoint001",
+                  FatalException, message.str().c_str());
+      output->HoldRunDirectory(false);
+      return;
+    }
+    Restore();
+    nDone = fResumeDone;
+    G4cout << "CheckpointManager: job " << fJob << " resumed after " << nDone
+           << " of " << nEvents << " events" << G4endl;
+  }
+  // A crash in the first chunk can be resumed too
+  else if (!Save(nEvents, 0)) {
+    G4cerr << "CheckpointManager: could not write " << fFileName
+           << ", job not started" << G4endl;
+    output->HoldRunDirectory(false);
+    return;
+  }
+
+  G4RunManager* runManager = G4RunManager::GetRunManager();
+  // Every chunk ends in a run barrier, so with an interval each chunk is
+  // sized from the event rate of the last one to last that long. A target
+  // error needs the merged estimator, i.e. a barrier, every fChunkSize
+  // events; checkpoints then follow the interval between those barriers.
+  G4bool sized = fInterval > 0. && targetError <= 0.;
+  G4double rate = 0.;
+  G4double lastCheckpoint = WallSeconds();
+  Telemetry* telemetry = Telemetry::Instance();
+  fRunning = true;
+
+  while (nDone < nEvents) {
+    G4double wanted = fChunkSize;
+    if (sized) wanted = std::max(wanted, rate*fInterval);
+    G4int chunk  = G4int(std::min(wanted, G4double(nEvents - nDone)));
+    G4int before = fTotal->GetNumberOfEvent();
+    G4double start = WallSeconds();
+    telemetry->SetJob(nEvents, nDone);
+    runManager->BeamOn(chunk);
+    G4double elapsed = WallSeconds() - start;
+    if (elapsed > 0.) rate = chunk/elapsed;
+
+    // An aborted chunk leaves the last checkpoint as the restart point
+    if (fTotal->GetNumberOfEvent() - before != chunk) {
+      G4cerr << "CheckpointManager: chunk did not complete, job stopped"
+             << " after " << nDone << " events" << G4endl;
+      telemetry->EndJob();
+      fRunning = false;
+      output->HoldRunDirectory(false);
+      return;
+    }
+    nDone += chunk;
+
+    if (targetError > 0. && nDone < nEvents && Converged()) {
+      G4cout << "CheckpointManager: target error of " << targetError
+             << " deg reached after " << nDone << " of " << nEvents
+             << " events" << G4endl;
+      break;
+    }
+
+    if (nDone < nEvents
+        && (sized || fInterval <= 0.
+            || WallSeconds() - lastCheckpoint >= fInterval)) {
+      if (!Save(nEvents, nDone)) {
+        G4cerr << "CheckpointManager: could not write " << fFileName
+               << G4endl;
+      }
+      lastCheckpoint = WallSeconds();
+    }
+  }
+
+  telemetry->EndJob();
+  fRunning = false;
+
+  // Job outputs, as a single run of nEvents would have written them
+  if (fTotal->GetImage()) RunAction::WriteImage(*fTotal->GetImage(), fFirstRunID);
+  if (fTotal->GetEstimator()) {
+    RunAction::WriteResults(*fTotal->GetEstimator(),
+                            fTotal->GetSourceDirection(),
+                            fTotal->GetNumberOfEvent());
+  }
+
+  // Marks the job complete, so that a resume does not write them again
+  Save(nEvents, nEvents);
+  output->HoldRunDirectory(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CheckpointManager::Converged() const
+{
+  // The standard error of a handful of hits is itself too noisy to trust
+  const long kMinHits = 100;
+
+  const AngleEstimator* estimator = fTotal->GetEstimator();
+  if (!estimator || estimator->GetEntries() < kMinHits) return false;
+
+  G4double thetaError = estimator->GetThetaStdError();
+  G4double phiError   = estimator->GetPhiStdError();
+  G4cout << "CheckpointManager: " << fTotal->GetNumberOfEvent()
+         << " events, " << estimator->GetEntries() << " hits, standard error"
+         << " theta " << thetaError << " phi " << phiError << " deg" << G4endl;
+  return thetaError <= fTargetError && phiError <= fTargetError;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CheckpointManager::Collect(const Run* run)
+{
+  if (!fRunning || !fTotal) return;
+  if (fFirstRunID < 0) fFirstRunID = run->GetRunID();
+  fTotal->Merge(run);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CheckpointManager::Save(G4int nEvents, G4int nDone)
+{
+  size_t slash = fFileName.rfind('/');
+  if (slash != std::string::npos) {
+    mkdir(fFileName.substr(0, slash).c_str(), 0755);
+  }
+
+  // Workers are idle between chunks, the master engine alone seeds them
+  G4String rngFile   = Versioned(nDone, ".rng");
+  G4String stateFile = Versioned(nDone, ".state");
+  G4Random::saveEngineStatus(rngFile.c_str());
+
+  std::ofstream state(stateFile.c_str(), std::ios::binary);
+  fTotal->WriteState(state);
+  state.close();
+  if (!state || !FileExists(rngFile)) return false;
+
+  // The checkpoint only points at complete files once it is renamed
+  G4String temporary = fFileName + ".tmp";
+  std::ofstream out(temporary.c_str());
+  out << "pinhole-checkpoint 1\n"
+      << "job " << fJob << "\n"
+      << "total " << nEvents << "\n"
+      << "target " << fTargetError << "\n"
+      << "done " << nDone << "\n"
+      << "firstRun " << fFirstRunID << "\n"
+      << "rng " << rngFile << "\n"
+      << "state " << stateFile << "\n";
+
+  // Event files as they are now: the shared ones are cut back to these
+  // sizes on resume, own files of a run directory not listed are removed
+  const OutputManager* output = OutputManager::Instance();
+  if (!output->GetHeldDirectory().empty()) {
+    out << "output " << output->GetHeldDirectory() << "\n";
+  }
+  std::vector<std::pair<G4String, long> > files = output->GetCheckpointFiles();
+  for (size_t i = 0; i < files.size(); i++) {
+    out << "file " << files[i].first << " " << files[i].second << "\n";
+  }
+  out.close();
+  if (!out || std::rename(temporary.c_str(), fFileName.c_str()) != 0) {
+    return false;
+  }
+
+  if (fRngFile != rngFile) Remove(fRngFile);
+  if (fStateFile != stateFile) Remove(fStateFile);
+  fRngFile   = rngFile;
+  fStateFile = stateFile;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool CheckpointManager::ReadCheckpoint()
+{
+  std::ifstream in(fFileName.c_str());
+  std::string line, magic;
+  if (!std::getline(in, magic) || magic != "pinhole-checkpoint 1") return false;
+
+  fResumeFiles.clear();
+  fResumeOutput.clear();
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string key;
+    fields >> key;
+    if      (key == "job")      fields >> fResumeJob;
+    else if (key == "total")    fields >> fResumeTotal;
+    else if (key == "target")   fields >> fResumeTargetError;
+    else if (key == "done")     fields >> fResumeDone;
+    else if (key == "firstRun") fields >> fResumeFirstRunID;
+    else if (key == "rng")      fields >> fRngFile;
+    else if (key == "state")    fields >> fStateFile;
+    else if (key == "output")   fields >> fResumeOutput;
+    else if (key == "file") {
+      std::string name;
+      long size = -1;
+      fields >> name >> size;
+      if (size >= 0) fResumeFiles.push_back(std::make_pair(name, size));
+    }
+  }
+  return fResumeJob > 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CheckpointManager::Restore()
+{
+  // Rows written after the checkpoint belong to the lost chunk
+  for (size_t i = 0; i < fResumeFiles.size(); i++) {
+    const G4String& name = fResumeFiles[i].first;
+    long size = fResumeFiles[i].second;
+    if (FileSize(name) < size || truncate(name.c_str(), size) != 0) {
+      G4String message = name + " is shorter than at the checkpoint.";
+      G4Exception("CheckpointManager::Restore()", "Checkpoint002",
+                  FatalException, message.c_str());
+      return;
+    }
+  }
+
+  std::ifstream state(fStateFile.c_str(), std::ios::binary);
+  if (!FileExists(fRngFile) || !fTotal->ReadState(state)) {
+    G4String message = "Cannot restore " + fRngFile + " and " + fStateFile
+                     + " with the readout and estimator settings of this job.";
+    G4Exception("CheckpointManager::Restore()", "Checkpoint003",
+                FatalException, message.c_str());
+    return;
+  }
+
+  G4Random::restoreEngineStatus(fRngFile.c_str());
+  fFirstRunID = fResumeFirstRunID;
+  OutputManager::Instance()->Resume(fResumeOutput, fResumeFiles);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CheckpointManager::Remove(const G4String& fileName) const
+{
+  if (!fileName.empty()) std::remove(fileName.c_str());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String CheckpointManager::Versioned(G4int nDone, const char* extension) const
+{
+  // checkpoint.txt -> checkpoint_<job>_<events done><extension>
+  G4String base = fFileName;
+  size_t slash = base.rfind('/');
+  size_t dot   = base.rfind('.');
+  if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+    base = base.substr(0, dot);
+  }
+
+  std::ostringstream name;
+  name << base << "_" << fJob << "_" << nDone << extension;
+  return name.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,112 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file CheckpointMessenger.cc
+/// \brief Implementation of the CheckpointMessenger class
+
+#include "CheckpointMessenger.hh"
+#include "CheckpointManager.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4SystemOfUnits.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CheckpointMessenger::CheckpointMessenger(CheckpointManager* manager)
+: G4UImessenger(),
+  fManager(manager)
+{
+  fCheckpointDir = new G4UIdirectory("/pinhole/checkpoint/", false);
+  fCheckpointDir->SetGuidance("Checkpointed runs that can be resumed.");
+
+  fBeamOnCmd = new G4UIcmdWithAnInteger("/pinhole/checkpoint/beamOn", this);
+  fBeamOnCmd->SetGuidance("Simulate events in chunks with checkpoints in");
+  fBeamOnCmd->SetGuidance("between. Start main with --resume to continue");
+  fBeamOnCmd->SetGuidance("an interrupted job from its last checkpoint.");
+  fBeamOnCmd->SetParameterName("events", false);
+  fBeamOnCmd->SetRange("events>0");
+  fBeamOnCmd->AvailableForStates(G4State_Idle);
+  fBeamOnCmd->SetToBeBroadcasted(false);
+
+  fEventsCmd = new G4UIcmdWithAnInteger("/pinhole/checkpoint/events", this);
+  fEventsCmd->SetGuidance("Minimum events per chunk, one checkpoint each.");
+  fEventsCmd->SetParameterName("events", false);
+  fEventsCmd->SetRange("events>0");
+  fEventsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fEventsCmd->SetToBeBroadcasted(false);
+
+  fIntervalCmd
+    = new G4UIcmdWithADoubleAndUnit("/pinhole/checkpoint/interval", this);
+  fIntervalCmd->SetGuidance("Time between checkpoints. Chunks are sized from");
+  fIntervalCmd->SetGuidance("the event rate to last this long, as every chunk");
+  fIntervalCmd->SetGuidance("stops the workers. 0 uses chunks of events.");
+  fIntervalCmd->SetParameterName("interval", false);
+  fIntervalCmd->SetRange("interval>=0");
+  fIntervalCmd->SetUnitCategory("Time");
+  fIntervalCmd->SetDefaultUnit("s");
+  fIntervalCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fIntervalCmd->SetToBeBroadcasted(false);
+
+  fFileCmd = new G4UIcmdWithAString("/pinhole/checkpoint/file", this);
+  fFileCmd->SetGuidance("Checkpoint file, the engine status and merged");
+  fFileCmd->SetGuidance("results are written next to it.");
+  fFileCmd->SetParameterName("file", false);
+  fFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fFileCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CheckpointMessenger::~CheckpointMessenger()
+{
+  delete fBeamOnCmd;
+  delete fEventsCmd;
+  delete fIntervalCmd;
+  delete fFileCmd;
+  delete fCheckpointDir;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void CheckpointMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fBeamOnCmd) {
+    fManager->BeamOn(fBeamOnCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fEventsCmd) {
+    fManager->SetChunkSize(fEventsCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fIntervalCmd) {
+    fManager->SetInterval(fIntervalCmd->GetNewDoubleValue(newValue)/s);
+  }
+  else if (command == fFileCmd) {
+    fManager->SetFileName(newValue);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,288 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file CsvReader.cc
+/// \brief Implementation of the CsvReader class
+
+#include "CsvReader.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace
+{
+  // Powers of ten that are exact in a double
+  const double kExactPowers[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const uint64_t kMaxExactMantissa = uint64_t(1) << 53;
+
+  inline bool IsDigit(char c) { return unsigned(c - '0') < 10u; }
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  // SWAR check and conversion of eight ASCII digits held in one word
+  inline bool AreEightDigits(uint64_t chunk)
+  {
+    return ((chunk & 0xF0F0F0F0F0F0F0F0ULL)
+            | (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+           == 0x3333333333333333ULL;
+  }
+
+  inline uint32_t ParseEightDigits(uint64_t chunk)
+  {
+    const uint64_t mask = 0x000000FF000000FFULL;
+    const uint64_t mul1 = 100 + (1000000ULL << 32);
+    const uint64_t mul2 = 1 + (10000ULL << 32);
+    chunk -= 0x3030303030303030ULL;
+    chunk = (chunk*10) + (chunk >> 8);
+    chunk = (((chunk & mask)*mul1) + (((chunk >> 16) & mask)*mul2)) >> 32;
+    return uint32_t(chunk);
+  }
+#define CSVREADER_SWAR 1
+#endif
+
+  // Accumulates digits into mantissa; digits beyond 19 only set overflow
+  inline void ReadDigits(const char*& p, const char* end, uint64_t& mantissa,
+                         int& nDigits, int& nDropped)
+  {
+#ifdef CSVREADER_SWAR
+    while (end - p >= 8 && nDigits + 8 <= 19) {
+      uint64_t chunk;
+      std::memcpy(&chunk, p, 8);
+      if (!AreEightDigits(chunk)) break;
+      mantissa = mantissa*100000000ULL + ParseEightDigits(chunk);
+      nDigits += 8;
+      p += 8;
+    }
+#endif
+    for (; p < end && IsDigit(*p); p++) {
+      if (nDigits < 19) {
+        mantissa = mantissa*10 + unsigned(*p - '0');
+        if (mantissa > 0 || nDigits > 0) nDigits++;
+      }
+      else {
+        nDropped++;
+      }
+    }
+  }
+
+  // Slow path for anything the exact fast path cannot represent
+  bool ParseWithStrtod(const char*& p, const char* end, double& value)
+  {
+    char text[64];
+    std::size_t length = 0;
+    while (p + length < end && length < sizeof(text) - 1
+           && p[length] != ',' && p[length] != '\n' && p[length] != '\r'
+           && p[length] != ' ' && p[length] != '\t') {
+      text[length] = p[length];
+      length++;
+    }
+    text[length] = '\0';
+
+    char* stop = 0;
+    value = std::strtod(text, &stop);
+    if (stop == text) return false;
+    p += stop - text;
+    return true;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CsvReader::CsvReader(const std::string& fileName, std::size_t blockSize)
+: fFile(-1),
+  fBuffer(blockSize),
+  fBegin(0),
+  fEnd(0),
+  fEof(false),
+  fLines(0),
+  fBadLines(0)
+{
+  fFile = (fileName == "-") ? 0 : open(fileName.c_str(), O_RDONLY);
+#ifdef POSIX_FADV_SEQUENTIAL
+  if (fFile > 0) posix_fadvise(fFile, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+CsvReader::~CsvReader()
+{
+  if (fFile > 0) close(fFile);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool CsvReader::FillBuffer()
+{
+  if (fEof) return false;
+
+  // Keep the partial line, grow only if a single line fills the block
+  std::size_t remaining = fEnd - fBegin;
+  if (remaining > 0 && fBegin > 0) {
+    std::memmove(&fBuffer[0], &fBuffer[fBegin], remaining);
+  }
+  fBegin = 0;
+  fEnd   = remaining;
+  if (fEnd == fBuffer.size()) fBuffer.resize(2*fBuffer.size());
+
+  ssize_t nRead;
+  do {
+    nRead = read(fFile, &fBuffer[fEnd], fBuffer.size() - fEnd);
+  } while (nRead < 0 && errno == EINTR);
+
+  if (nRead <= 0) {
+    fEof = true;
+    return false;
+  }
+  fEnd += std::size_t(nRead);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool CsvReader::ParseDouble(const char*& p, const char* end, double& value)
+{
+  const char* start = p;
+  const char* q = p;
+
+  bool negative = false;
+  if (q < end && (*q == '-' || *q == '+')) {
+    negative = (*q == '-');
+    q++;
+  }
+
+  uint64_t mantissa = 0;
+  int nDigits = 0;
+  int nDropped = 0;
+  const char* digitsStart = q;
+  ReadDigits(q, end, mantissa, nDigits, nDropped);
+  int exponent = nDropped;
+
+  if (q < end && *q == '.') {
+    q++;
+    const char* fractionStart = q;
+    int droppedBefore = nDropped;
+    ReadDigits(q, end, mantissa, nDigits, nDropped);
+    // Only digits that made it into the mantissa shift the exponent
+    exponent -= int(q - fractionStart) - (nDropped - droppedBefore);
+  }
+  if (q == digitsStart || (q == digitsStart + 1 && *digitsStart == '.')) {
+    p = start;
+    return ParseWithStrtod(p, end, value);
+  }
+
+  if (q < end && (*q == 'e' || *q == 'E')) {
+    const char* e = q + 1;
+    bool negativeExp = false;
+    if (e < end && (*e == '-' || *e == '+')) {
+      negativeExp = (*e == '-');
+      e++;
+    }
+    if (e == end || !IsDigit(*e)) {
+      p = start;
+      return ParseWithStrtod(p, end, value);
+    }
+    int exp = 0;
+    for (; e < end && IsDigit(*e); e++) {
+      if (exp < 10000) exp = exp*10 + (*e - '0');
+    }
+    exponent += negativeExp ? -exp : exp;
+    q = e;
+  }
+
+  // Clinger's fast path: both operands exact, one correctly rounded op
+  if (nDropped == 0 && mantissa <= kMaxExactMantissa
+      && exponent >= -22 && exponent <= 22) {
+    double result = double(mantissa);
+    if (exponent < 0) result /= kExactPowers[-exponent];
+    else              result *= kExactPowers[exponent];
+    value = negative ? -result : result;
+    p = q;
+    return true;
+  }
+
+  p = start;
+  return ParseWithStrtod(p, end, value);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int CsvReader::ReadLine(double* values, int maxFields)
+{
+  if (!IsOpen()) return -1;
+
+  while (true) {
+    const char* begin = &fBuffer[0] + fBegin;
+    const char* end   = &fBuffer[0] + fEnd;
+    const char* eol   = static_cast<const char*>(
+      std::memchr(begin, '\n', end - begin));
+
+    if (!eol) {
+      if (FillBuffer()) continue;
+      // Last line without a newline
+      if (fBegin == fEnd) return -1;
+      eol = &fBuffer[0] + fEnd;
+      begin = &fBuffer[0] + fBegin;
+    }
+
+    std::size_t next = std::size_t(eol - &fBuffer[0]);
+    fBegin = (next < fEnd) ? next + 1 : fEnd;
+
+    const char* p = begin;
+    const char* lineEnd = eol;
+    if (lineEnd > p && lineEnd[-1] == '\r') lineEnd--;
+    while (p < lineEnd && (*p == ' ' || *p == '\t')) p++;
+    if (p == lineEnd) continue;
+
+    fLines++;
+    int nFields = 0;
+    bool good = true;
+    while (p < lineEnd) {
+      while (p < lineEnd && (*p == ' ' || *p == '\t')) p++;
+      double value;
+      if (!ParseDouble(p, lineEnd, value)) { good = false; break; }
+      if (nFields < maxFields) values[nFields] = value;
+      nFields++;
+      while (p < lineEnd && (*p == ' ' || *p == '\t')) p++;
+      if (p == lineEnd) break;
+      if (*p != ',') { good = false; break; }
+      p++;
+      if (p == lineEnd) { good = false; break; }
+    }
+
+    if (good) return nFields;
+    fBadLines++;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
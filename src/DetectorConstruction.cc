@@ -29,6 +29,9 @@
 /// \brief Implementation of the DetectorConstruction class
 
 #include "DetectorConstruction.hh"
+#include "DetectorMessenger.hh"
+#include "MaskPattern.hh"
+#include "MaskParameterisation.hh"
 
 #include "G4RunManager.hh"
 #include "G4NistManager.hh"
@@ -38,26 +41,59 @@
 #include "G4Orb.hh"
 #include "G4Sphere.hh"
 #include "G4GenericPolycone.hh"
+#include "G4Polycone.hh"
 #include "G4Trd.hh"
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
+#include "G4PVParameterised.hh"
+#include "G4GeometryTolerance.hh"
 #include "G4SystemOfUnits.hh"
 #include "G4IntersectionSolid.hh"
 #include "G4RotationMatrix.hh"
 
+#include <algorithm>
 #include <fstream>
+#include <sstream>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 DetectorConstruction::DetectorConstruction()
 : G4VUserDetectorConstruction(),
-  fScoringVolume(0)
-{ }
+  fScoringVolume(0),
+  fMessenger(0),
+  fConfigFileName("../src/pinhole_config.txt"),
+  fDetectorHalfX(6.3*cm),
+  fDetectorHalfZ(6.3*cm),
+  fPinholeRadius(1.5*mm),
+  fWindowGap(31.5*mm),
+  fWindowThickness(1000.*um),
+  fFoilThickness(10.*um),
+  fReadoutPitch(0.),
+  fMaskType(kPinhole),
+  fMaskRank(41),
+  fMaskPitch(2.5*mm),
+  fApertureRadius(0.),
+  fNumberOfApertures(1),
+  fMaskParameterisation(0)
+{
+  fMessenger = new DetectorMessenger(this);
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 DetectorConstruction::~DetectorConstruction()
-{ }
+{
+  delete fMessenger;
+  delete fMaskParameterisation;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double DetectorConstruction::GetAngleGap() const
+{
+  // window_gap - window_thickness/2 - 0.05 cm, see run_over_angles
+  return fWindowGap - 0.5*fWindowThickness - 0.5*mm;
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -72,9 +108,12 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 
     // Material: Vacuum
     //TODO: check pressures, environment for Van Allen belt altitudes
-  G4Material* vacuum_material = new G4Material("Vacuum",
+  G4Material* vacuum_material = G4Material::GetMaterial("Vacuum", false);
+  if (!vacuum_material) {
+    vacuum_material = new G4Material("Vacuum",
               1.0 , 1.01*g/mole, 1.0E-25*g/cm3,
               kStateGas, 2.73*kelvin, 3.0E-18*pascal );
+  }
 
   // Option to switch on/off checking of volumes overlaps
   //
@@ -130,18 +169,38 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
 
   // Read in configurable dimensions from file
   std::fstream configFile;
-  configFile.open("../src/pinhole_config.txt", std::ios_base::in);
+  configFile.open(fConfigFileName.c_str(), std::ios_base::in);
 
   G4double pinhole_rad_mm, window_gap_mm, window_thickness_um, foil_t_um;
 
   configFile >> pinhole_rad_mm >> window_gap_mm >> window_thickness_um >> foil_t_um;
 
+  // Optional telescope: number of layers, then thickness (um) and spacing
+  // to the previous layer (mm) for each
+  G4int nLayers = 0;
+  std::vector<G4double> layer_thickness_um, layer_spacing_mm;
+  if (configFile >> nLayers) {
+    G4double thickness_um, spacing_mm;
+    for (G4int i = 0; i < nLayers && configFile >> thickness_um >> spacing_mm; i++) {
+      layer_thickness_um.push_back(thickness_um);
+      layer_spacing_mm.push_back(spacing_mm);
+    }
+  }
+  if (nLayers < 1 || G4int(layer_thickness_um.size()) != nLayers) {
+    if (nLayers != 0) {
+      G4Exception("DetectorConstruction::Construct()", "Detector001",
+                  JustWarning, "Incomplete layer list in pinhole_config.txt,"
+                  " using detector1 alone.");
+    }
+    layer_thickness_um.assign(1, 2000.);
+    layer_spacing_mm.assign(1, 0.);
+  }
+
   configFile.close();
 
-  // Dimensions for detectors (detector 1 and 2 use the same planar dimensions)
+  // Dimensions for detectors (all layers use the same planar dimensions)
   G4double detector_dimX = 6.3*cm;
   G4double detector_dimZ = 6.3*cm;
-  G4double detector1_thickness = 1.*mm;
 
   // Window dimensions
   G4double window_thickness = window_thickness_um*um;
@@ -155,57 +214,87 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
   G4double foil_dimX        = 1.*cm;
   G4double foil_dimZ        = 1.*cm;
 
+  fPinholeRadius   = pinhole_radius;
+  fWindowGap       = window_gap;
+  fWindowThickness = window_thickness;
+  fFoilThickness   = foil_thickness;
+
   // ----------------------------------------------------------------
   // Materials for the detectors
   // ----------------------------------------------------------------
 
-  // (Element name, symbol, atomic number, atomic mass) (as floats)
-  G4Element* Si = new G4Element("Silicon","Si", 14., 28.0855*g/mole); // main wafer material for detector
-  //G4Element* S = new G4Element("Sulfer","S", 16., 32.065*g/mole);   // possible doping material
-  G4Element* B = new G4Element("Boron","B", 5., 10.811*g/mole);   // possible doping material
+  // Made once per job; a geometry rebuild finds them in the material table
+  G4Material* DopedSilicon = G4Material::GetMaterial("DopedSilicon", false);
+  if (!DopedSilicon) {
+    // (Element name, symbol, atomic number, atomic mass) (as floats)
+    G4Element* Si = new G4Element("Silicon","Si", 14., 28.0855*g/mole); // main wafer material for detector
+    //G4Element* S = new G4Element("Sulfer","S", 16., 32.065*g/mole);   // possible doping material
+    G4Element* B = new G4Element("Boron","B", 5., 10.811*g/mole);   // possible doping material
 
-  //G4Element* Ga = new G4Element("Gallium","Ga", 31., 69.723*g/mole);
-  //G4Element* As = new G4Element("Arsenic","As", 33., 74.9216*g/mole);
-  //G4Element* Be = new G4Element("Beryllium","Be", 4., 9.0122*g/mole);   // material for window
+    //G4Element* Ga = new G4Element("Gallium","Ga", 31., 69.723*g/mole);
+    //G4Element* As = new G4Element("Arsenic","As", 33., 74.9216*g/mole);
+    //G4Element* Be = new G4Element("Beryllium","Be", 4., 9.0122*g/mole);   // material for window
 
-  // Final doped silicon material to be used in the electron detector
-  G4Material* DopedSilicon = new G4Material("DopedSilicon", 5.8*g/cm3, 2); // last argument is number of components in material
-  DopedSilicon->AddElement(Si, 99.9*perCent);
-  DopedSilicon->AddElement(B, 0.1*perCent);
+    // Final doped silicon material to be used in the electron detector
+    DopedSilicon = new G4Material("DopedSilicon", 5.8*g/cm3, 2); // last argument is number of components in material
+    DopedSilicon->AddElement(Si, 99.9*perCent);
+    DopedSilicon->AddElement(B, 0.1*perCent);
 
-  //DopedSilicon->AddElement(Ga, 2*perCent);  // Gallium
-  //DopedSilicon->AddElement(As, 2*perCent);  // Arsenic (Gallium Arsenide)
+    //DopedSilicon->AddElement(Ga, 2*perCent);  // Gallium
+    //DopedSilicon->AddElement(As, 2*perCent);  // Arsenic (Gallium Arsenide)
+  }
 
 
-  G4ThreeVector detector1_pos  = G4ThreeVector(0, 0, 0);
+  // ----------------------------------------------------------------
+  // Detector layers
+  // ----------------------------------------------------------------
 
+  // Detector 1 exists at the origin, further layers downstream of it
+  fLayerVolumes.clear();
+  fLayerY.clear();
+  fLayerThickness.clear();
 
+  G4double layer_y = 0.;
+  for (size_t i = 0; i < layer_thickness_um.size(); i++) {
+    if (i > 0) layer_y += layer_spacing_mm[i]*mm;
+    G4double thickness = layer_thickness_um[i]*um;
 
-  G4VSolid* detector1_solid = new G4Box("detector",
-                   detector_dimX, detector1_thickness, detector_dimZ);
+    if (layer_y + 0.5*thickness > 0.5*env_sizeXY) {
+      G4Exception("DetectorConstruction::Construct()", "Detector002",
+                  FatalException, "Detector layer outside the envelope.");
+    }
 
+    std::ostringstream name;
+    name << "detector" << i + 1;
 
-  // ----------------------------------------------------------------
-  // Detector
-  // ----------------------------------------------------------------
+    G4VSolid* layer_solid = new G4Box(name.str(),
+                     detector_dimX, 0.5*thickness, detector_dimZ);
 
-  // Detector 1 exists at the origin
-  detector1_pos  = G4ThreeVector(0, 0, 0);
+    G4LogicalVolume* layer =
+    new G4LogicalVolume(layer_solid,          //its solid
+                        DopedSilicon,        //its material
+                        name.str());         //its name
 
-  G4LogicalVolume* detector1 =
-  new G4LogicalVolume(detector1_solid,      //its solid
-                      DopedSilicon,        //its material
-                      "detector1");      //its name
+    G4VPhysicalVolume* layer_phys =
+    new G4PVPlacement(0,                     //no rotation
+                    G4ThreeVector(0, layer_y, 0), //at position
+                    layer,                   //its logical volume
+                    name.str(),              //its name
+                    logicEnv,                //its mother  volume
+                    false,                   //no boolean operation
+                    G4int(i),                //copy number
+                    checkOverlaps);          //overlaps checking
 
-  new G4PVPlacement(0,                     //no rotation
-                  detector1_pos,            //at position
-                  detector1,                //its logical volume
-                  "detector1",           //its name
-                  logicEnv,                //its mother  volume
-                  false,                   //no boolean operation
-                  0,                       //copy number
-                  checkOverlaps);          //overlaps checking
+    // detector1 is scored by the stepping action and the pixel readout
+    if (i == 0) fScoringVolume = layer;
 
+    fLayerVolumes.push_back(layer_phys);
+    fLayerY.push_back(layer_y);
+    fLayerThickness.push_back(thickness);
+  }
+
+  fDetectorHalfX = detector_dimX;
+  fDetectorHalfZ = detector_dimZ;
 
 
   // ----------------------------------------------------------------
@@ -220,10 +309,50 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
   //window_pos = G4ThreeVector(0, -(detector1_thickness/2 + window_thickness/2 + window_gap),  0);
   window_pos = G4ThreeVector(0, -window_gap,  0);
 
+  // Single knife-edge pinhole or coded aperture mask
+  if (fMaskType == kPinhole) {
+    ConstructPinhole(logicEnv, window_solid, window_material, window_pos,
+                     checkOverlaps);
+  }
+  else {
+    ConstructMask(logicEnv, detector_dimX, window_height, window_material,
+                  window_pos, checkOverlaps);
+  }
+
+
+  G4Material* foil_material = nist->FindOrBuildMaterial("G4_Al");
+  G4ThreeVector foil_pos = G4ThreeVector(0.,-(window_gap - window_thickness - foil_thickness),0.);
+  G4VSolid* foil_solid = new G4Box("foil", foil_dimX, foil_thickness, foil_dimZ);
+  G4LogicalVolume* foil = new G4LogicalVolume(foil_solid,
+                                              foil_material,
+                                             "foil");
+  new G4PVPlacement(0,
+                    foil_pos,
+                    foil,
+                    "foil",
+                    logicEnv,
+                    false,
+                    0,
+                    checkOverlaps);
+
+  // always return the physical World
+  return physWorld;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorConstruction::ConstructPinhole(G4LogicalVolume* logicEnv,
+                                            G4VSolid* window_solid,
+                                            G4Material* window_material,
+                                            const G4ThreeVector& window_pos,
+                                            G4bool checkOverlaps)
+{
   // ----------------------------------------------------------------
   // Pinhole in window
   // ----------------------------------------------------------------
 
+  G4double window_thickness = fWindowThickness;
+  G4double pinhole_radius   = fPinholeRadius;
 
   // Rotation towards the y-axis
   G4RotationMatrix* pinhole_rotm = new G4RotationMatrix();
@@ -271,25 +400,102 @@ G4VPhysicalVolume* DetectorConstruction::Construct()
                     0,                       //copy number
                     checkOverlaps);          //overlaps checking
 
+  fNumberOfApertures = 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void DetectorConstruction::ConstructMask(G4LogicalVolume* logicEnv,
+                                         G4double halfX, G4double halfZ,
+                                         G4Material* window_material,
+                                         const G4ThreeVector& window_pos,
+                                         G4bool checkOverlaps)
+{
+  MaskPattern pattern;
+  G4bool built = fMaskType == kMURA
+               ? MaskPattern::MakeMURA(fMaskRank, pattern)
+               : MaskPattern::FromFile(fMaskFileName, pattern);
+  if (!built) {
+    G4ExceptionDescription message;
+    if (fMaskType == kMURA) message << "No MURA of rank " << fMaskRank << ".";
+    else message << "Cannot read the mask pattern " << fMaskFileName << ".";
+    G4Exception("DetectorConstruction::ConstructMask()", "Detector003",
+                FatalException, message);
+    return;
+  }
+
+  G4double pitch  = fMaskPitch;
+  G4double radius = fApertureRadius > 0. ? fApertureRadius : fPinholeRadius;
+  if (2.*radius > pitch) {
+    G4Exception("DetectorConstruction::ConstructMask()", "Detector004",
+                FatalException, "Mask apertures wider than the mask pitch.");
+    return;
+  }
+  if (0.5*pattern.GetColumns()*pitch > halfX
+      || 0.5*pattern.GetRows()*pitch > halfZ) {
+    G4Exception("DetectorConstruction::ConstructMask()", "Detector005",
+                FatalException, "Mask pattern larger than the window.");
+    return;
+  }
+
+  // The window is a plain box; as for the box of the single pinhole its
+  // half thickness is the configured window thickness
+  G4double halfThickness = fWindowThickness;
+  G4VSolid* window_solid = new G4Box("windowSolid", halfX, halfThickness,
+                                     halfZ);
+  G4LogicalVolume* window =
+    new G4LogicalVolume(window_solid, window_material, "window");
 
-  G4Material* foil_material = nist->FindOrBuildMaterial("G4_Al");
-  G4ThreeVector foil_pos = G4ThreeVector(0.,-(window_gap - window_thickness - foil_thickness),0.);
-  G4VSolid* foil_solid = new G4Box("foil", foil_dimX, foil_thickness, foil_dimZ);
-  G4LogicalVolume* foil = new G4LogicalVolume(foil_solid,
-                                              foil_material,
-                                             "foil");
   new G4PVPlacement(0,
-                    foil_pos,
-                    foil,
-                    "foil",
+                    window_pos,
+                    window,
+                    "window",
                     logicEnv,
                     false,
                     0,
                     checkOverlaps);
 
-  // always return the physical World
-  return physWorld;
+  // Knife-edge aperture with the opening slope of the single pinhole's
+  // cone, cut to the cell so that neighbours never overlap. Its faces sit
+  // one surface tolerance inside the window faces: coincident daughter and
+  // mother surfaces leave the navigator to pick either volume on them.
+  G4double skin = G4GeometryTolerance::GetInstance()->GetSurfaceTolerance();
+  G4double face_radius = std::min(7.*radius, 0.5*pitch);
+  G4double z[]      = {-(halfThickness - skin), 0., halfThickness - skin};
+  G4double r_in[]   = {0., 0., 0.};
+  G4double r_out[]  = {face_radius, radius, face_radius};
+  G4VSolid* aperture_solid = new G4Polycone("aperture", 0.*deg, 360.*deg,
+                                            3, z, r_in, r_out);
+  G4LogicalVolume* aperture =
+    new G4LogicalVolume(aperture_solid,
+                        G4Material::GetMaterial("Vacuum"),
+                        "aperture");
+
+  // One copy per open cell, voxelised by the navigator (kUndefined)
+  delete fMaskParameterisation;
+  fMaskParameterisation = new MaskParameterisation(pattern, pitch);
+  fNumberOfApertures = fMaskParameterisation->GetNumberOfCells();
+
+  G4PVParameterised* apertures
+    = new G4PVParameterised("aperture",
+                            aperture,
+                            window,
+                            kUndefined,
+                            fNumberOfApertures,
+                            fMaskParameterisation,
+                            false);
+
+  // The check tests every copy against all others, so its cost grows with
+  // the square of the aperture count: it covers the default rank 41 MURA
+  // (840 apertures) with fewer points per copy, larger masks are skipped
+  const G4int maxCheckedApertures = 1000;
+  if (checkOverlaps && fNumberOfApertures <= maxCheckedApertures) {
+    apertures->CheckOverlaps(100);
+  }
+  else if (checkOverlaps) {
+    G4cout << "Checking overlaps for volume aperture skipped, "
+           << fNumberOfApertures << " copies" << G4endl;
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,161 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file DetectorMessenger.cc
+/// \brief Implementation of the DetectorMessenger class
+
+#include "DetectorMessenger.hh"
+#include "DetectorConstruction.hh"
+#include "MaskPattern.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4RunManager.hh"
+#include "G4StateManager.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DetectorMessenger::DetectorMessenger(DetectorConstruction* detector)
+: G4UImessenger(),
+  fDetector(detector)
+{
+  fReadoutDir = new G4UIdirectory("/pinhole/readout/", false);
+  fReadoutDir->SetGuidance("Pixelated detector1 readout.");
+
+  fPitchCmd = new G4UIcmdWithADoubleAndUnit("/pinhole/readout/pitch", this);
+  fPitchCmd->SetGuidance("Pixel pitch of the virtual detector1 segmentation.");
+  fPitchCmd->SetGuidance("Each run then writes one count/energy image,");
+  fPitchCmd->SetGuidance("detector1_image_run<N>.npy. 0 disables the readout.");
+  fPitchCmd->SetParameterName("pitch", false);
+  fPitchCmd->SetRange("pitch>=0.");
+  fPitchCmd->SetDefaultUnit("mm");
+  fPitchCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fPitchCmd->SetToBeBroadcasted(false);
+
+  fMaskDir = new G4UIdirectory("/pinhole/mask/", false);
+  fMaskDir->SetGuidance("Pinhole or coded aperture mask in the window.");
+
+  fMaskTypeCmd = new G4UIcmdWithAString("/pinhole/mask/type", this);
+  fMaskTypeCmd->SetGuidance("pinhole: the single knife-edge pinhole of the");
+  fMaskTypeCmd->SetGuidance("configuration file; mura: a MURA of the given");
+  fMaskTypeCmd->SetGuidance("rank; file: the pattern of /pinhole/mask/file.");
+  fMaskTypeCmd->SetParameterName("type", false);
+  fMaskTypeCmd->SetCandidates("pinhole mura file");
+
+  fMaskRankCmd = new G4UIcmdWithAnInteger("/pinhole/mask/rank", this);
+  fMaskRankCmd->SetGuidance("Rank p of the MURA, a prime 4m+1; the mask has");
+  fMaskRankCmd->SetGuidance("p x p cells of which (p*p - 1)/2 are open.");
+  fMaskRankCmd->SetParameterName("rank", false);
+  fMaskRankCmd->SetRange("rank>=5");
+
+  fMaskFileCmd = new G4UIcmdWithAString("/pinhole/mask/file", this);
+  fMaskFileCmd->SetGuidance("Mask pattern file: rows of 1 (open) and 0");
+  fMaskFileCmd->SetGuidance("(closed), rows along z and columns along x.");
+  fMaskFileCmd->SetParameterName("fileName", false);
+
+  fMaskPitchCmd = new G4UIcmdWithADoubleAndUnit("/pinhole/mask/pitch", this);
+  fMaskPitchCmd->SetGuidance("Centre distance of neighbouring mask cells.");
+  fMaskPitchCmd->SetParameterName("pitch", false);
+  fMaskPitchCmd->SetRange("pitch>0.");
+  fMaskPitchCmd->SetDefaultUnit("mm");
+
+  fApertureRadiusCmd
+    = new G4UIcmdWithADoubleAndUnit("/pinhole/mask/radius", this);
+  fApertureRadiusCmd->SetGuidance("Radius of the mask apertures at their");
+  fApertureRadiusCmd->SetGuidance("knife edge, 0 for the pinhole radius of");
+  fApertureRadiusCmd->SetGuidance("the configuration file.");
+  fApertureRadiusCmd->SetParameterName("radius", false);
+  fApertureRadiusCmd->SetRange("radius>=0.");
+  fApertureRadiusCmd->SetDefaultUnit("mm");
+
+  G4UIcommand* maskCommands[] = { fMaskTypeCmd, fMaskRankCmd, fMaskFileCmd,
+                                  fMaskPitchCmd, fApertureRadiusCmd };
+  for (size_t i = 0; i < sizeof(maskCommands)/sizeof(maskCommands[0]); i++) {
+    maskCommands[i]->AvailableForStates(G4State_PreInit, G4State_Idle);
+    maskCommands[i]->SetToBeBroadcasted(false);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DetectorMessenger::~DetectorMessenger()
+{
+  delete fPitchCmd;
+  delete fReadoutDir;
+  delete fMaskTypeCmd;
+  delete fMaskRankCmd;
+  delete fMaskFileCmd;
+  delete fMaskPitchCmd;
+  delete fApertureRadiusCmd;
+  delete fMaskDir;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DetectorMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fPitchCmd) {
+    fDetector->SetReadoutPitch(fPitchCmd->GetNewDoubleValue(newValue));
+    return;
+  }
+
+  if (command == fMaskTypeCmd) {
+    if (newValue == "mura") fDetector->SetMaskType(DetectorConstruction::kMURA);
+    else if (newValue == "file") {
+      fDetector->SetMaskType(DetectorConstruction::kPatternFile);
+    }
+    else fDetector->SetMaskType(DetectorConstruction::kPinhole);
+  }
+  else if (command == fMaskRankCmd) {
+    G4int rank = fMaskRankCmd->GetNewIntValue(newValue);
+    if (!MaskPattern::IsMURARank(rank)) {
+      G4Exception("DetectorMessenger::SetNewValue()", "Detector006",
+                  JustWarning, "MURA ranks are primes 4m+1 (5, 13, 17, 29,"
+                  " 37, 41, ...), command ignored.");
+      return;
+    }
+    fDetector->SetMaskRank(rank);
+  }
+  else if (command == fMaskFileCmd) {
+    fDetector->SetMaskFileName(newValue);
+  }
+  else if (command == fMaskPitchCmd) {
+    fDetector->SetMaskPitch(fMaskPitchCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == fApertureRadiusCmd) {
+    fDetector->SetApertureRadius(
+      fApertureRadiusCmd->GetNewDoubleValue(newValue));
+  }
+  else return;
+
+  // The mask is part of the geometry: rebuild it once initialised
+  if (G4StateManager::GetStateManager()->GetCurrentState() == G4State_Idle) {
+    G4RunManager::GetRunManager()->ReinitializeGeometry(true);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
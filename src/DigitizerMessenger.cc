@@ -0,0 +1,134 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file DigitizerMessenger.cc
+/// \brief Implementation of the DigitizerMessenger class
+
+#include "DigitizerMessenger.hh"
+#include "PixelDigitizer.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DigitizerMessenger::DigitizerMessenger()
+: G4UImessenger()
+{
+  fDigiDir = new G4UIdirectory("/pinhole/digi/", false);
+  fDigiDir->SetGuidance("Digitization of detector1: charge sharing, noise");
+  fDigiDir->SetGuidance("and threshold of a pixel or strip readout.");
+
+  fEnableCmd = new G4UIcmdWithABool("/pinhole/digi/enable", this);
+  fEnableCmd->SetGuidance("Digitize accepted events and write digis.csv,");
+  fEnableCmd->SetGuidance("event,ix,iz,x,z,signal (cm, MeV), instead of the");
+  fEnableCmd->SetGuidance("raw hits.csv entries.");
+  fEnableCmd->SetParameterName("enable", true);
+  fEnableCmd->SetDefaultValue(true);
+  fEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fEnableCmd->SetToBeBroadcasted(false);
+
+  fPitchCmd = new G4UIcmdWithADoubleAndUnit("/pinhole/digi/pitch", this);
+  fPitchCmd->SetGuidance("Pixel or strip pitch.");
+  fPitchCmd->SetParameterName("pitch", false);
+  fPitchCmd->SetRange("pitch>0.");
+  fPitchCmd->SetDefaultUnit("um");
+  fPitchCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fPitchCmd->SetToBeBroadcasted(false);
+
+  fStripsCmd = new G4UIcmdWithABool("/pinhole/digi/strips", this);
+  fStripsCmd->SetGuidance("Strips along z, measuring x, instead of pixels.");
+  fStripsCmd->SetParameterName("strips", true);
+  fStripsCmd->SetDefaultValue(true);
+  fStripsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fStripsCmd->SetToBeBroadcasted(false);
+
+  fDiffusionCmd
+    = new G4UIcmdWithADoubleAndUnit("/pinhole/digi/diffusion", this);
+  fDiffusionCmd->SetGuidance("Width of the charge cloud of a deposit drifting");
+  fDiffusionCmd->SetGuidance("through the full sensor thickness; it scales");
+  fDiffusionCmd->SetGuidance("with the square root of the drift length.");
+  fDiffusionCmd->SetParameterName("sigma", false);
+  fDiffusionCmd->SetRange("sigma>=0.");
+  fDiffusionCmd->SetDefaultUnit("um");
+  fDiffusionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fDiffusionCmd->SetToBeBroadcasted(false);
+
+  fNoiseCmd = new G4UIcmdWithADoubleAndUnit("/pinhole/digi/noise", this);
+  fNoiseCmd->SetGuidance("Gaussian readout noise per channel, in energy.");
+  fNoiseCmd->SetParameterName("sigma", false);
+  fNoiseCmd->SetRange("sigma>=0.");
+  fNoiseCmd->SetDefaultUnit("keV");
+  fNoiseCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fNoiseCmd->SetToBeBroadcasted(false);
+
+  fThresholdCmd
+    = new G4UIcmdWithADoubleAndUnit("/pinhole/digi/threshold", this);
+  fThresholdCmd->SetGuidance("Channels with a smaller signal are dropped.");
+  fThresholdCmd->SetParameterName("threshold", false);
+  fThresholdCmd->SetDefaultUnit("keV");
+  fThresholdCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fThresholdCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DigitizerMessenger::~DigitizerMessenger()
+{
+  delete fEnableCmd;
+  delete fPitchCmd;
+  delete fStripsCmd;
+  delete fDiffusionCmd;
+  delete fNoiseCmd;
+  delete fThresholdCmd;
+  delete fDigiDir;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DigitizerMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fEnableCmd) {
+    PixelDigitizer::SetEnabled(fEnableCmd->GetNewBoolValue(newValue));
+  }
+  else if (command == fPitchCmd) {
+    PixelDigitizer::SetPitch(fPitchCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == fStripsCmd) {
+    PixelDigitizer::SetStrips(fStripsCmd->GetNewBoolValue(newValue));
+  }
+  else if (command == fDiffusionCmd) {
+    PixelDigitizer::SetDiffusion(fDiffusionCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == fNoiseCmd) {
+    PixelDigitizer::SetNoise(fNoiseCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == fThresholdCmd) {
+    PixelDigitizer::SetThreshold(fThresholdCmd->GetNewDoubleValue(newValue));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
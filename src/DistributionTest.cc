@@ -0,0 +1,238 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file DistributionTest.cc
+/// \brief Implementation of the DistributionTest class
+
+#include "DistributionTest.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <istream>
+#include <ostream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+  // Regularised upper incomplete gamma function Q(a, x), by its series
+  // below a + 1 and its continued fraction above (Numerical Recipes 6.2)
+  double GammaQ(double a, double x)
+  {
+    if (x <= 0.) return 1.;
+    double lnPrefactor = -x + a*std::log(x) - std::lgamma(a);
+
+    if (x < a + 1.) {
+      double term = 1./a;
+      double sum = term;
+      for (int n = 1; n < 1000; n++) {
+        term *= x/(a + n);
+        sum += term;
+        if (std::fabs(term) < std::fabs(sum)*1.e-15) break;
+      }
+      return 1. - sum*std::exp(lnPrefactor);
+    }
+
+    const double tiny = 1.e-300;
+    double b = x + 1. - a;
+    double c = 1./tiny;
+    double d = 1./b;
+    double h = d;
+    for (int i = 1; i < 1000; i++) {
+      double an = -i*(i - a);
+      b += 2.;
+      d = an*d + b;
+      if (std::fabs(d) < tiny) d = tiny;
+      c = b + an/c;
+      if (std::fabs(c) < tiny) c = tiny;
+      d = 1./d;
+      double delta = d*c;
+      h *= delta;
+      if (std::fabs(delta - 1.) < 1.e-15) break;
+    }
+    return std::exp(lnPrefactor)*h;
+  }
+
+  // Kolmogorov distribution Q_KS(lambda)
+  double KolmogorovQ(double lambda)
+  {
+    if (lambda < 0.2) return 1.;
+    double sum = 0.;
+    double sign = 1.;
+    for (int j = 1; j <= 100; j++) {
+      double term = sign*std::exp(-2.*j*j*lambda*lambda);
+      sum += term;
+      if (std::fabs(term) < 1.e-12*std::fabs(sum)) break;
+      sign = -sign;
+    }
+    double q = 2.*sum;
+    return q < 0. ? 0. : (q > 1. ? 1. : q);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DistributionTest::DistributionTest()
+: fMin(0.),
+  fMax(1.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DistributionTest::DistributionTest(const std::string& name, int nBins,
+                                   double min, double max)
+: fName(name),
+  fMin(min),
+  fMax(max),
+  fCounts(nBins > 0 ? nBins : 1, 0.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double DistributionTest::GetEntries() const
+{
+  double sum = 0.;
+  for (size_t i = 0; i < fCounts.size(); i++) sum += fCounts[i];
+  return sum;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+DistributionTest DistributionTest::Clone() const
+{
+  return DistributionTest(fName, GetNbins(), fMin, fMax);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void DistributionTest::Write(std::ostream& out) const
+{
+  out << "histogram " << fName << " " << fCounts.size() << " "
+      << std::setprecision(17) << fMin << " " << fMax;
+  for (size_t i = 0; i < fCounts.size(); i++) out << " " << fCounts[i];
+  out << "\n";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool DistributionTest::Read(std::istream& in)
+{
+  std::string keyword;
+  int nBins = 0;
+  if (!(in >> keyword >> fName >> nBins >> fMin >> fMax)) return false;
+  if (keyword != "histogram" || nBins < 1 || !(fMax > fMin)) return false;
+
+  fCounts.assign(nBins, 0.);
+  for (int i = 0; i < nBins; i++) {
+    if (!(in >> fCounts[i])) return false;
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double DistributionTest::ChiSquare(const DistributionTest& a,
+                                   const DistributionTest& b,
+                                   double& chi2, int& ndf)
+{
+  chi2 = 0.;
+  ndf = 0;
+  double na = a.GetEntries();
+  double nb = b.GetEntries();
+  if (na <= 0. || nb <= 0. || a.GetNbins() != b.GetNbins()) return 0.;
+
+  // Scale factors for unequal totals (Numerical Recipes 14.3)
+  double ka = std::sqrt(nb/na);
+  double kb = std::sqrt(na/nb);
+
+  std::vector<double> ga, gb;
+  double ra = 0., rb = 0.;
+  for (int i = 0; i < a.GetNbins(); i++) {
+    ra += a.fCounts[i];
+    rb += b.fCounts[i];
+    if (ra + rb >= 10.) {
+      ga.push_back(ra);
+      gb.push_back(rb);
+      ra = rb = 0.;
+    }
+  }
+  // A sparse remainder goes into the last group
+  if (ra + rb > 0.) {
+    if (ga.empty()) {
+      ga.push_back(0.);
+      gb.push_back(0.);
+    }
+    ga.back() += ra;
+    gb.back() += rb;
+  }
+
+  for (size_t i = 0; i < ga.size(); i++) {
+    double diff = ka*ga[i] - kb*gb[i];
+    chi2 += diff*diff/(ga[i] + gb[i]);
+  }
+
+  int groups = int(ga.size());
+  ndf = groups - 1;
+  if (ndf < 1) return 1.;
+  return GammaQ(0.5*ndf, 0.5*chi2);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double DistributionTest::KolmogorovSmirnov(const DistributionTest& a,
+                                           const DistributionTest& b,
+                                           double& distance)
+{
+  distance = 0.;
+  double na = a.GetEntries();
+  double nb = b.GetEntries();
+  if (na <= 0. || nb <= 0. || a.GetNbins() != b.GetNbins()) return 0.;
+
+  double fa = 0., fb = 0.;
+  for (int i = 0; i < a.GetNbins(); i++) {
+    fa += a.fCounts[i]/na;
+    fb += b.fCounts[i]/nb;
+    distance = std::max(distance, std::fabs(fa - fb));
+  }
+
+  // Binning only lowers the distance, so the test is conservative
+  double ne = std::sqrt(na*nb/(na + nb));
+  return KolmogorovQ((ne + 0.12 + 0.11/ne)*distance);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double DistributionTest::RateDifference(double n1, double t1,
+                                        double n2, double t2)
+{
+  if (t1 <= 0. || t2 <= 0.) return 0.;
+  double variance = n1/(t1*t1) + n2/(t2*t2);
+  if (variance <= 0.) return n1/t1 == n2/t2 ? 1. : 0.;
+  double z = std::fabs(n1/t1 - n2/t2)/std::sqrt(variance);
+  return std::erfc(z/std::sqrt(2.));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
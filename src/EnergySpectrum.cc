@@ -0,0 +1,127 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file EnergySpectrum.cc
+/// \brief Implementation of the EnergySpectrum class
+
+#include "EnergySpectrum.hh"
+
+#include <cmath>
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EnergySpectrum::EnergySpectrum()
+: fShape(kPowerLaw),
+  fMin(0.05),
+  fMax(3.),
+  fParameter(1.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EnergySpectrum::EnergySpectrum(Shape shape, double emin, double emax,
+                               double param)
+: fShape(shape),
+  fMin(emin),
+  fMax(emax),
+  fParameter(param)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double EnergySpectrum::Sample(double u) const
+{
+  if (fShape == kExponential) {
+    double a = std::exp(-fMin/fParameter);
+    double b = std::exp(-fMax/fParameter);
+    return -fParameter*std::log(a - u*(a - b));
+  }
+
+  // Power law, E^-index
+  if (std::fabs(fParameter - 1.) < 1.e-9) {
+    return fMin*std::pow(fMax/fMin, u);
+  }
+  double k  = 1. - fParameter;
+  double lo = std::pow(fMin, k);
+  double hi = std::pow(fMax, k);
+  return std::pow(lo + u*(hi - lo), 1./k);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double EnergySpectrum::Density(double energy) const
+{
+  if (energy < fMin || energy > fMax) return 0.;
+
+  if (fShape == kExponential) {
+    double norm = fParameter*(std::exp(-fMin/fParameter)
+                              - std::exp(-fMax/fParameter));
+    return std::exp(-energy/fParameter)/norm;
+  }
+
+  if (std::fabs(fParameter - 1.) < 1.e-9) {
+    return 1./(energy*std::log(fMax/fMin));
+  }
+  double k = 1. - fParameter;
+  return k*std::pow(energy, -fParameter)
+         /(std::pow(fMax, k) - std::pow(fMin, k));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::string EnergySpectrum::ToString() const
+{
+  std::ostringstream os;
+  os << (fShape == kExponential ? "exponential" : "powerlaw")
+     << " " << fMin << " " << fMax << " " << fParameter;
+  return os.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool EnergySpectrum::FromString(const std::string& text,
+                                EnergySpectrum& spectrum)
+{
+  std::istringstream is(text);
+  std::string shape;
+  double emin, emax, param;
+
+  if (!(is >> shape >> emin >> emax >> param)) return false;
+  if (emin <= 0. || emax <= emin) return false;
+
+  if (shape == "powerlaw") {
+    spectrum = EnergySpectrum(kPowerLaw, emin, emax, param);
+  }
+  else if (shape == "exponential" && param > 0.) {
+    spectrum = EnergySpectrum(kExponential, emin, emax, param);
+  }
+  else {
+    return false;
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -30,20 +30,59 @@
 
 #include "EventAction.hh"
 #include "RunAction.hh"
+#include "DetectorConstruction.hh"
+#include "HistoManager.hh"
+#include "SourceDefinition.hh"
+#include "Run.hh"
+#include "AngleEstimator.hh"
+#include "Telemetry.hh"
+#include "PerfCounters.hh"
+#include "PixelDigi.hh"
 
 #include "G4Event.hh"
+#include "G4DigiManager.hh"
 #include "G4RunManager.hh"
 #include "G4SystemOfUnits.hh"
 
-#include <fstream>
+
+// Every event with a detector1 entry, as before the trigger existed
+G4int  EventAction::fgTriggerMask = ~(1 << EventAction::kNoHit)
+                                    & ((1 << EventAction::kNEventClasses) - 1);
+G4bool EventAction::fgFilterPrimaries = false;
+G4bool EventAction::fgWriteRawHits    = false;
+G4bool EventAction::fgWriteFiles      = true;
+
+namespace
+{
+  const char* kClassNames[EventAction::kNEventClasses]
+    = { "none", "single", "double", "secondary", "multi" };
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 EventAction::EventAction(RunAction* runAction)
 : G4UserEventAction(),
   fRunAction(runAction),
-  fEdep(0.)
-{}
+  fEdep(0.),
+  fPrimaryEnergy(0.),
+  fPrimaryWeight(1.),
+  fDetector(0),
+  fPerf(0),
+  fEventStartTime(0.),
+  fPrimaryEntries(0),
+  fSecondaryEntries(0),
+  fDigitizer(0),
+  fDigiCollectionID(-1)
+{
+  fHits.reserve(16);
+
+  // One digitizer per thread, registered with the thread's digi manager
+  G4DigiManager* digiManager = G4DigiManager::GetDMpointer();
+  fDigitizer = new PixelDigitizer();
+  digiManager->AddNewModule(fDigitizer);
+  fDigiCollectionID
+    = digiManager->GetDigiCollectionID("PixelDigitizer/PixelDigis");
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
@@ -52,74 +91,240 @@ EventAction::~EventAction()
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+const char* EventAction::GetClassName(G4int eventClass)
+{
+  return (eventClass >= 0 && eventClass < kNEventClasses)
+    ? kClassNames[eventClass] : "unknown";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int EventAction::GetClassByName(const G4String& name)
+{
+  for (G4int i = 0; i < kNEventClasses; i++) {
+    if (name == kClassNames[i]) return i;
+  }
+  return -1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void EventAction::BeginOfEventAction(const G4Event* event)
 {
+  fPrimaryEnergy = event->GetPrimaryVertex()->GetPrimary()->GetKineticEnergy();
+  fPrimaryWeight = event->GetPrimaryVertex()->GetPrimary()->GetWeight();
 
-  // Writes particle initial positions to file
-  std::ofstream initialPositionsFile;
+  fHits.clear();
+  fDigitizer->Clear();
+  fPrimaryEntries   = 0;
+  fSecondaryEntries = 0;
+
+  fPerf = PerfCounters::Current();
+  if (fPerf) fEventStartTime = PerfCounters::Now();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventAction::AddHit(G4int layer, const G4ThreeVector& pos,
+                         const G4ThreeVector& dir, G4double energy,
+                         G4bool isPrimary)
+{
+  Hit hit = { layer, pos, dir, energy };
+  fHits.push_back(hit);
+  if (layer != 0)     return;
+  if (isPrimary) fPrimaryEntries++;
+  else           fSecondaryEntries++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+EventAction::EventClass EventAction::Classify() const
+{
+  if (fPrimaryEntries + fSecondaryEntries == 0) return kNoHit;
+  if (fPrimaryEntries == 0) return kSecondaryOnly;
+  if (fSecondaryEntries > 0) return kMultiHit;
+  return fPrimaryEntries == 1 ? kSingleHit : kDoubleHit;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventAction::EndOfEventAction(const G4Event* event)
+{
+  Telemetry::CountEvent();
+
+  EventClass eventClass = Classify();
+  G4bool accepted = (fgTriggerMask >> eventClass) & 1;
+  fRunAction->CountEvent(eventClass, accepted);
+
+  if (!fPerf) {
+    WriteEvent(event, accepted);
+    return;
+  }
+
+  G4double outputStartTime = PerfCounters::Now();
+  WriteEvent(event, accepted);
+  G4double now = PerfCounters::Now();
+  fPerf->AddOutputTime(now - outputStartTime);
+  fPerf->AddEvent(now - fEventStartTime);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventAction::WriteEvent(const G4Event* event, G4bool accepted)
+{
+  if (accepted || !fgFilterPrimaries) WritePrimary(event);
+  if (accepted && !fHits.empty()) WriteAccepted(event);
+
+  // Event boundary: shared files are flushed, own ones may rotate
+  if (fgWriteFiles) {
+    fRunAction->GetHitFile().EndEvent();
+    fRunAction->GetTrackFile().EndEvent();
+    fRunAction->GetPrimaryFile().EndEvent();
+    fRunAction->GetDigiFile().EndEvent();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventAction::WriteAccepted(const G4Event* event)
+{
+  if (!fDetector) {
+    fDetector = static_cast<const DetectorConstruction*>
+      (G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  }
 
-  G4ThreeVector mom;
+  // A telescope reduces the event to one track record
+  G4bool telescope = fDetector->GetNumberOfLayers() > 1;
+  if (fgWriteFiles) {
+    if (PixelDigitizer::IsEnabled()) WriteDigis(event);
+    else if (!telescope || fgWriteRawHits) WriteHits(telescope);
+    if (telescope) WriteTrack();
+  }
 
-  initialPositionsFile.open("../analysis/data/init_pos.csv", std::ios_base::app);
-  if(initialPositionsFile.is_open())
-  {
-    initialPositionsFile << event->GetPrimaryVertex()->GetX0() / cm << ","
-    << event->GetPrimaryVertex()->GetY0() / cm << ","
-    << event->GetPrimaryVertex()->GetZ0() / cm << ","
-    << event->GetPrimaryVertex()->GetPrimary()->GetMomentumDirection().x() << ","
-    << event->GetPrimaryVertex()->GetPrimary()->GetMomentumDirection().y() << ","
-    << event->GetPrimaryVertex()->GetPrimary()->GetMomentumDirection().z() << "\n";
+  // In-memory buffer of library drivers: every layer entry
+  Run* run = static_cast<Run*>(
+    G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+  if (std::vector<HitRecord>* buffer = run->GetHitBuffer()) {
+    for (size_t i = 0; i < fHits.size(); i++) {
+      const G4ThreeVector& pos = fHits[i].position;
+      HitRecord record = { pos.x()/cm, pos.y()/cm, pos.z()/cm,
+                           fHits[i].energy, fPrimaryEnergy, fPrimaryWeight,
+                           event->GetEventID(), fHits[i].layer };
+      buffer->push_back(record);
+    }
+  }
 
-    initialPositionsFile.close();
+  // Online estimator and ntuples: the detector1 hits
+  HistoManager* histoManager = fRunAction->GetHistoManager();
+  for (size_t i = 0; i < fHits.size(); i++) {
+    if (fHits[i].layer != 0) continue;
+    if (run->GetEstimator()) {
+      run->GetEstimator()->AddHit(fHits[i].position.x()/cm,
+                                  fHits[i].position.z()/cm);
+    }
+    if (histoManager->IsActive()) {
+      histoManager->FillHit(fHits[i].position, fHits[i].direction,
+                            fHits[i].energy, fPrimaryEnergy);
+    }
+  }
+}
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void EventAction::WriteHits(G4bool tagLayers) const
+{
+  std::ostream& hitFile = fRunAction->GetHitFile().Stream();
 
+  // Multi-energy runs: primary energy (MeV) and weight for tools/reweight.
+  // Telescope hits start with the layer number, as the det,x,y,z,energy
+  // rows read by calc_angle_per_particle and hitanalysis -m pair
+  G4bool multiEnergy = SourceDefinition::Instance()->IsMultiEnergy();
+  for (size_t i = 0; i < fHits.size(); i++) {
+    const G4ThreeVector& pos = fHits[i].position;
+    hitFile << "\n";
+    if (tagLayers) hitFile << fHits[i].layer + 1 << ",";
+    hitFile << pos.x()/cm << "," << pos.y()/cm << "," << pos.z()/cm
+            << "," << fHits[i].energy;
+    if (multiEnergy) {
+      hitFile << "," << fPrimaryEnergy << "," << fPrimaryWeight;
+    }
   }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void EventAction::EndOfEventAction(const G4Event*)
+void EventAction::WriteTrack()
 {
+  fTrackFitter.Clear();
+  for (size_t i = 0; i < fHits.size(); i++) {
+    const G4ThreeVector& pos = fHits[i].position;
+    fTrackFitter.AddPoint(fHits[i].layer, pos.x()/cm, pos.y()/cm, pos.z()/cm);
+  }
 
-  if(det1_hitFlag > 1)
-  {
-    /*
-    std::ofstream hitFile_detector1;
-    hitFile_detector1.open("../analysis/data/hits.csv", std::ios_base::app);
+  // Position at the detector1 plane
+  TrackFitter::Track track;
+  if (!fTrackFitter.Fit(fDetector->GetLayerPosition(0)/cm, track)) return;
 
-    hitFile_detector1 << "\n1,0,0,0,0,DH";
+  std::ostream& trackFile = fRunAction->GetTrackFile().Stream();
 
-    hitFile_detector1.close();
-    */
+  // layers,x,z,theta,phi,rms,energy[,E0,w]: cm, degrees, cm, MeV
+  trackFile << track.nLayers << "," << track.x << "," << track.z << ","
+            << fTrackFitter.GetTheta(track) << ","
+            << fTrackFitter.GetPhi(track) << "," << track.rms << ","
+            << fHits[track.firstPoint].energy;
+  if (SourceDefinition::Instance()->IsMultiEnergy()) {
+    trackFile << "," << fPrimaryEnergy << "," << fPrimaryWeight;
   }
+  trackFile << "\n";
+}
 
-  if(det2_hitFlag == 0)
-  {
-    /*
-    std::ofstream hitFile_detector2;
-    hitFile_detector2.open("../analysis/data/hits.csv", std::ios_base::app);
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-    hitFile_detector2 << "\n2,0,0,0,0,NH";
+void EventAction::WriteDigis(const G4Event* event)
+{
+  G4DigiManager* digiManager = G4DigiManager::GetDMpointer();
+  digiManager->Digitize(fDigitizer->GetName());
+  const PixelDigiCollection* digis = static_cast<const PixelDigiCollection*>(
+    digiManager->GetDigiCollection(fDigiCollectionID));
+  if (!digis) return;
 
-    hitFile_detector2.close();
-    */
+  // event,ix,iz,x,z,signal[,E0,w]: channel centre in cm, MeV
+  std::ostream& digiFile = fRunAction->GetDigiFile().Stream();
+  G4bool multiEnergy = SourceDefinition::Instance()->IsMultiEnergy();
+  for (size_t i = 0; i < digis->entries(); i++) {
+    const PixelDigi* digi = (*digis)[i];
+    digiFile << event->GetEventID() << "," << digi->GetIx() << ","
+             << digi->GetIz() << ","
+             << fDigitizer->GetChannelX(digi->GetIx())/cm << ","
+             << fDigitizer->GetChannelZ(digi->GetIz())/cm << ","
+             << digi->GetSignal();
+    if (multiEnergy) digiFile << "," << fPrimaryEnergy << "," << fPrimaryWeight;
+    digiFile << "\n";
   }
+}
 
-  else if(det2_hitFlag > 1)
-  {
-    /*
-    std::ofstream hitFile_detector2;
-    hitFile_detector2.open("../analysis/data/hits.csv", std::ios_base::app);
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-    hitFile_detector2 << "\n2,0,0,0,0,DH";
+void EventAction::WritePrimary(const G4Event* event) const
+{
+  const G4PrimaryVertex* vertex = event->GetPrimaryVertex();
+  const G4ThreeVector& direction = vertex->GetPrimary()->GetMomentumDirection();
 
-    hitFile_detector2.close();
-    */
+  HistoManager* histoManager = fRunAction->GetHistoManager();
+  if (histoManager->IsActive()) {
+    histoManager->FillPrimary(vertex->GetPosition(), direction, fPrimaryEnergy);
   }
 
-    //resetDetector1Flag();
-    //resetDetector2Flag();
+  if (!fgWriteFiles) return;
+
+  // Writes particle initial positions to file
+  std::ostream& initialPositionsFile = fRunAction->GetPrimaryFile().Stream();
+  initialPositionsFile << vertex->GetX0()/cm << ","
+                       << vertex->GetY0()/cm << ","
+                       << vertex->GetZ0()/cm << ","
+                       << direction.x() << ","
+                       << direction.y() << ","
+                       << direction.z() << "\n";
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
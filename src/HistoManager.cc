@@ -0,0 +1,208 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file HistoManager.cc
+/// \brief Implementation of the HistoManager class
+
+#include "HistoManager.hh"
+#include "HistoMessenger.hh"
+#include "OutputManager.hh"
+
+#include "G4RootAnalysisManager.hh"
+#include "G4CsvAnalysisManager.hh"
+#include "G4XmlAnalysisManager.hh"
+#ifdef PINHOLE_WITH_HDF5
+#include "G4Hdf5AnalysisManager.hh"
+#endif
+
+#include "G4Threading.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+G4String HistoManager::fgFileType = "none";
+G4String HistoManager::fgFileName = "";
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HistoManager::HistoManager()
+: fMessenger(0),
+  fManager(0),
+  fHitEnergyH1(-1),
+  fHitAngleH1(-1),
+  fPrimaryEnergyH1(-1),
+  fHitMapH2(-1),
+  fHitsNtuple(-1),
+  fPrimariesNtuple(-1)
+{
+  // The settings are job-wide, only the master instance takes commands
+  if (G4Threading::IsMasterThread()) fMessenger = new HistoMessenger();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HistoManager::~HistoManager()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HistoManager::Open(G4int runID)
+{
+  if (fgFileType == "none") return;
+
+  // The analysis managers are per-thread singletons which cannot be
+  // swapped once booked, so the first backend chosen holds for the job
+  if (!fManager) {
+    if (fgFileType == "root") {
+      G4RootAnalysisManager* root = G4RootAnalysisManager::Instance();
+      root->SetNtupleMerging(true);
+      fManager = root;
+    }
+    else if (fgFileType == "csv") fManager = G4CsvAnalysisManager::Instance();
+    else if (fgFileType == "xml") fManager = G4XmlAnalysisManager::Instance();
+#ifdef PINHOLE_WITH_HDF5
+    else if (fgFileType == "hdf5") fManager = G4Hdf5AnalysisManager::Instance();
+#endif
+    else {
+      G4cerr << "HistoManager: output type " << fgFileType
+             << " is not available in this build" << G4endl;
+      return;
+    }
+    fManagerType = fgFileType;
+    Book();
+  }
+  else if (fManagerType != fgFileType) {
+    G4cerr << "HistoManager: keeping output type " << fManagerType
+           << ", the backend cannot change within a job" << G4endl;
+  }
+
+  std::ostringstream fileName;
+  // pinhole_run<N> in the run's output directory unless set
+  if (fgFileName.empty()) {
+    fileName << OutputManager::Instance()->GetRunPath("pinhole");
+  }
+  else {
+    fileName << fgFileName;
+  }
+  fileName << "_run" << runID;
+  fManager->OpenFile(fileName.str());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HistoManager::Book()
+{
+  fManager->SetVerboseLevel(0);
+
+  fHitEnergyH1 = fManager->CreateH1("hit_energy",
+                   "Kinetic energy at detector1 entry (MeV)",
+                   500, 0., 5.);
+  fHitAngleH1 = fManager->CreateH1("hit_angle",
+                   "Incident angle on detector1 (deg)",
+                   180, 0., 90.);
+  fPrimaryEnergyH1 = fManager->CreateH1("primary_energy",
+                   "Primary kinetic energy (MeV)",
+                   500, 0., 5.);
+  fHitMapH2 = fManager->CreateH2("hit_map",
+                   "detector1 hits, x vs z (cm)",
+                   126, -6.3, 6.3, 126, -6.3, 6.3);
+
+  fHitsNtuple = fManager->CreateNtuple("hits", "detector1 entries");
+  fManager->CreateNtupleDColumn("x");
+  fManager->CreateNtupleDColumn("y");
+  fManager->CreateNtupleDColumn("z");
+  fManager->CreateNtupleDColumn("energy");
+  fManager->CreateNtupleDColumn("angle");
+  fManager->CreateNtupleDColumn("E0");
+  fManager->FinishNtuple();
+
+  fPrimariesNtuple = fManager->CreateNtuple("primaries", "primary vertices");
+  fManager->CreateNtupleDColumn("x0");
+  fManager->CreateNtupleDColumn("y0");
+  fManager->CreateNtupleDColumn("z0");
+  fManager->CreateNtupleDColumn("px");
+  fManager->CreateNtupleDColumn("py");
+  fManager->CreateNtupleDColumn("pz");
+  fManager->CreateNtupleDColumn("E0");
+  fManager->FinishNtuple();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HistoManager::Save()
+{
+  if (!fManager) return;
+
+  fManager->Write();
+  fManager->CloseFile();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HistoManager::FillHit(const G4ThreeVector& pos, const G4ThreeVector& dir,
+                           G4double energy, G4double primaryEnergy)
+{
+  if (!fManager) return;
+
+  // detector1 faces the source along y
+  G4double angle = std::acos(std::min(1., std::fabs(dir.y())))/deg;
+
+  fManager->FillH1(fHitEnergyH1, energy/MeV);
+  fManager->FillH1(fHitAngleH1, angle);
+  fManager->FillH2(fHitMapH2, pos.x()/cm, pos.z()/cm);
+
+  fManager->FillNtupleDColumn(fHitsNtuple, 0, pos.x()/cm);
+  fManager->FillNtupleDColumn(fHitsNtuple, 1, pos.y()/cm);
+  fManager->FillNtupleDColumn(fHitsNtuple, 2, pos.z()/cm);
+  fManager->FillNtupleDColumn(fHitsNtuple, 3, energy/MeV);
+  fManager->FillNtupleDColumn(fHitsNtuple, 4, angle);
+  fManager->FillNtupleDColumn(fHitsNtuple, 5, primaryEnergy/MeV);
+  fManager->AddNtupleRow(fHitsNtuple);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HistoManager::FillPrimary(const G4ThreeVector& pos,
+                               const G4ThreeVector& dir, G4double energy)
+{
+  if (!fManager) return;
+
+  fManager->FillH1(fPrimaryEnergyH1, energy/MeV);
+
+  fManager->FillNtupleDColumn(fPrimariesNtuple, 0, pos.x()/cm);
+  fManager->FillNtupleDColumn(fPrimariesNtuple, 1, pos.y()/cm);
+  fManager->FillNtupleDColumn(fPrimariesNtuple, 2, pos.z()/cm);
+  fManager->FillNtupleDColumn(fPrimariesNtuple, 3, dir.x());
+  fManager->FillNtupleDColumn(fPrimariesNtuple, 4, dir.y());
+  fManager->FillNtupleDColumn(fPrimariesNtuple, 5, dir.z());
+  fManager->FillNtupleDColumn(fPrimariesNtuple, 6, energy/MeV);
+  fManager->AddNtupleRow(fPrimariesNtuple);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,80 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file HistoMessenger.cc
+/// \brief Implementation of the HistoMessenger class
+
+#include "HistoMessenger.hh"
+#include "HistoManager.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HistoMessenger::HistoMessenger()
+: G4UImessenger()
+{
+  fAnalysisDir = new G4UIdirectory("/pinhole/analysis/", false);
+  fAnalysisDir->SetGuidance("Online histograms and ntuples.");
+
+  fFileTypeCmd = new G4UIcmdWithAString("/pinhole/analysis/fileType", this);
+  fFileTypeCmd->SetGuidance("Output backend for histograms and ntuples.");
+  fFileTypeCmd->SetGuidance("hdf5 needs a Geant4 built with HDF5 support.");
+  fFileTypeCmd->SetGuidance("The first backend used holds for the whole job.");
+  fFileTypeCmd->SetParameterName("type", false);
+  fFileTypeCmd->SetCandidates("none root csv xml hdf5");
+  fFileTypeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fFileTypeCmd->SetToBeBroadcasted(false);
+
+  fFileNameCmd = new G4UIcmdWithAString("/pinhole/analysis/fileName", this);
+  fFileNameCmd->SetGuidance("Output file name stem, _run<N> is appended.");
+  fFileNameCmd->SetParameterName("name", false);
+  fFileNameCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fFileNameCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HistoMessenger::~HistoMessenger()
+{
+  delete fFileTypeCmd;
+  delete fFileNameCmd;
+  delete fAnalysisDir;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HistoMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fFileTypeCmd) {
+    HistoManager::SetFileType(newValue);
+  }
+  else if (command == fFileNameCmd) {
+    HistoManager::SetFileName(newValue);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,438 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file HitIndex.cc
+/// \brief Implementation of the HitIndex class
+
+#include "HitIndex.hh"
+#include "CsvReader.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+struct HitIndex::Header
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t bits;
+  uint64_t nHits;
+  double   xMin, xMax, zMin, zMax;
+};
+
+struct HitIndex::Cell
+{
+  uint64_t first;
+  uint64_t count;
+  double   eMin, eMax;
+};
+
+namespace
+{
+  const char     kMagic[8] = { 'P', 'H', 'I', 'D', 'X', 0, 0, 0 };
+  const uint32_t kVersion  = 1;
+  const int      kMaxFields = 8;
+
+  // Detector1 hit of a hits.csv row: x,y,z,energy[,E0,w], or the same
+  // behind a layer number in telescope files (odd field counts)
+  bool ToHit(const double* values, int nFields, HitIndex::Hit& hit)
+  {
+    if (nFields < 4) return false;
+    if (nFields % 2 == 1) {
+      if (values[0] != 1.) return false;
+      values++;
+      nFields--;
+    }
+    hit.x = values[0];
+    hit.y = values[1];
+    hit.z = values[2];
+    hit.energy = values[3];
+    hit.primaryEnergy = nFields >= 6 ? values[4] : 0.;
+    hit.weight        = nFields >= 6 ? values[5] : 1.;
+    return true;
+  }
+
+  // Cell of a coordinate, clamped to the grid
+  inline uint32_t CellOf(double value, double min, double max, uint32_t n)
+  {
+    double position = (value - min)/(max - min)*n;
+    if (!(position > 0.)) return 0;
+    if (position >= n) return n - 1;
+    return uint32_t(position);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HitIndex::Query::Query()
+: xMin(-std::numeric_limits<double>::max()),
+  xMax(std::numeric_limits<double>::max()),
+  zMin(-std::numeric_limits<double>::max()),
+  zMax(std::numeric_limits<double>::max()),
+  centreX(0.),
+  centreZ(0.),
+  radius(-1.),
+  eMin(-std::numeric_limits<double>::max()),
+  eMax(std::numeric_limits<double>::max())
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HitIndex::Query::SetBox(double x0, double x1, double z0, double z1)
+{
+  xMin = std::min(x0, x1);
+  xMax = std::max(x0, x1);
+  zMin = std::min(z0, z1);
+  zMax = std::max(z0, z1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HitIndex::Query::SetCircle(double x, double z, double r)
+{
+  SetBox(x - r, x + r, z - r, z + r);
+  centreX = x;
+  centreZ = z;
+  radius  = r;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HitIndex::HitIndex()
+: fHeader(0),
+  fCells(0),
+  fHits(0),
+  fMap(0),
+  fMapSize(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HitIndex::~HitIndex()
+{
+  Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+uint32_t HitIndex::Morton(uint32_t ix, uint32_t iz)
+{
+  // Spread the 16 low bits of each coordinate over the even/odd bits
+  uint32_t code[2] = { ix & 0xFFFF, iz & 0xFFFF };
+  for (int i = 0; i < 2; i++) {
+    code[i] = (code[i] | (code[i] << 8)) & 0x00FF00FF;
+    code[i] = (code[i] | (code[i] << 4)) & 0x0F0F0F0F;
+    code[i] = (code[i] | (code[i] << 2)) & 0x33333333;
+    code[i] = (code[i] | (code[i] << 1)) & 0x55555555;
+  }
+  return code[0] | (code[1] << 1);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool HitIndex::Build(const std::string& csvName, const std::string& indexName,
+                     int bits, std::string& error)
+{
+  if (bits < 1 || bits > 12) {
+    error = "grid bits must be between 1 and 12";
+    return false;
+  }
+  const uint32_t n = 1u << bits;
+  const std::size_t nCells = std::size_t(n)*n;
+
+  double values[kMaxFields];
+  int nFields;
+  Hit hit;
+
+  // Pass 1: extent of the hits
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.bits    = bits;
+  header.xMin = header.zMin =  std::numeric_limits<double>::max();
+  header.xMax = header.zMax = -std::numeric_limits<double>::max();
+  {
+    CsvReader reader(csvName);
+    if (!reader.IsOpen()) {
+      error = "cannot open " + csvName;
+      return false;
+    }
+    while ((nFields = reader.ReadLine(values, kMaxFields)) >= 0) {
+      if (!ToHit(values, nFields, hit)) continue;
+      header.nHits++;
+      header.xMin = std::min(header.xMin, hit.x);
+      header.xMax = std::max(header.xMax, hit.x);
+      header.zMin = std::min(header.zMin, hit.z);
+      header.zMax = std::max(header.zMax, hit.z);
+    }
+  }
+  if (header.nHits == 0) {
+    error = "no detector1 hits in " + csvName;
+    return false;
+  }
+  // Keeps the cell size finite for degenerate extents
+  if (header.xMax <= header.xMin) header.xMax = header.xMin + 1.e-6;
+  if (header.zMax <= header.zMin) header.zMax = header.zMin + 1.e-6;
+
+  // Pass 2: hits and energy range per cell, cell starts in Morton order
+  std::vector<Cell> cells(nCells);
+  for (std::size_t i = 0; i < nCells; i++) {
+    cells[i].first = cells[i].count = 0;
+    cells[i].eMin = std::numeric_limits<double>::max();
+    cells[i].eMax = -std::numeric_limits<double>::max();
+  }
+  {
+    CsvReader reader(csvName);
+    while ((nFields = reader.ReadLine(values, kMaxFields)) >= 0) {
+      if (!ToHit(values, nFields, hit)) continue;
+      Cell& cell = cells[Morton(CellOf(hit.x, header.xMin, header.xMax, n),
+                                CellOf(hit.z, header.zMin, header.zMax, n))];
+      cell.count++;
+      cell.eMin = std::min(cell.eMin, hit.energy);
+      cell.eMax = std::max(cell.eMax, hit.energy);
+    }
+  }
+  uint64_t next = 0;
+  for (std::size_t i = 0; i < nCells; i++) {
+    cells[i].first = next;
+    next += cells[i].count;
+  }
+  if (next != header.nHits) {
+    error = csvName + " changed while the index was built";
+    return false;
+  }
+
+  // Pass 3: hits scattered to their cell's block of the mapped file
+  std::size_t hitsOffset = sizeof(Header) + nCells*sizeof(Cell);
+  std::size_t size = hitsOffset + header.nHits*sizeof(Hit);
+  std::string temporary = indexName + ".tmp";
+  int file = open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (file < 0 || ftruncate(file, size) != 0) {
+    error = "cannot create " + temporary + ": " + std::strerror(errno);
+    if (file >= 0) close(file);
+    return false;
+  }
+  void* map = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  close(file);
+  if (map == MAP_FAILED) {
+    error = "cannot map " + temporary + ": " + std::strerror(errno);
+    return false;
+  }
+
+  char* base = static_cast<char*>(map);
+  std::memcpy(base, &header, sizeof(Header));
+  std::memcpy(base + sizeof(Header), &cells[0], nCells*sizeof(Cell));
+  Hit* hits = reinterpret_cast<Hit*>(base + hitsOffset);
+
+  std::vector<uint64_t> fill(nCells);
+  for (std::size_t i = 0; i < nCells; i++) fill[i] = cells[i].first;
+
+  bool complete = true;
+  {
+    CsvReader reader(csvName);
+    while ((nFields = reader.ReadLine(values, kMaxFields)) >= 0) {
+      if (!ToHit(values, nFields, hit)) continue;
+      uint32_t c = Morton(CellOf(hit.x, header.xMin, header.xMax, n),
+                          CellOf(hit.z, header.zMin, header.zMax, n));
+      if (fill[c] >= cells[c].first + cells[c].count) {
+        complete = false;
+        break;
+      }
+      hits[fill[c]++] = hit;
+    }
+  }
+  complete = complete && msync(map, size, MS_SYNC) == 0;
+  munmap(map, size);
+
+  if (!complete || std::rename(temporary.c_str(), indexName.c_str()) != 0) {
+    std::remove(temporary.c_str());
+    error = "could not write " + indexName;
+    return false;
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool HitIndex::Open(const std::string& indexName, std::string& error)
+{
+  Close();
+
+  int file = open(indexName.c_str(), O_RDONLY);
+  struct stat status;
+  if (file < 0 || fstat(file, &status) != 0) {
+    error = "cannot open " + indexName;
+    if (file >= 0) close(file);
+    return false;
+  }
+
+  std::size_t size = std::size_t(status.st_size);
+  void* map = size >= sizeof(Header)
+            ? mmap(0, size, PROT_READ, MAP_SHARED, file, 0) : MAP_FAILED;
+  close(file);
+  if (map == MAP_FAILED) {
+    error = indexName + " is not a hit index";
+    return false;
+  }
+
+  const Header* header = static_cast<const Header*>(map);
+  std::size_t nCells = (std::size_t(1) << header->bits) << header->bits;
+  if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0
+      || header->version != kVersion || header->bits > 12
+      || size != sizeof(Header) + nCells*sizeof(Cell)
+                 + header->nHits*sizeof(Hit)) {
+    munmap(map, size);
+    error = indexName + " is not a hit index of this version";
+    return false;
+  }
+
+  fMap     = map;
+  fMapSize = size;
+  fHeader  = header;
+  fCells   = reinterpret_cast<const Cell*>(header + 1);
+  fHits    = reinterpret_cast<const Hit*>(fCells + nCells);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HitIndex::Close()
+{
+  if (fMap) munmap(fMap, fMapSize);
+  fMap = 0;
+  fMapSize = 0;
+  fHeader = 0;
+  fCells = 0;
+  fHits = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+long HitIndex::GetNumberOfHits() const
+{
+  return fHeader ? long(fHeader->nHits) : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int HitIndex::GetCellsPerSide() const
+{
+  return fHeader ? 1 << fHeader->bits : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void HitIndex::GetExtent(double& xMin, double& xMax,
+                         double& zMin, double& zMax) const
+{
+  xMin = fHeader ? fHeader->xMin : 0.;
+  xMax = fHeader ? fHeader->xMax : 0.;
+  zMin = fHeader ? fHeader->zMin : 0.;
+  zMax = fHeader ? fHeader->zMax : 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+HitIndex::Result HitIndex::Select(const Query& query,
+                                  std::vector<Hit>* hits) const
+{
+  Result result = { 0, 0, 0 };
+  if (!fHeader) return result;
+
+  const uint32_t n = 1u << fHeader->bits;
+  const double cellX = (fHeader->xMax - fHeader->xMin)/n;
+  const double cellZ = (fHeader->zMax - fHeader->zMin)/n;
+  if (query.xMin > fHeader->xMax || query.xMax < fHeader->xMin
+      || query.zMin > fHeader->zMax || query.zMax < fHeader->zMin) {
+    return result;
+  }
+
+  // Cells overlapping the query box
+  uint32_t ix0 = CellOf(query.xMin, fHeader->xMin, fHeader->xMax, n);
+  uint32_t ix1 = CellOf(query.xMax, fHeader->xMin, fHeader->xMax, n);
+  uint32_t iz0 = CellOf(query.zMin, fHeader->zMin, fHeader->zMax, n);
+  uint32_t iz1 = CellOf(query.zMax, fHeader->zMin, fHeader->zMax, n);
+  const double r2 = query.radius*query.radius;
+
+  for (uint32_t iz = iz0; iz <= iz1; iz++) {
+    for (uint32_t ix = ix0; ix <= ix1; ix++) {
+      const Cell& cell = fCells[Morton(ix, iz)];
+      if (cell.count == 0 || cell.eMax < query.eMin || cell.eMin > query.eMax) {
+        continue;
+      }
+      result.cellsVisited++;
+
+      // A cell inside the selection needs no per-hit test; its box is
+      // widened a little against the rounding of the cell assignment
+      double x0 = fHeader->xMin + (ix - 1.e-6)*cellX, x1 = x0 + 1.000002*cellX;
+      double z0 = fHeader->zMin + (iz - 1.e-6)*cellZ, z1 = z0 + 1.000002*cellZ;
+      bool inside = x0 >= query.xMin && x1 <= query.xMax
+                    && z0 >= query.zMin && z1 <= query.zMax
+                    && cell.eMin >= query.eMin && cell.eMax <= query.eMax;
+      if (inside && query.radius >= 0.) {
+        double dx = std::max(std::abs(x0 - query.centreX),
+                             std::abs(x1 - query.centreX));
+        double dz = std::max(std::abs(z0 - query.centreZ),
+                             std::abs(z1 - query.centreZ));
+        inside = dx*dx + dz*dz <= r2;
+      }
+
+      const Hit* begin = fHits + cell.first;
+      const Hit* end   = begin + cell.count;
+      if (inside) {
+        result.hits += long(cell.count);
+        if (hits) hits->insert(hits->end(), begin, end);
+        continue;
+      }
+
+      result.hitsScanned += long(cell.count);
+      for (const Hit* hit = begin; hit < end; hit++) {
+        if (hit->x < query.xMin || hit->x > query.xMax
+            || hit->z < query.zMin || hit->z > query.zMax
+            || hit->energy < query.eMin || hit->energy > query.eMax) continue;
+        if (query.radius >= 0.) {
+          double dx = hit->x - query.centreX, dz = hit->z - query.centreZ;
+          if (dx*dx + dz*dz > r2) continue;
+        }
+        result.hits++;
+        if (hits) hits->push_back(*hit);
+      }
+    }
+  }
+  return result;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
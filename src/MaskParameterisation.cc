@@ -0,0 +1,72 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file MaskParameterisation.cc
+/// \brief Implementation of the MaskParameterisation class
+
+#include "MaskParameterisation.hh"
+#include "MaskPattern.hh"
+
+#include "G4VPhysicalVolume.hh"
+#include "G4SystemOfUnits.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MaskParameterisation::MaskParameterisation(const MaskPattern& pattern,
+                                           G4double pitch)
+: G4VPVParameterisation(),
+  fRotation(new G4RotationMatrix())
+{
+  // Same turn as the single pinhole's cone
+  fRotation->rotateX(90.*deg);
+
+  G4double x0 = -0.5*(pattern.GetColumns() - 1)*pitch;
+  G4double z0 = -0.5*(pattern.GetRows() - 1)*pitch;
+  for (G4int i = 0; i < pattern.GetRows(); i++) {
+    for (G4int j = 0; j < pattern.GetColumns(); j++) {
+      if (pattern.IsOpen(i, j)) {
+        fPositions.push_back(G4ThreeVector(x0 + j*pitch, 0., z0 + i*pitch));
+      }
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MaskParameterisation::~MaskParameterisation()
+{
+  delete fRotation;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void MaskParameterisation::ComputeTransformation(const G4int copyNo,
+                                                 G4VPhysicalVolume* physVol) const
+{
+  physVol->SetTranslation(fPositions[copyNo]);
+  physVol->SetRotation(fRotation);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,113 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file MaskPattern.cc
+/// \brief Implementation of the MaskPattern class
+
+#include "MaskPattern.hh"
+
+#include <fstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+MaskPattern::MaskPattern()
+: fRows(0),
+  fColumns(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool MaskPattern::IsMURARank(int rank)
+{
+  if (rank < 5 || rank % 4 != 1) return false;
+  for (int d = 3; d*d <= rank; d += 2) {
+    if (rank % d == 0) return false;
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool MaskPattern::MakeMURA(int rank, MaskPattern& pattern)
+{
+  if (!IsMURARank(rank)) return false;
+
+  // Legendre symbol of every residue: +1 for the quadratic residues
+  std::vector<int> symbol(rank, -1);
+  for (long k = 1; k < rank; k++) symbol[(k*k) % rank] = 1;
+
+  pattern.fRows = rank;
+  pattern.fColumns = rank;
+  pattern.fOpen.assign(size_t(rank)*rank, 0);
+  for (int i = 1; i < rank; i++) {
+    pattern.fOpen[size_t(i)*rank] = 1;
+    for (int j = 1; j < rank; j++) {
+      pattern.fOpen[size_t(i)*rank + j] = symbol[i]*symbol[j] == 1;
+    }
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool MaskPattern::FromFile(const std::string& fileName, MaskPattern& pattern)
+{
+  std::ifstream file(fileName.c_str());
+  if (!file) return false;
+
+  int columns = 0;
+  std::vector<char> open;
+  std::string line;
+  while (std::getline(file, line)) {
+    std::string row;
+    for (size_t k = 0; k < line.size() && line[k] != '#'; k++) {
+      if (line[k] == '0' || line[k] == '1') row += line[k];
+      else if (line[k] != ' ' && line[k] != '\t' && line[k] != '\r') {
+        return false;
+      }
+    }
+    if (row.empty()) continue;
+    if (columns == 0) columns = int(row.size());
+    if (int(row.size()) != columns) return false;
+    for (size_t k = 0; k < row.size(); k++) open.push_back(row[k] == '1');
+  }
+  if (open.empty()) return false;
+
+  pattern.fRows = int(open.size())/columns;
+  pattern.fColumns = columns;
+  pattern.fOpen.swap(open);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int MaskPattern::GetNumberOfOpen() const
+{
+  int n = 0;
+  for (size_t k = 0; k < fOpen.size(); k++) n += fOpen[k];
+  return n;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,143 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file OutputFile.cc
+/// \brief Implementation of the OutputFile class
+
+#include "OutputFile.hh"
+
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace
+{
+  G4bool FileExists(const G4String& fileName)
+  {
+    struct stat info;
+    return stat(fileName.c_str(), &info) == 0;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputFile::OutputFile(const G4String& stem, const G4String& extension)
+: fStem(stem),
+  fExtension(extension),
+  fPerThread(false),
+  fThread(0),
+  fRotateBytes(0),
+  fSequence(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputFile::~OutputFile()
+{
+  Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputFile::Open(const G4String& directory, G4bool perThread,
+                      G4int thread, long rotateBytes)
+{
+  Close();
+  if (directory != fDirectory) fSequence = 0;
+  fDirectory   = directory;
+  fPerThread   = perThread;
+  fThread      = thread;
+  fRotateBytes = perThread ? rotateBytes : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputFile::EndEvent()
+{
+  if (!fPerThread) {
+    // One write of the whole event to the unbuffered, appending file
+    const std::string& rows = fEvent.str();
+    if (rows.empty()) return;
+    if (!fStream.is_open()) OpenNext();
+    fStream.write(rows.data(), rows.size());
+    fEvent.str("");
+  }
+  else if (fStream.is_open() && fRotateBytes > 0
+           && long(fStream.tellp()) >= fRotateBytes) {
+    Complete();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputFile::Close()
+{
+  // Rows of an event that was not ended
+  if (!fPerThread) EndEvent();
+  if (!fStream.is_open()) return;
+  if (fPerThread) Complete();
+  else            fStream.close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputFile::OpenNext()
+{
+  if (!fPerThread) {
+    // Unbuffered: a write is passed to the file as it is
+    fFileName = fDirectory + "/" + fStem + fExtension;
+    fStream.rdbuf()->pubsetbuf(0, 0);
+    fStream.open(fFileName.c_str(), std::ios_base::app);
+  }
+  else {
+    // Numbers of a resumed run continue after the files already there
+    do {
+      std::ostringstream name;
+      name << fDirectory << "/" << fStem << ".t" << fThread << "."
+           << std::setw(3) << std::setfill('0') << fSequence++ << fExtension;
+      fFileName = name.str();
+    } while (FileExists(fFileName) || FileExists(fFileName + ".part"));
+    fStream.open((fFileName + ".part").c_str(), std::ios_base::trunc);
+  }
+
+  // Rows are dropped rather than the run aborted, as before
+  if (!fStream.is_open()) {
+    G4cerr << "OutputFile: could not open " << fFileName << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputFile::Complete()
+{
+  fStream.close();
+  G4String part = fFileName + ".part";
+  if (std::rename(part.c_str(), fFileName.c_str()) != 0) {
+    G4cerr << "OutputFile: could not rename " << part << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
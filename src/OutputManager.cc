@@ -0,0 +1,197 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file OutputManager.cc
+/// \brief Implementation of the OutputManager class
+
+#include "OutputManager.hh"
+#include "OutputMessenger.hh"
+#include "DetectorConstruction.hh"
+#include "ResultCache.hh"
+
+#include "G4RunManager.hh"
+
+#include <cerrno>
+#include <cstdio>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+OutputManager* OutputManager::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputManager* OutputManager::Instance()
+{
+  if (!fgInstance) fgInstance = new OutputManager();
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputManager::OutputManager()
+: fMessenger(0),
+  fRoot("../analysis/data"),
+  fPerRun(false),
+  fRotateBytes(0),
+  fRunDirectory(fRoot),
+  fHold(false),
+  fClaimed(false)
+{
+  fMessenger = new OutputMessenger(this);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputManager::~OutputManager()
+{
+  delete fMessenger;
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputManager::SetRootDirectory(const G4String& directory)
+{
+  // Trailing slashes would only double up in the paths
+  fRoot = directory;
+  while (fRoot.size() > 1 && fRoot[fRoot.size() - 1] == '/') {
+    fRoot.erase(fRoot.size() - 1);
+  }
+  if (!fPerRun) fRunDirectory = fRoot;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputManager::BeginRun(G4int runID)
+{
+  mkdir(fRoot.c_str(), 0755);
+  if (!fPerRun) {
+    fRunDirectory = fRoot;
+    return;
+  }
+  if (fHold && fClaimed) return;
+
+  std::ostringstream base;
+  base << fRoot << "/run" << std::setw(4) << std::setfill('0') << runID
+       << "_" << ConfigHash();
+
+  // mkdir either creates the directory or fails, never both for two jobs
+  for (G4int i = 0; ; i++) {
+    std::ostringstream name;
+    name << base.str();
+    if (i > 0) name << "-" << i;
+    if (mkdir(name.str().c_str(), 0755) == 0) {
+      fRunDirectory = name.str();
+      break;
+    }
+    if (errno != EEXIST) {
+      G4String message = "Cannot create " + name.str()
+                       + ", the run writes to " + fRoot + " instead.";
+      G4Exception("OutputManager::BeginRun()", "Output001", JustWarning,
+                  message.c_str());
+      fRunDirectory = fRoot;
+      break;
+    }
+  }
+  fClaimed = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String OutputManager::ConfigHash() const
+{
+  const DetectorConstruction* detector
+    = static_cast<const DetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  uint64_t hash = ResultCache::Hash("");
+  if (detector) hash = ResultCache::HashFile(detector->GetConfigFileName());
+  return ResultCache::ToHex(hash).substr(8);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<std::pair<G4String, long> >
+OutputManager::GetCheckpointFiles() const
+{
+  std::vector<std::pair<G4String, long> > files;
+  if (!fPerRun) {
+    const char* kStreams[] = { "hits.csv", "init_pos.csv", "tracks.csv",
+                               "digis.csv" };
+    for (size_t i = 0; i < sizeof(kStreams)/sizeof(kStreams[0]); i++) {
+      G4String name = GetJobPath(kStreams[i]);
+      struct stat info;
+      long size = stat(name.c_str(), &info) == 0 ? long(info.st_size) : 0;
+      files.push_back(std::make_pair(name, size));
+    }
+    return files;
+  }
+
+  // Files still named .part belong to the chunk in progress
+  G4String held = GetHeldDirectory();
+  if (held.empty()) return files;
+  DIR* dir = opendir(held.c_str());
+  if (!dir) return files;
+  while (dirent* entry = readdir(dir)) {
+    G4String name = entry->d_name;
+    G4String path = held + "/" + name;
+    struct stat info;
+    if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode)) continue;
+    if (name.size() > 5 && name.substr(name.size() - 5) == ".part") continue;
+    files.push_back(std::make_pair(path, long(info.st_size)));
+  }
+  closedir(dir);
+  return files;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputManager::Resume(const G4String& runDirectory,
+                           const std::vector<std::pair<G4String, long> >& files)
+{
+  if (!fPerRun || runDirectory.empty()) return;
+  fRunDirectory = runDirectory;
+  fClaimed = true;
+
+  std::set<G4String> kept;
+  for (size_t i = 0; i < files.size(); i++) kept.insert(files[i].first);
+
+  DIR* dir = opendir(fRunDirectory.c_str());
+  if (!dir) return;
+  std::vector<G4String> lost;
+  while (dirent* entry = readdir(dir)) {
+    G4String path = fRunDirectory + "/" + entry->d_name;
+    struct stat info;
+    if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)
+        && kept.find(path) == kept.end()) lost.push_back(path);
+  }
+  closedir(dir);
+  for (size_t i = 0; i < lost.size(); i++) std::remove(lost[i].c_str());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
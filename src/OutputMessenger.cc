@@ -0,0 +1,96 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file OutputMessenger.cc
+/// \brief Implementation of the OutputMessenger class
+
+#include "OutputMessenger.hh"
+#include "OutputManager.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADouble.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputMessenger::OutputMessenger(OutputManager* manager)
+: G4UImessenger(),
+  fManager(manager)
+{
+  fOutputDir = new G4UIdirectory("/pinhole/output/", false);
+  fOutputDir->SetGuidance("Output directory layout.");
+
+  fDirectoryCmd = new G4UIcmdWithAString("/pinhole/output/directory", this);
+  fDirectoryCmd->SetGuidance("Output root, ../analysis/data by default.");
+  fDirectoryCmd->SetParameterName("directory", false);
+  fDirectoryCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fDirectoryCmd->SetToBeBroadcasted(false);
+
+  fPerRunCmd = new G4UIcmdWithABool("/pinhole/output/perRun", this);
+  fPerRunCmd->SetGuidance("Write every run to its own directory in the root,");
+  fPerRunCmd->SetGuidance("run<ID>_<config hash>, with one set of event");
+  fPerRunCmd->SetGuidance("files per thread instead of shared ones.");
+  fPerRunCmd->SetParameterName("perRun", true);
+  fPerRunCmd->SetDefaultValue(true);
+  fPerRunCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fPerRunCmd->SetToBeBroadcasted(false);
+
+  fRotateCmd = new G4UIcmdWithADouble("/pinhole/output/rotateMB", this);
+  fRotateCmd->SetGuidance("Size at which a per-thread event file is completed");
+  fRotateCmd->SetGuidance("and the next one started, 0 for no limit.");
+  fRotateCmd->SetParameterName("MB", false);
+  fRotateCmd->SetRange("MB>=0");
+  fRotateCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fRotateCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+OutputMessenger::~OutputMessenger()
+{
+  delete fDirectoryCmd;
+  delete fPerRunCmd;
+  delete fRotateCmd;
+  delete fOutputDir;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void OutputMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fDirectoryCmd) {
+    fManager->SetRootDirectory(newValue);
+  }
+  else if (command == fPerRunCmd) {
+    fManager->SetPerRun(fPerRunCmd->GetNewBoolValue(newValue));
+  }
+  else if (command == fRotateCmd) {
+    fManager->SetRotateBytes(
+      long(fRotateCmd->GetNewDoubleValue(newValue)*1024.*1024.));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,253 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file PerfCounters.cc
+/// \brief Implementation of the PerfCounters class
+
+#include "PerfCounters.hh"
+#include "Run.hh"
+
+#include "G4RunManager.hh"
+#include "G4LogicalVolume.hh"
+#include "G4ParticleDefinition.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool       PerfCounters::fgEnabled = false;
+PerfCounters PerfCounters::fgTotal;
+
+namespace
+{
+  const G4double kFirstBinEdge = 1.e-6;   // seconds
+  const G4int    kBinsPerDecade = 4;
+
+  G4bool ByTime(const std::pair<G4double, size_t>& a,
+                const std::pair<G4double, size_t>& b)
+  {
+    return a.first > b.first;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PerfCounters::PerfCounters()
+: fLastStepTime(0.),
+  fEvents(0),
+  fEventSeconds(0.),
+  fPrimarySeconds(0.),
+  fOutputSeconds(0.)
+{
+  for (G4int i = 0; i < kNTimeBins; i++) fEventTimes[i] = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PerfCounters* PerfCounters::Current()
+{
+  // No run manager in tools/bench, no run outside the event loop
+  const G4RunManager* runManager = G4RunManager::GetRunManager();
+  if (!fgEnabled || !runManager) return 0;
+  const Run* run = static_cast<const Run*>(runManager->GetCurrentRun());
+  return run ? run->GetPerf() : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::StartTrack(const G4ParticleDefinition* particle)
+{
+  fLastStepTime = Now();
+
+  for (size_t i = 0; i < fParticles.size(); i++) {
+    if (fParticles[i].particle == particle) {
+      fParticles[i].tracks++;
+      return;
+    }
+  }
+  ParticleEntry entry = { particle, particle->GetParticleName(), 1 };
+  fParticles.push_back(entry);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PerfCounters::VolumeEntry& PerfCounters::AddVolume(const G4LogicalVolume* volume)
+{
+  VolumeEntry entry = { volume, volume->GetName(), 0, 0. };
+  fVolumes.push_back(entry);
+  return fVolumes.back();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::AddEvent(G4double seconds)
+{
+  fEvents++;
+  fEventSeconds += seconds;
+
+  G4int bin = seconds > kFirstBinEdge
+            ? G4int(kBinsPerDecade*std::log10(seconds/kFirstBinEdge)) : 0;
+  fEventTimes[std::min(bin, kNTimeBins - 1)]++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::Merge(const PerfCounters& other)
+{
+  // By name: the volume and particle pointers are shared, but a merged
+  // total outlives the geometry of the run it came from
+  for (size_t i = 0; i < other.fVolumes.size(); i++) {
+    const VolumeEntry& source = other.fVolumes[i];
+    size_t j = 0;
+    while (j < fVolumes.size() && fVolumes[j].name != source.name) j++;
+    if (j == fVolumes.size()) {
+      fVolumes.push_back(source);
+      continue;
+    }
+    fVolumes[j].steps   += source.steps;
+    fVolumes[j].seconds += source.seconds;
+  }
+
+  for (size_t i = 0; i < other.fParticles.size(); i++) {
+    const ParticleEntry& source = other.fParticles[i];
+    size_t j = 0;
+    while (j < fParticles.size() && fParticles[j].name != source.name) j++;
+    if (j == fParticles.size()) fParticles.push_back(source);
+    else fParticles[j].tracks += source.tracks;
+  }
+
+  fEvents         += other.fEvents;
+  fEventSeconds   += other.fEventSeconds;
+  fPrimarySeconds += other.fPrimarySeconds;
+  fOutputSeconds  += other.fOutputSeconds;
+  for (G4int i = 0; i < kNTimeBins; i++) fEventTimes[i] += other.fEventTimes[i];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PerfCounters::BinLowEdge(G4int bin) const
+{
+  return kFirstBinEdge*std::pow(10., G4double(bin)/kBinsPerDecade);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PerfCounters::TimeQuantile(G4double fraction) const
+{
+  // Upper edge of the bin the quantile falls in
+  G4long target = G4long(std::ceil(fraction*fEvents));
+  G4long count = 0;
+  for (G4int i = 0; i < kNTimeBins; i++) {
+    count += fEventTimes[i];
+    if (count >= target) return BinLowEdge(i + 1);
+  }
+  return BinLowEdge(kNTimeBins);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::Print(std::ostream& out) const
+{
+  if (fEvents == 0) {
+    out << "No profiled events." << std::endl;
+    return;
+  }
+
+  // Times are summed over threads, shares are of the summed event time
+  std::ios_base::fmtflags flags = out.flags();
+  std::streamsize precision = out.precision();
+  out << std::fixed << std::setprecision(3);
+
+  G4double stepSeconds = 0.;
+  std::vector<std::pair<G4double, size_t> > order;
+  for (size_t i = 0; i < fVolumes.size(); i++) {
+    stepSeconds += fVolumes[i].seconds;
+    order.push_back(std::make_pair(fVolumes[i].seconds, i));
+  }
+  std::sort(order.begin(), order.end(), ByTime);
+
+  out << "Profile of " << fEvents << " events, " << fEventSeconds
+      << " s of event time over all threads" << std::endl;
+  out << "  volume                 steps     time [s]  share   ns/step"
+      << std::endl;
+  for (size_t k = 0; k < order.size(); k++) {
+    const VolumeEntry& entry = fVolumes[order[k].second];
+    out << "  " << std::left << std::setw(16) << entry.name << std::right
+        << std::setw(12) << entry.steps
+        << std::setw(13) << entry.seconds
+        << std::setw(6) << std::setprecision(1)
+        << 100.*entry.seconds/fEventSeconds << "%"
+        << std::setw(10) << std::setprecision(0)
+        << (entry.steps > 0 ? 1.e9*entry.seconds/entry.steps : 0.)
+        << std::setprecision(3) << std::endl;
+  }
+
+  out << "  tracks:";
+  for (size_t i = 0; i < fParticles.size(); i++) {
+    out << " " << fParticles[i].name << " " << fParticles[i].tracks;
+  }
+  out << std::endl;
+
+  out << "  per event: " << std::setprecision(1)
+      << 1.e6*fEventSeconds/fEvents << " us total, "
+      << 1.e6*stepSeconds/fEvents << " us stepping, "
+      << 1.e6*fOutputSeconds/fEvents << " us output, "
+      << 1.e6*fPrimarySeconds/fEvents << " us GeneratePrimaries"
+      << std::endl;
+
+  out << "  event time quantiles (bin upper edges): median "
+      << 1.e6*TimeQuantile(0.5) << " us, 90% " << 1.e6*TimeQuantile(0.9)
+      << " us, 99% " << 1.e6*TimeQuantile(0.99) << " us" << std::endl;
+  out << "  event time histogram:" << std::endl;
+  for (G4int i = 0; i < kNTimeBins; i++) {
+    if (fEventTimes[i] == 0) continue;
+    out << "    " << std::setw(12) << std::setprecision(1)
+        << 1.e6*BinLowEdge(i) << " us  " << std::setw(10) << fEventTimes[i]
+        << std::endl;
+  }
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::SetEnabled(G4bool enabled)
+{
+  // Switching on starts a new total
+  if (enabled && !fgEnabled) fgTotal = PerfCounters();
+  fgEnabled = enabled;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfCounters::Report(std::ostream& out)
+{
+  fgTotal.Print(out);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,82 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file PerfMessenger.cc
+/// \brief Implementation of the PerfMessenger class
+
+#include "PerfMessenger.hh"
+#include "PerfCounters.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithoutParameter.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PerfMessenger::PerfMessenger()
+: G4UImessenger()
+{
+  fPerfDir = new G4UIdirectory("/perf/", false);
+  fPerfDir->SetGuidance("Hot-path instrumentation of the user actions.");
+
+  fEnableCmd = new G4UIcmdWithABool("/perf/enable", this);
+  fEnableCmd->SetGuidance("Count steps and time per volume, tracks per");
+  fEnableCmd->SetGuidance("particle, primary generation and output time");
+  fEnableCmd->SetGuidance("in the following runs. Enabling clears the");
+  fEnableCmd->SetGuidance("totals shown by /perf/report.");
+  fEnableCmd->SetParameterName("enable", true);
+  fEnableCmd->SetDefaultValue(true);
+  fEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fEnableCmd->SetToBeBroadcasted(false);
+
+  fReportCmd = new G4UIcmdWithoutParameter("/perf/report", this);
+  fReportCmd->SetGuidance("Print the counters of all threads, summed over");
+  fReportCmd->SetGuidance("the runs since /perf/enable.");
+  fReportCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fReportCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PerfMessenger::~PerfMessenger()
+{
+  delete fEnableCmd;
+  delete fReportCmd;
+  delete fPerfDir;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PerfMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fEnableCmd) {
+    PerfCounters::SetEnabled(fEnableCmd->GetNewBoolValue(newValue));
+  }
+  else if (command == fReportCmd) {
+    PerfCounters::Report(G4cout);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
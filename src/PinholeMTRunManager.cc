@@ -0,0 +1,200 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file PinholeMTRunManager.cc
+/// \brief Implementation of the PinholeMTRunManager class
+
+#include "PinholeMTRunManager.hh"
+#include "SchedulerMessenger.hh"
+#include "PerfCounters.hh"
+
+#include "G4Event.hh"
+#include "G4RNGHelper.hh"
+#include "G4Threading.hh"
+
+#include <algorithm>
+#include <iomanip>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PinholeMTRunManager::PinholeMTRunManager()
+: G4MTRunManager(),
+  fMessenger(0),
+  fScheduling(kFixed),
+  fMinBatch(1),
+  fChunksPerThread(2),
+  fLoopStart(0.)
+{
+  fMessenger = new SchedulerMessenger(this);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PinholeMTRunManager::~PinholeMTRunManager()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PinholeMTRunManager::InitializeEventLoop(G4int n_event,
+                                              const char* macroFile,
+                                              G4int n_select)
+{
+  // Before the base class, which starts the workers
+  WorkerLoad idle = { 0, 0, 0. };
+  fWorkers.assign(std::max(nworkers, 1), idle);
+  fLoopStart = PerfCounters::Now();
+
+  G4MTRunManager::InitializeEventLoop(n_event, macroFile, n_select);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int PinholeMTRunManager::SetUpNEvents(G4Event* evt, G4SeedsQueue* seedsQueue,
+                                        G4bool reseedRequired)
+{
+  G4int nev = 0;
+  if (fScheduling == kFixed) {
+    nev = G4MTRunManager::SetUpNEvents(evt, seedsQueue, reseedRequired);
+  }
+  else {
+    std::lock_guard<std::mutex> lock(fSetUpMutex);
+    if (numberOfEventProcessed < numberOfEventToBeProcessed) {
+      nev = std::min(GuidedBatchSize(),
+                     numberOfEventToBeProcessed - numberOfEventProcessed);
+      evt->SetEventID(numberOfEventProcessed);
+
+      // Seeds in event order, as G4MTRunManager hands them out
+      if (reseedRequired) {
+        G4RNGHelper* helper = G4RNGHelper::GetInstance();
+        G4int nevRnd = SeedOncePerCommunication() > 0 ? 1 : nev;
+        for (G4int i = 0; i < nevRnd; i++) {
+          for (G4int k = 0; k < nSeedsPerEvent; k++) {
+            seedsQueue->push(helper->GetSeed(nSeedsPerEvent*nSeedsUsed + k));
+          }
+          nSeedsUsed++;
+          if (nSeedsUsed == nSeedsFilled) RefillSeeds();
+        }
+      }
+      numberOfEventProcessed += nev;
+    }
+  }
+
+  size_t thread = size_t(G4Threading::G4GetThreadId());
+  if (thread < fWorkers.size()) {
+    WorkerLoad& load = fWorkers[thread];
+    if (nev > 0) {
+      load.events += nev;
+      load.batches++;
+    }
+    else if (load.finished == 0.) {
+      load.finished = PerfCounters::Now();
+    }
+  }
+  return nev;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int PinholeMTRunManager::GuidedBatchSize() const
+{
+  G4int remaining = numberOfEventToBeProcessed - numberOfEventProcessed;
+  G4int chunks = std::max(fChunksPerThread, 1)*std::max(nworkers, 1);
+  G4int nev = (remaining + chunks - 1)/chunks;
+
+  // The event modulo (/run/eventModulo, or sqrt(events/threads)) stays the
+  // largest batch, so a run starts as in fixed mode
+  nev = std::min(nev, std::max(eventModulo, 1));
+  return std::max(nev, std::max(fMinBatch, 1));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PinholeMTRunManager::RunTermination()
+{
+  // Waits for the workers to end their event loop
+  G4MTRunManager::RunTermination();
+
+  if (numberOfEventToBeProcessed > 0) PrintLoad();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PinholeMTRunManager::GetIdleSeconds(G4int thread) const
+{
+  if (thread < 0 || thread >= G4int(fWorkers.size())) return 0.;
+
+  // Idle from its last event until the last thread finished
+  G4double end = fLoopStart;
+  for (size_t i = 0; i < fWorkers.size(); i++) {
+    end = std::max(end, fWorkers[i].finished);
+  }
+  const WorkerLoad& load = fWorkers[thread];
+  return load.finished > 0. ? end - load.finished : 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PinholeMTRunManager::PrintLoad() const
+{
+  G4double end = fLoopStart;
+  for (size_t i = 0; i < fWorkers.size(); i++) {
+    end = std::max(end, fWorkers[i].finished);
+  }
+  G4double loop = end - fLoopStart;
+
+  std::ios_base::fmtflags flags = G4cout.flags();
+  std::streamsize precision = G4cout.precision();
+
+  G4double idleSum = 0.;
+  G4cout << "Event scheduling ("
+         << (fScheduling == kGuided ? "guided" : "fixed") << " batches): "
+         << fWorkers.size() << " threads, "
+         << std::fixed << std::setprecision(3) << loop << " s event loop"
+         << G4endl
+         << "  thread    events   batches   idle [s]   idle share" << G4endl;
+  for (size_t i = 0; i < fWorkers.size(); i++) {
+    const WorkerLoad& load = fWorkers[i];
+    G4double idle = GetIdleSeconds(G4int(i));
+    idleSum += idle;
+    G4cout << "  " << std::setw(6) << i
+           << std::setw(10) << load.events
+           << std::setw(10) << load.batches
+           << std::setw(11) << idle
+           << std::setw(12) << std::setprecision(1)
+           << (loop > 0. ? 100.*idle/loop : 0.) << " %"
+           << std::setprecision(3) << G4endl;
+  }
+  G4double capacity = loop*fWorkers.size();
+  G4cout << "  Idle: " << idleSum << " thread-s, "
+         << std::setprecision(1) << (capacity > 0. ? 100.*idleSum/capacity : 0.)
+         << " % of the loop capacity" << G4endl;
+
+  G4cout.flags(flags);
+  G4cout.precision(precision);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,227 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file PinholeSimulation.cc
+/// \brief Implementation of the PinholeSimulation class
+
+#include "PinholeSimulation.hh"
+#include "DetectorConstruction.hh"
+#include "ActionInitialization.hh"
+#include "RunAction.hh"
+#include "EventAction.hh"
+#include "Run.hh"
+#include "AngleEstimator.hh"
+#include "SourceDefinition.hh"
+#include "ResponseBuilder.hh"
+#include "CheckpointManager.hh"
+#include "Telemetry.hh"
+#include "OutputManager.hh"
+
+#ifdef G4MULTITHREADED
+#include "PinholeMTRunManager.hh"
+#else
+#include "G4RunManager.hh"
+#include "SchedulerMessenger.hh"
+#endif
+
+#include "G4UImanager.hh"
+#include "G4PhysListFactory.hh"
+#include "G4VModularPhysicsList.hh"
+#include "G4ProductionCutsTable.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <chrono>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PinholeSimulation* PinholeSimulation::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PinholeSimulation::GetLowEnergyLimit()
+{
+  return 250.*eV;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double PinholeSimulation::GetHighEnergyLimit()
+{
+  return 100.*GeV;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PinholeSimulation::PinholeSimulation(G4int nThreads)
+: fRunManager(0),
+  fDetector(0),
+  fSource(0),
+  fSchedulerMessenger(0),
+  fInitialized(false),
+  fHits(new HitBuffer)
+{
+  if (fgInstance) {
+    G4Exception("PinholeSimulation::PinholeSimulation()", "Simulation001",
+                FatalException, "Only one simulation per process.");
+    return;
+  }
+  fgInstance = this;
+
+  Summary empty = { -1, 0, 0, 0, 0., false, 0., 0., 0., 0. };
+  fSummary = empty;
+
+  // Choose the Random engine
+  G4Random::setTheEngine(new CLHEP::RanecuEngine);
+
+#ifdef G4MULTITHREADED
+  PinholeMTRunManager* runManager = new PinholeMTRunManager;
+  runManager->SetNumberOfThreads(nThreads);
+  fRunManager = runManager;
+#else
+  (void)nThreads;
+  fRunManager = new G4RunManager;
+  fSchedulerMessenger = new SchedulerMessenger(0);
+#endif
+
+  G4PhysListFactory factory;
+  G4VModularPhysicsList* physicsList
+    = factory.GetReferencePhysList(GetPhysicsListName());
+  physicsList->SetVerboseLevel(1);
+  fDetector = new DetectorConstruction();
+  fRunManager->SetUserInitialization(fDetector);
+  fRunManager->SetUserInitialization(physicsList);
+  fRunManager->SetUserInitialization(new ActionInitialization());
+
+  G4ProductionCutsTable::GetProductionCutsTable()
+    ->SetEnergyRange(GetLowEnergyLimit(), GetHighEnergyLimit());
+
+  // Job-wide singletons, owned by the master thread
+  OutputManager::Instance();
+  fSource = SourceDefinition::Instance();
+  ResponseBuilder::Instance();
+  CheckpointManager::Instance();
+  Telemetry::Instance();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PinholeSimulation::~PinholeSimulation()
+{
+  if (fgInstance != this) return;
+
+  // User actions, physics list and detector construction are owned and
+  // deleted by the run manager
+  delete fRunManager;
+  delete fSchedulerMessenger;
+  delete Telemetry::Instance();
+  delete CheckpointManager::Instance();
+  delete ResponseBuilder::Instance();
+  delete fSource;
+  delete OutputManager::Instance();
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int PinholeSimulation::Execute(const G4String& command)
+{
+  return G4UImanager::GetUIpointer()->ApplyCommand(command);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PinholeSimulation::SetGeometryFile(const G4String& fileName)
+{
+  fDetector->SetConfigFileName(fileName);
+  if (fInitialized) fRunManager->ReinitializeGeometry(true);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PinholeSimulation::SetKeepHits(G4bool keep)
+{
+  RunAction::SetHitBufferEnabled(keep);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PinholeSimulation::SetFileOutput(G4bool write)
+{
+  EventAction::SetWriteFiles(write);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PinholeSimulation::Initialize()
+{
+  if (fInitialized) return;
+  fRunManager->Initialize();
+  fInitialized = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const PinholeSimulation::Summary& PinholeSimulation::BeamOn(G4int nEvents)
+{
+  Initialize();
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  fRunManager->BeamOn(nEvents);
+
+  Summary summary = { -1, 0, 0, 0, 0., false, 0., 0., 0., 0. };
+  summary.seconds = std::chrono::duration<G4double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  // The merged master run lives until the next run starts
+  Run* run = static_cast<Run*>(fRunManager->GetNonConstCurrentRun());
+  HitBuffer* hits = new HitBuffer;
+  if (run) {
+    summary.runID  = run->GetRunID();
+    summary.events = run->GetNumberOfEvent();
+
+    const RunAction* runAction
+      = static_cast<const RunAction*>(fRunManager->GetUserRunAction());
+    if (runAction) summary.acceptedEvents = runAction->GetAcceptedEvents();
+
+    if (run->GetHitBuffer()) hits->swap(*run->GetHitBuffer());
+
+    const AngleEstimator* estimator = run->GetEstimator();
+    if (estimator && estimator->GetEntries() > 1) {
+      summary.hasEstimate = true;
+      summary.theta      = estimator->GetThetaMedian();
+      summary.thetaError = estimator->GetThetaMedianError();
+      summary.phi        = estimator->GetPhiMedian();
+      summary.phiError   = estimator->GetPhiMedianError();
+    }
+  }
+  summary.hits = hits->size();
+
+  fHits.reset(hits);
+  fSummary = summary;
+  return fSummary;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
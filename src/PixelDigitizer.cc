@@ -0,0 +1,161 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file PixelDigitizer.cc
+/// \brief Implementation of the PixelDigitizer class
+
+#include "PixelDigitizer.hh"
+#include "PixelDigi.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+
+// A 100 um pixel sensor with typical silicon diffusion and noise
+G4bool   PixelDigitizer::fgEnabled   = false;
+G4double PixelDigitizer::fgPitch     = 100.*um;
+G4bool   PixelDigitizer::fgStrips    = false;
+G4double PixelDigitizer::fgDiffusion = 8.*um;
+G4double PixelDigitizer::fgNoise     = 1.*keV;
+G4double PixelDigitizer::fgThreshold = 5.*keV;
+
+namespace
+{
+  // Width of the cloud that is shared out, beyond it less than 1e-4 is lost
+  const G4double kReach = 4.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PixelDigitizer::PixelDigitizer()
+: G4VDigitizerModule("PixelDigitizer"),
+  fXmin(0.),
+  fZmin(0.),
+  fPitch(fgPitch)
+{
+  collectionName.push_back("PixelDigis");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PixelDigitizer::~PixelDigitizer()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PixelDigitizer::Digitize()
+{
+  const DetectorConstruction* detector
+    = static_cast<const DetectorConstruction*>(
+        G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+
+  // Channel grid over detector1, with the readout on its +y face
+  fPitch = fgPitch;
+  fXmin  = -detector->GetDetectorHalfX();
+  fZmin  = -detector->GetDetectorHalfZ();
+  G4int nx = G4int(std::ceil(-2.*fXmin/fPitch));
+  G4int nz = fgStrips ? 1 : G4int(std::ceil(-2.*fZmin/fPitch));
+  G4double thickness = detector->GetLayerThickness(0);
+  G4double face      = detector->GetLayerPosition(0) + 0.5*thickness;
+
+  // Cloud widths of all deposits; a floor keeps the error function finite
+  size_t n = fEdep.size();
+  fSigma.resize(n);
+  G4double scale    = fgDiffusion/std::sqrt(thickness);
+  G4double minSigma = 1.e-3*fPitch;
+  for (size_t i = 0; i < n; i++) {
+    G4double drift = std::max(face - fY[i], 0.);
+    fSigma[i] = std::max(scale*std::sqrt(drift), minSigma);
+  }
+
+  // Charge per channel, as (channel, charge) pairs merged below
+  fCharges.clear();
+  for (size_t i = 0; i < n; i++) {
+    G4int firstX = 0, firstZ = 0;
+    Share(fX[i], fSigma[i], fXmin, nx, fFractionsX, firstX);
+    if (fgStrips) fFractionsZ.assign(1, 1.);
+    else Share(fZ[i], fSigma[i], fZmin, nz, fFractionsZ, firstZ);
+
+    for (size_t b = 0; b < fFractionsZ.size(); b++) {
+      G4double chargeZ = fEdep[i]*fFractionsZ[b];
+      G4int row = (firstZ + G4int(b))*nx + firstX;
+      for (size_t a = 0; a < fFractionsX.size(); a++) {
+        fCharges.push_back(std::make_pair(row + G4int(a),
+                                          chargeZ*fFractionsX[a]));
+      }
+    }
+  }
+  std::sort(fCharges.begin(), fCharges.end());
+
+  // Noise and threshold per channel
+  PixelDigiCollection* digis
+    = new PixelDigiCollection(moduleName, collectionName[0]);
+  for (size_t i = 0; i < fCharges.size(); ) {
+    G4int channel = fCharges[i].first;
+    G4double charge = 0.;
+    for ( ; i < fCharges.size() && fCharges[i].first == channel; i++) {
+      charge += fCharges[i].second;
+    }
+    G4double signal = charge;
+    if (fgNoise > 0.) signal += G4RandGauss::shoot(0., fgNoise);
+    if (signal < fgThreshold) continue;
+    digis->insert(new PixelDigi(channel % nx, channel / nx, charge, signal));
+  }
+  StoreDigiCollection(digis);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PixelDigitizer::Share(G4double u, G4double sigma, G4double min,
+                           G4int nChannels, std::vector<G4double>& fractions,
+                           G4int& first)
+{
+  fractions.clear();
+  G4double reach = kReach*sigma;
+  G4int lo = std::max(G4int(std::floor((u - reach - min)/fPitch)), 0);
+  G4int hi = std::min(G4int(std::floor((u + reach - min)/fPitch)),
+                      nChannels - 1);
+  if (hi < lo) return;
+  first = lo;
+
+  // Error function at the channel edges, then the differences
+  G4int nEdges = hi - lo + 2;
+  G4double scale = 1./(std::sqrt(2.)*sigma);
+  G4double start = min + lo*fPitch - u;
+  fEdges.resize(nEdges);
+  for (G4int k = 0; k < nEdges; k++) {
+    fEdges[k] = std::erf((start + k*fPitch)*scale);
+  }
+  fractions.resize(nEdges - 1);
+  for (G4int k = 0; k < nEdges - 1; k++) {
+    fractions[k] = 0.5*(fEdges[k + 1] - fEdges[k]);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
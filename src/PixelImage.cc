@@ -0,0 +1,167 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file PixelImage.cc
+/// \brief Implementation of the PixelImage class
+
+#include "PixelImage.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <new>
+
+namespace
+{
+  const G4int kCacheLine = 64;
+
+  G4double* AllocateAligned(size_t n)
+  {
+    void* buffer = 0;
+    if (posix_memalign(&buffer, kCacheLine, n*sizeof(G4double)) != 0) {
+      throw std::bad_alloc();
+    }
+    std::memset(buffer, 0, n*sizeof(G4double));
+    return static_cast<G4double*>(buffer);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PixelImage::PixelImage(G4int nx, G4int nz, G4double xmin, G4double zmin,
+                       G4double pitch)
+: fNx(nx),
+  fNz(nz),
+  fStride(0),
+  fXmin(xmin),
+  fZmin(zmin),
+  fPitch(pitch),
+  fInvPitch(1./pitch),
+  fCounts(0),
+  fEdep(0)
+{
+  const G4int perLine = kCacheLine/sizeof(G4double);
+  fStride = ((fNx + perLine - 1)/perLine)*perLine;
+
+  fCounts = AllocateAligned(size_t(fStride)*fNz);
+  fEdep   = AllocateAligned(size_t(fStride)*fNz);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+PixelImage::~PixelImage()
+{
+  std::free(fCounts);
+  std::free(fEdep);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PixelImage::Add(const PixelImage& other)
+{
+  if (other.fNx != fNx || other.fNz != fNz) {
+    G4Exception("PixelImage::Add()", "PixelImage001", JustWarning,
+                "Images with different grids cannot be merged.");
+    return;
+  }
+
+  const size_t n = size_t(fStride)*fNz;
+  for (size_t i = 0; i < n; i++) {
+    fCounts[i] += other.fCounts[i];
+    fEdep[i]   += other.fEdep[i];
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PixelImage::Reset()
+{
+  const size_t n = size_t(fStride)*fNz;
+  std::memset(fCounts, 0, n*sizeof(G4double));
+  std::memset(fEdep, 0, n*sizeof(G4double));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PixelImage::Write(std::ostream& out) const
+{
+  const size_t n = size_t(fStride)*fNz;
+  out.write(reinterpret_cast<const char*>(&fNx), sizeof(fNx));
+  out.write(reinterpret_cast<const char*>(&fNz), sizeof(fNz));
+  out.write(reinterpret_cast<const char*>(fCounts), n*sizeof(G4double));
+  out.write(reinterpret_cast<const char*>(fEdep), n*sizeof(G4double));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PixelImage::Read(std::istream& in)
+{
+  G4int nx = 0, nz = 0;
+  in.read(reinterpret_cast<char*>(&nx), sizeof(nx));
+  in.read(reinterpret_cast<char*>(&nz), sizeof(nz));
+  if (!in || nx != fNx || nz != fNz) return false;
+
+  const size_t n = size_t(fStride)*fNz;
+  in.read(reinterpret_cast<char*>(fCounts), n*sizeof(G4double));
+  in.read(reinterpret_cast<char*>(fEdep), n*sizeof(G4double));
+  return bool(in);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool PixelImage::WriteNpy(const G4String& fileName) const
+{
+  std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+  if (!file.is_open()) return false;
+
+  // NPY format 1.0, little-endian doubles, C order, no row padding
+  std::ostringstream header;
+  header << "{'descr': '<f8', 'fortran_order': False, 'shape': (2, "
+         << fNz << ", " << fNx << "), }";
+  G4String dict = header.str();
+  size_t total = 10 + dict.size() + 1;
+  dict.append((64 - total % 64) % 64, ' ');
+  dict += '\n';
+
+  unsigned short headerLength = (unsigned short)dict.size();
+  file.write("\x93NUMPY\x01\x00", 8);
+  char lengthBytes[2] = { char(headerLength & 0xff), char(headerLength >> 8) };
+  file.write(lengthBytes, 2);
+  file.write(dict.data(), dict.size());
+
+  for (G4int iz = 0; iz < fNz; iz++) {
+    file.write(reinterpret_cast<const char*>(fCounts + size_t(iz)*fStride),
+               fNx*sizeof(G4double));
+  }
+  for (G4int iz = 0; iz < fNz; iz++) {
+    file.write(reinterpret_cast<const char*>(fEdep + size_t(iz)*fStride),
+               fNx*sizeof(G4double));
+  }
+
+  return file.good();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
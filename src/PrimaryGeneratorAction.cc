@@ -29,28 +29,45 @@
 /// \brief Implementation of the PrimaryGeneratorAction class
 
 #include "PrimaryGeneratorAction.hh"
+#include "SourceDefinition.hh"
+#include "PerfCounters.hh"
 
 #include "G4LogicalVolumeStore.hh"
 #include "G4LogicalVolume.hh"
 #include "G4Box.hh"
 #include "G4RunManager.hh"
+#include "G4Run.hh"
 // #include "G4ParticleGun.hh"
 #include "G4GeneralParticleSource.hh"
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4PhysicalConstants.hh"
 #include "G4UnitsTable.hh"
+#include "G4Event.hh"
 #include "Randomize.hh"
 
+#include <cmath>
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 PrimaryGeneratorAction::PrimaryGeneratorAction()
 : G4VUserPrimaryGeneratorAction(),
-  fParticleGun(0)
+  fParticleGun(0),
+  fSharedSourceGun(0),
+  fSourceDefinition(SourceDefinition::Instance()),
+  fBlockNext(0),
+  fBlockRunID(-1)
 {
-  // G4int n_particle = 1;
-  fParticleGun  = new G4GeneralParticleSource();
-
+  // Only the sampling state lives in the thread when the shared source is
+  // enabled, otherwise every thread carries its own GPS
+  if (fSourceDefinition->IsEnabled()) {
+    fSharedSourceGun  = new G4ParticleGun(1);
+  }
+  else {
+    // G4int n_particle = 1;
+    fParticleGun  = new G4GeneralParticleSource();
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -58,6 +75,7 @@ PrimaryGeneratorAction::PrimaryGeneratorAction()
 PrimaryGeneratorAction::~PrimaryGeneratorAction()
 {
   delete fParticleGun;
+  delete fSharedSourceGun;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -66,8 +84,129 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
   //this function is called at the begining of each event
 
-  fParticleGun->GeneratePrimaryVertex(anEvent);
+  PerfCounters* perf = PerfCounters::Current();
+  G4double startTime = perf ? PerfCounters::Now() : 0.;
+
+  if (fSourceDefinition->IsEnabled()) {
+    GenerateFromSharedSource(anEvent);
+  }
+  else {
+    fParticleGun->GeneratePrimaryVertex(anEvent);
+  }
+
+  if (perf) perf->AddPrimaryTime(PerfCounters::Now() - startTime);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void PrimaryGeneratorAction::GenerateFromSharedSource(G4Event* anEvent)
+{
+  const SourceDefinition* source = fSourceDefinition;
+
+  // Enabled after this action was built (e.g. sequential mode)
+  if (!fSharedSourceGun) fSharedSourceGun = new G4ParticleGun(1);
+
+  fSharedSourceGun->SetParticleDefinition(source->GetParticleDefinition());
+  fSharedSourceGun->SetParticleMomentumDirection(source->GetDirection());
+
+  G4int blockSize = source->GetBlockSize();
+  if (blockSize > 0) {
+    // A new run may follow a change of the source, so never carry a block over
+    // No run manager in tools/bench
+    const G4RunManager* runManager = G4RunManager::GetRunManager();
+    const G4Run* run = runManager ? runManager->GetCurrentRun() : 0;
+    G4int runID = run ? run->GetRunID() : -1;
+    if (fBlockNext >= fBlockX.size() || runID != fBlockRunID) {
+      FillBlock(blockSize);
+      fBlockRunID = runID;
+    }
+
+    fSharedSourceGun->SetParticlePosition(G4ThreeVector(fBlockX[fBlockNext],
+                                                        fBlockY[fBlockNext],
+                                                        fBlockZ[fBlockNext]));
+    fSharedSourceGun->SetParticleEnergy(fBlockEnergy[fBlockNext]);
+    ++fBlockNext;
+
+    fSharedSourceGun->GeneratePrimaryVertex(anEvent);
+    return;
+  }
+
+  // Beam/Circle position: uniform disc followed by a gaussian smear,
+  // as in G4SPSPosDistribution::GeneratePointsInBeam()
+  G4double radius = source->GetRadius();
+  G4double x = 0., y = 0.;
+  if (radius > 0.) {
+    do {
+      x = (2.*G4UniformRand() - 1.)*radius;
+      y = (2.*G4UniformRand() - 1.)*radius;
+    } while (x*x + y*y > radius*radius);
+  }
+
+  // sigma_r is the radial width: GPS smears each axis by sigma_r/sqrt(2)
+  // (G4SPSPosDistribution::SetBeamSigmaInR)
+  G4double sigma = source->GetSigmaR()/std::sqrt(2.);
+  if (sigma > 0.) {
+    x += G4RandGauss::shoot(0., sigma);
+    y += G4RandGauss::shoot(0., sigma);
+  }
+
+  G4ThreeVector position = source->GetCentre()
+                         + x*source->GetAxisX() + y*source->GetAxisY();
+
+  fSharedSourceGun->SetParticlePosition(position);
+  fSharedSourceGun->SetParticleEnergy(source->SampleEnergy(G4UniformRand()));
+
+  fSharedSourceGun->GeneratePrimaryVertex(anEvent);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void PrimaryGeneratorAction::FillBlock(size_t n)
+{
+  const SourceDefinition* source = fSourceDefinition;
+
+  fBlockX.resize(n);
+  fBlockY.resize(n);
+  fBlockZ.resize(n);
+  fBlockEnergy.resize(n);
+  fUniform.resize(5*n);
+  fBlockNext = 0;
+
+  // All the random numbers of the block in one call: per primary two for
+  // the disc, two for the smear and one for the energy
+  G4Random::getTheEngine()->flatArray(G4int(5*n), &fUniform[0]);
+  const G4double* u = &fUniform[0];
+
+  // Uniform disc by inverse transform rather than rejection, the same
+  // distribution as GeneratePrimaryVertex() without the data-dependent loop,
+  // then a Box-Muller gaussian smear of both coordinates by sigma_r/sqrt(2)
+  // each, as GPS does
+  G4double radius = source->GetRadius();
+  G4double sigma = source->GetSigmaR()/std::sqrt(2.);
+  for (size_t i = 0; i < n; ++i) {
+    G4double r   = radius*std::sqrt(u[i]);
+    G4double phi = twopi*u[n + i];
+    G4double rho = sigma*std::sqrt(-2.*std::log(1. - u[2*n + i]));
+    G4double psi = twopi*u[3*n + i];
+    fBlockX[i] = r*std::cos(phi) + rho*std::cos(psi);
+    fBlockY[i] = r*std::sin(phi) + rho*std::sin(psi);
+  }
+
+  // Local disc coordinates to the world frame
+  const G4ThreeVector& centre = source->GetCentre();
+  const G4ThreeVector& axisX = source->GetAxisX();
+  const G4ThreeVector& axisY = source->GetAxisY();
+  for (size_t i = 0; i < n; ++i) {
+    G4double x = fBlockX[i];
+    G4double y = fBlockY[i];
+    fBlockX[i] = centre.x() + x*axisX.x() + y*axisY.x();
+    fBlockY[i] = centre.y() + x*axisX.y() + y*axisY.y();
+    fBlockZ[i] = centre.z() + x*axisX.z() + y*axisY.z();
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    fBlockEnergy[i] = source->SampleEnergy(u[4*n + i]);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,204 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file ResponseBuilder.cc
+/// \brief Implementation of the ResponseBuilder class
+
+#include "ResponseBuilder.hh"
+#include "ResponseMessenger.hh"
+#include "DetectorConstruction.hh"
+#include "SourceDefinition.hh"
+#include "PixelImage.hh"
+
+#include "G4RunManager.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+
+ResponseBuilder* ResponseBuilder::fgInstance = 0;
+
+namespace
+{
+  void FillAxis(std::vector<G4double>& axis, G4int n, G4double min,
+                G4double max, G4bool logarithmic)
+  {
+    axis.resize(n > 0 ? n : 1);
+    for (G4int i = 0; i < G4int(axis.size()); i++) {
+      G4double f = axis.size() > 1 ? G4double(i)/(axis.size() - 1) : 0.;
+      axis[i] = logarithmic ? min*std::pow(max/min, f) : min + f*(max - min);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ResponseBuilder* ResponseBuilder::Instance()
+{
+  if (!fgInstance) fgInstance = new ResponseBuilder();
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ResponseBuilder::ResponseBuilder()
+: fMessenger(0),
+  fEventsPerNode(10000),
+  fCollecting(false),
+  fTheta(0),
+  fPhi(0),
+  fEnergy(0)
+{
+  // Defaults: the run_over_angles scan at 100 keV
+  FillAxis(fThetas, 41, -20., 20., false);
+  FillAxis(fPhis, 1, 0., 0., false);
+  FillAxis(fEnergies, 1, 100., 100., true);
+
+  fMessenger = new ResponseMessenger(this);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ResponseBuilder::~ResponseBuilder()
+{
+  delete fMessenger;
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseBuilder::SetThetaAxis(G4int n, G4double min, G4double max)
+{
+  FillAxis(fThetas, n, min/deg, max/deg, false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseBuilder::SetPhiAxis(G4int n, G4double min, G4double max)
+{
+  FillAxis(fPhis, n, min/deg, max/deg, false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseBuilder::SetEnergyAxis(G4int n, G4double min, G4double max)
+{
+  // Log-spaced, the response varies with log(E)
+  FillAxis(fEnergies, n, min/keV, max/keV, true);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseBuilder::Build(const G4String& fileName)
+{
+  G4RunManager* runManager = G4RunManager::GetRunManager();
+  const DetectorConstruction* detector
+    = static_cast<const DetectorConstruction*>
+        (runManager->GetUserDetectorConstruction());
+
+  if (detector->GetReadoutPitch() <= 0.) {
+    G4cerr << "ResponseBuilder: set /pinhole/readout/pitch before building"
+           << " a response library" << G4endl;
+    return;
+  }
+
+  SourceDefinition* source = SourceDefinition::Instance();
+  G4bool        wasEnabled = source->IsEnabled();
+  G4ThreeVector centre     = source->GetCentre();
+  G4ThreeVector direction  = source->GetDirection();
+
+  // Beam aimed at the window centre, as generateAutoRunFile() does
+  G4double sourceY  = centre.y();
+  G4double distance = std::abs(sourceY + detector->GetWindowGap());
+
+  G4cout << "ResponseBuilder: " << fThetas.size() << " x " << fPhis.size()
+         << " x " << fEnergies.size() << " nodes, " << fEventsPerNode
+         << " events each" << G4endl;
+
+  source->SetEnabled(true);
+  fLibrary.Close();
+  fCollecting = true;
+
+  for (fTheta = 0; fTheta < G4int(fThetas.size()); fTheta++) {
+    for (fPhi = 0; fPhi < G4int(fPhis.size()); fPhi++) {
+      for (fEnergy = 0; fEnergy < G4int(fEnergies.size()); fEnergy++) {
+        G4double tanTheta = std::tan(fThetas[fTheta]*deg);
+        G4double tanPhi   = std::tan(fPhis[fPhi]*deg);
+        source->SetCentre(G4ThreeVector(distance*tanPhi, sourceY,
+                                        distance*tanTheta));
+        source->SetDirection(G4ThreeVector(-tanPhi, 1., -tanTheta));
+        source->SetMonoEnergy(fEnergies[fEnergy]*keV);
+
+        runManager->BeamOn(fEventsPerNode);
+      }
+    }
+  }
+
+  fCollecting = false;
+  source->SetEnabled(wasEnabled);
+  source->SetCentre(centre);
+  source->SetDirection(direction);
+
+  if (fLibrary.Write(fileName)) {
+    G4cout << "ResponseBuilder: library written to " << fileName
+           << " (source energy left at the last node)" << G4endl;
+  }
+  else {
+    G4cerr << "ResponseBuilder: could not write " << fileName << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseBuilder::Collect(const PixelImage& image, G4int nEvents)
+{
+  if (!fCollecting || nEvents <= 0) return;
+
+  // The pixel grid is only known once the first run has made its image
+  if (!fLibrary.GetNode(0, 0, 0)) {
+    const DetectorConstruction* detector
+      = static_cast<const DetectorConstruction*>
+          (G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+    G4double config[4] = { detector->GetPinholeRadius()/mm,
+                           detector->GetWindowGap()/mm,
+                           detector->GetWindowThickness()/um,
+                           detector->GetFoilThickness()/um };
+    fLibrary.Create(fThetas, fPhis, fEnergies, image.GetNx(), image.GetNz(),
+                    image.GetXmin()/cm, image.GetZmin()/cm,
+                    image.GetPitch()/cm, config);
+  }
+
+  G4int nx = image.GetNx();
+  G4int nz = image.GetNz();
+  if (nx != fLibrary.GetNx() || nz != fLibrary.GetNz()) return;
+
+  float* node = fLibrary.GetNode(fTheta, fPhi, fEnergy);
+  for (G4int iz = 0; iz < nz; iz++) {
+    for (G4int ix = 0; ix < nx; ix++) {
+      node[iz*nx + ix] = float(image.GetCounts(ix, iz)/nEvents);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
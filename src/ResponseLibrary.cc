@@ -0,0 +1,316 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file ResponseLibrary.cc
+/// \brief Implementation of the ResponseLibrary class
+
+#include "ResponseLibrary.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+  const char        kMagic[8]   = {'P', 'H', 'R', 'E', 'S', 'P', '0', '1'};
+  const std::size_t kAlignment  = 64;
+
+  // Fixed part of the header; the axis values follow it, then padding up
+  // to kAlignment, then the float32 node images
+  struct Header
+  {
+    char     magic[8];
+    uint32_t nTheta;
+    uint32_t nPhi;
+    uint32_t nEnergy;
+    uint32_t nx;
+    uint32_t nz;
+    uint32_t dataOffset;
+    double   xmin;
+    double   zmin;
+    double   pitch;
+    double   config[4];
+  };
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ResponseLibrary::ResponseLibrary()
+: fNx(0),
+  fNz(0),
+  fXmin(0.),
+  fZmin(0.),
+  fPitch(0.),
+  fMapping(0),
+  fMappingSize(0),
+  fData(0)
+{
+  for (int i = 0; i < 4; i++) fConfig[i] = 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ResponseLibrary::~ResponseLibrary()
+{
+  Close();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseLibrary::Close()
+{
+  if (fMapping) munmap(fMapping, fMappingSize);
+  fMapping = 0;
+  fMappingSize = 0;
+  fData = 0;
+  fOwned.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseLibrary::Create(const std::vector<double>& thetas,
+                             const std::vector<double>& phis,
+                             const std::vector<double>& energies,
+                             int nx, int nz, double xmin, double zmin,
+                             double pitch, const double config[4])
+{
+  Close();
+
+  fThetas   = thetas;
+  fPhis     = phis;
+  fEnergies = energies;
+  fNx    = nx;
+  fNz    = nz;
+  fXmin  = xmin;
+  fZmin  = zmin;
+  fPitch = pitch;
+  for (int i = 0; i < 4; i++) fConfig[i] = config[i];
+
+  BuildLogEnergies();
+  fOwned.assign(thetas.size()*phis.size()*energies.size()*nx*nz, 0.f);
+  fData = fOwned.empty() ? 0 : &fOwned[0];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseLibrary::Locate(const std::vector<double>& axis, double value,
+                             int& index, double& fraction)
+{
+  if (axis.size() < 2 || value <= axis.front()) {
+    index = 0;
+    fraction = 0.;
+    return;
+  }
+  if (value >= axis.back()) {
+    index = int(axis.size()) - 2;
+    fraction = 1.;
+    return;
+  }
+  index = int(std::upper_bound(axis.begin(), axis.end(), value)
+              - axis.begin()) - 1;
+  fraction = (value - axis[index])/(axis[index+1] - axis[index]);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseLibrary::BuildLogEnergies()
+{
+  fLogEnergies.clear();
+  if (fEnergies.size() < 2 || fEnergies.front() <= 0.) return;
+
+  fLogEnergies.resize(fEnergies.size());
+  for (std::size_t i = 0; i < fEnergies.size(); i++) {
+    fLogEnergies[i] = std::log(fEnergies[i]);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::size_t ResponseLibrary::NodeIndex(int iTheta, int iPhi, int iEnergy) const
+{
+  return ((std::size_t(iTheta)*fPhis.size() + iPhi)*fEnergies.size()
+          + iEnergy)*std::size_t(fNx)*fNz;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+float* ResponseLibrary::GetNode(int iTheta, int iPhi, int iEnergy)
+{
+  if (fOwned.empty()) return 0;
+  return &fOwned[NodeIndex(iTheta, iPhi, iEnergy)];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const float* ResponseLibrary::GetNode(int iTheta, int iPhi, int iEnergy) const
+{
+  return fData ? fData + NodeIndex(iTheta, iPhi, iEnergy) : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool ResponseLibrary::Write(const std::string& fileName) const
+{
+  if (!fData) return false;
+
+  Header header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.nTheta  = uint32_t(fThetas.size());
+  header.nPhi    = uint32_t(fPhis.size());
+  header.nEnergy = uint32_t(fEnergies.size());
+  header.nx      = uint32_t(fNx);
+  header.nz      = uint32_t(fNz);
+  header.xmin    = fXmin;
+  header.zmin    = fZmin;
+  header.pitch   = fPitch;
+  for (int i = 0; i < 4; i++) header.config[i] = fConfig[i];
+
+  std::size_t axesSize = (fThetas.size() + fPhis.size() + fEnergies.size())
+                         *sizeof(double);
+  std::size_t used = sizeof(Header) + axesSize;
+  header.dataOffset = uint32_t((used + kAlignment - 1)/kAlignment*kAlignment);
+
+  std::ofstream out(fileName.c_str(), std::ios::binary);
+  if (!out.is_open()) return false;
+
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(&fThetas[0]),
+            fThetas.size()*sizeof(double));
+  out.write(reinterpret_cast<const char*>(&fPhis[0]),
+            fPhis.size()*sizeof(double));
+  out.write(reinterpret_cast<const char*>(&fEnergies[0]),
+            fEnergies.size()*sizeof(double));
+  std::vector<char> padding(header.dataOffset - used, 0);
+  if (!padding.empty()) out.write(&padding[0], padding.size());
+  out.write(reinterpret_cast<const char*>(fData), fOwned.size()*sizeof(float));
+
+  return bool(out);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool ResponseLibrary::Open(const std::string& fileName)
+{
+  Close();
+
+  int file = open(fileName.c_str(), O_RDONLY);
+  if (file < 0) return false;
+
+  struct stat info;
+  if (fstat(file, &info) != 0 || std::size_t(info.st_size) < sizeof(Header)) {
+    close(file);
+    return false;
+  }
+
+  void* mapping = mmap(0, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+  close(file);
+  if (mapping == MAP_FAILED) return false;
+
+  Header header;
+  std::memcpy(&header, mapping, sizeof(header));
+
+  std::size_t nNodes = std::size_t(header.nTheta)*header.nPhi*header.nEnergy;
+  std::size_t axesEnd = sizeof(Header)
+    + (header.nTheta + header.nPhi + header.nEnergy)*sizeof(double);
+  if (std::memcmp(header.magic, kMagic, sizeof(kMagic)) != 0
+      || header.dataOffset < axesEnd
+      || std::size_t(info.st_size) < header.dataOffset
+                                     + nNodes*header.nx*header.nz*sizeof(float)) {
+    munmap(mapping, info.st_size);
+    return false;
+  }
+
+  fMapping     = mapping;
+  fMappingSize = info.st_size;
+
+  const double* axes = reinterpret_cast<const double*>(
+    static_cast<const char*>(mapping) + sizeof(Header));
+  fThetas.assign(axes, axes + header.nTheta);
+  axes += header.nTheta;
+  fPhis.assign(axes, axes + header.nPhi);
+  axes += header.nPhi;
+  fEnergies.assign(axes, axes + header.nEnergy);
+  BuildLogEnergies();
+
+  fNx    = int(header.nx);
+  fNz    = int(header.nz);
+  fXmin  = header.xmin;
+  fZmin  = header.zmin;
+  fPitch = header.pitch;
+  for (int i = 0; i < 4; i++) fConfig[i] = header.config[i];
+
+  fData = reinterpret_cast<const float*>(
+    static_cast<const char*>(mapping) + header.dataOffset);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseLibrary::Accumulate(double theta, double phi, double energy,
+                                 double weight, double* image) const
+{
+  if (!fData || weight == 0.) return;
+
+  int it, ip, ie;
+  double ft, fp, fe;
+  Locate(fThetas, theta, it, ft);
+  Locate(fPhis, phi, ip, fp);
+
+  // Response changes roughly with log(E) over the electron energy range
+  if (!fLogEnergies.empty() && energy > 0.) {
+    Locate(fLogEnergies, std::log(energy), ie, fe);
+  }
+  else {
+    Locate(fEnergies, energy, ie, fe);
+  }
+
+  const std::size_t nPixels = std::size_t(fNx)*fNz;
+  for (int dt = 0; dt < 2; dt++) {
+    double wt = dt ? ft : 1. - ft;
+    if (wt == 0. || it + dt >= int(fThetas.size())) continue;
+    for (int dp = 0; dp < 2; dp++) {
+      double wp = dp ? fp : 1. - fp;
+      if (wp == 0. || ip + dp >= int(fPhis.size())) continue;
+      for (int de = 0; de < 2; de++) {
+        double we = de ? fe : 1. - fe;
+        if (we == 0. || ie + de >= int(fEnergies.size())) continue;
+
+        double w = weight*wt*wp*we;
+        const float* node = GetNode(it + dt, ip + dp, ie + de);
+        for (std::size_t i = 0; i < nPixels; i++) image[i] += w*node[i];
+      }
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
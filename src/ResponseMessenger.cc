@@ -0,0 +1,145 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file ResponseMessenger.cc
+/// \brief Implementation of the ResponseMessenger class
+
+#include "ResponseMessenger.hh"
+#include "ResponseBuilder.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIcmdWithAString.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ResponseMessenger::ResponseMessenger(ResponseBuilder* builder)
+: G4UImessenger(),
+  fBuilder(builder)
+{
+  fResponseDir = new G4UIdirectory("/pinhole/response/", false);
+  fResponseDir->SetGuidance("Detector response library.");
+
+  fThetaCmd = MakeAxisCommand("theta", "deg");
+  fThetaCmd->SetGuidance("Theta grid of the library (run_over_angles theta).");
+
+  fPhiCmd = MakeAxisCommand("phi", "deg");
+  fPhiCmd->SetGuidance("Phi grid of the library (run_over_angles phi).");
+
+  fEnergyCmd = MakeAxisCommand("energy", "keV");
+  fEnergyCmd->SetGuidance("Energy grid of the library, log-spaced.");
+
+  fEventsCmd = new G4UIcmdWithAnInteger("/pinhole/response/events", this);
+  fEventsCmd->SetGuidance("Primaries simulated per grid node.");
+  fEventsCmd->SetParameterName("events", false);
+  fEventsCmd->SetRange("events>0");
+  fEventsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fEventsCmd->SetToBeBroadcasted(false);
+
+  fBuildCmd = new G4UIcmdWithAString("/pinhole/response/build", this);
+  fBuildCmd->SetGuidance("Run every grid node and write the library file.");
+  fBuildCmd->SetGuidance("Needs /pinhole/readout/pitch > 0.");
+  fBuildCmd->SetParameterName("file", true);
+  fBuildCmd->SetDefaultValue("../analysis/data/response.lib");
+  fBuildCmd->AvailableForStates(G4State_Idle);
+  fBuildCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ResponseMessenger::~ResponseMessenger()
+{
+  delete fThetaCmd;
+  delete fPhiCmd;
+  delete fEnergyCmd;
+  delete fEventsCmd;
+  delete fBuildCmd;
+  delete fResponseDir;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4UIcommand* ResponseMessenger::MakeAxisCommand(const char* name,
+                                                const char* defaultUnit)
+{
+  G4UIcommand* command
+    = new G4UIcommand((G4String("/pinhole/response/") + name).c_str(), this);
+
+  G4UIparameter* nPrm = new G4UIparameter("n", 'i', false);
+  nPrm->SetParameterRange("n>0");
+  command->SetParameter(nPrm);
+  G4UIparameter* minPrm = new G4UIparameter("min", 'd', false);
+  command->SetParameter(minPrm);
+  G4UIparameter* maxPrm = new G4UIparameter("max", 'd', false);
+  command->SetParameter(maxPrm);
+  G4UIparameter* unitPrm = new G4UIparameter("unit", 's', true);
+  unitPrm->SetDefaultValue(defaultUnit);
+  command->SetParameter(unitPrm);
+
+  command->AvailableForStates(G4State_PreInit, G4State_Idle);
+  command->SetToBeBroadcasted(false);
+  return command;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResponseMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fThetaCmd || command == fPhiCmd || command == fEnergyCmd) {
+    G4int n;
+    G4double min, max;
+    G4String unit;
+    std::istringstream is(newValue);
+    is >> n >> min >> max >> unit;
+    G4double value = G4UIcommand::ValueOf(unit);
+    min *= value;
+    max *= value;
+
+    if (command == fThetaCmd) {
+      fBuilder->SetThetaAxis(n, min, max);
+    }
+    else if (command == fPhiCmd) {
+      fBuilder->SetPhiAxis(n, min, max);
+    }
+    else if (min > 0. && max >= min) {
+      fBuilder->SetEnergyAxis(n, min, max);
+    }
+    else {
+      G4cerr << "/pinhole/response/energy: need 0 < min <= max" << G4endl;
+    }
+  }
+  else if (command == fEventsCmd) {
+    fBuilder->SetEventsPerNode(fEventsCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fBuildCmd) {
+    fBuilder->Build(newValue);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
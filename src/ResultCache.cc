@@ -0,0 +1,458 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file ResultCache.cc
+/// \brief Implementation of the ResultCache class
+
+#include "ResultCache.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
+
+namespace
+{
+  const uint64_t kFnvPrime = 1099511628211ULL;
+
+  // Regular files directly inside directory, with their sizes
+  std::map<std::string, long long> ListFiles(const std::string& directory)
+  {
+    std::map<std::string, long long> files;
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return files;
+
+    while (dirent* entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name == "." || name == "..") continue;
+      struct stat info;
+      if (stat((directory + "/" + name).c_str(), &info) == 0
+          && S_ISREG(info.st_mode)) {
+        files[name] = info.st_size;
+      }
+    }
+    closedir(dir);
+    return files;
+  }
+
+  // Subdirectories directly inside directory
+  std::set<std::string> ListDirectories(const std::string& directory)
+  {
+    std::set<std::string> directories;
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return directories;
+
+    while (dirent* entry = readdir(dir)) {
+      std::string name = entry->d_name;
+      if (name == "." || name == "..") continue;
+      struct stat info;
+      if (stat((directory + "/" + name).c_str(), &info) == 0
+          && S_ISDIR(info.st_mode)) {
+        directories.insert(name);
+      }
+    }
+    closedir(dir);
+    return directories;
+  }
+
+  // New directory base, or base-1, base-2, ... if taken; empty on failure
+  std::string ClaimDirectory(const std::string& base)
+  {
+    for (int i = 0; ; i++) {
+      std::ostringstream name;
+      name << base;
+      if (i > 0) name << "-" << i;
+      if (mkdir(name.str().c_str(), 0755) == 0) return name.str();
+      if (errno != EEXIST) return std::string();
+    }
+  }
+
+  // Copies length bytes of source starting at offset; appends if asked
+  bool CopyBytes(const std::string& source, long long offset,
+                 const std::string& target, bool append)
+  {
+    std::ifstream in(source.c_str(), std::ios::binary);
+    std::ofstream out(target.c_str(), std::ios::binary
+                      | (append ? std::ios::app : std::ios::trunc));
+    if (!in.is_open() || !out.is_open()) return false;
+
+    in.seekg(offset);
+    std::vector<char> buffer(1 << 20);
+    while (in) {
+      in.read(&buffer[0], buffer.size());
+      if (in.gcount() > 0) out.write(&buffer[0], in.gcount());
+    }
+    return bool(out);
+  }
+
+  long long DirectorySize(const std::string& directory)
+  {
+    long long total = 0;
+    std::map<std::string, long long> files = ListFiles(directory);
+    for (std::map<std::string, long long>::const_iterator it = files.begin();
+         it != files.end(); ++it) total += it->second;
+    std::map<std::string, long long> blobs = ListFiles(directory + "/files");
+    for (std::map<std::string, long long>::const_iterator it = blobs.begin();
+         it != blobs.end(); ++it) total += it->second;
+
+    // Run directories of per-run outputs
+    std::set<std::string> runs = ListDirectories(directory + "/files");
+    for (std::set<std::string>::const_iterator run = runs.begin();
+         run != runs.end(); ++run) {
+      std::map<std::string, long long> files
+        = ListFiles(directory + "/files/" + *run);
+      for (std::map<std::string, long long>::const_iterator it = files.begin();
+           it != files.end(); ++it) total += it->second;
+    }
+    return total;
+  }
+
+  void RemoveDirectory(const std::string& directory)
+  {
+    std::set<std::string> runs = ListDirectories(directory + "/files");
+    for (std::set<std::string>::const_iterator run = runs.begin();
+         run != runs.end(); ++run) {
+      std::string path = directory + "/files/" + *run;
+      std::map<std::string, long long> files = ListFiles(path);
+      for (std::map<std::string, long long>::const_iterator it = files.begin();
+           it != files.end(); ++it) {
+        std::remove((path + "/" + it->first).c_str());
+      }
+      rmdir(path.c_str());
+    }
+
+    std::map<std::string, long long> blobs = ListFiles(directory + "/files");
+    for (std::map<std::string, long long>::const_iterator it = blobs.begin();
+         it != blobs.end(); ++it) {
+      std::remove((directory + "/files/" + it->first).c_str());
+    }
+    rmdir((directory + "/files").c_str());
+
+    std::map<std::string, long long> files = ListFiles(directory);
+    for (std::map<std::string, long long>::const_iterator it = files.begin();
+         it != files.end(); ++it) {
+      std::remove((directory + "/" + it->first).c_str());
+    }
+    rmdir(directory.c_str());
+  }
+
+  struct Entry
+  {
+    std::string hash;
+    long long   bytes;
+    time_t      lastUse;
+  };
+
+  // Entries are directories named by 16 hex digits
+  std::vector<Entry> ListEntries(const std::string& directory)
+  {
+    std::vector<Entry> entries;
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return entries;
+
+    while (dirent* item = readdir(dir)) {
+      std::string name = item->d_name;
+      if (name.size() != 16
+          || name.find_first_not_of("0123456789abcdef") != std::string::npos) {
+        continue;
+      }
+      std::string path = directory + "/" + name;
+      struct stat info;
+      if (stat((path + "/summary.txt").c_str(), &info) != 0) continue;
+
+      Entry entry;
+      entry.hash    = name;
+      entry.bytes   = DirectorySize(path);
+      entry.lastUse = info.st_mtime;
+      entries.push_back(entry);
+    }
+    closedir(dir);
+    return entries;
+  }
+
+  bool OlderUse(const Entry& a, const Entry& b)
+  {
+    return a.lastUse < b.lastUse;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+ResultCache::ResultCache(const std::string& directory, double maxBytes)
+: fDirectory(directory),
+  fMaxBytes(maxBytes)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+uint64_t ResultCache::Hash(const std::string& text, uint64_t hash)
+{
+  for (std::size_t i = 0; i < text.size(); i++) {
+    hash ^= static_cast<unsigned char>(text[i]);
+    hash *= kFnvPrime;
+  }
+  return hash;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+uint64_t ResultCache::HashFile(const std::string& fileName, uint64_t hash)
+{
+  std::ifstream in(fileName.c_str(), std::ios::binary);
+  std::vector<char> buffer(1 << 20);
+  while (in) {
+    in.read(&buffer[0], buffer.size());
+    for (std::streamsize i = 0; i < in.gcount(); i++) {
+      hash ^= static_cast<unsigned char>(buffer[i]);
+      hash *= kFnvPrime;
+    }
+  }
+  return hash;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::string ResultCache::ToHex(uint64_t hash)
+{
+  std::ostringstream os;
+  os << std::hex << std::setw(16) << std::setfill('0') << hash;
+  return os.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::string ResultCache::EntryPath(const std::string& keyText) const
+{
+  return fDirectory + "/" + ToHex(Hash(keyText));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool ResultCache::Contains(const std::string& keyText) const
+{
+  // Compare the full key as well, a hash collision must not be a hit
+  std::ifstream keyFile((EntryPath(keyText) + "/key.txt").c_str());
+  if (!keyFile.is_open()) return false;
+  std::ostringstream stored;
+  stored << keyFile.rdbuf();
+  return stored.str() == keyText;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool ResultCache::Restore(const std::string& keyText,
+                          const std::string& dataDirectory)
+{
+  if (!Contains(keyText)) return false;
+
+  std::string path = EntryPath(keyText);
+  std::ifstream manifest((path + "/manifest.txt").c_str());
+  if (!manifest.is_open()) return false;
+
+  mkdir(dataDirectory.c_str(), 0755);
+
+  // Stored run directories are replayed into newly claimed ones
+  std::map<std::string, std::string> runs;
+  std::string mode, name;
+  long long bytes;
+  while (manifest >> mode >> bytes >> name) {
+    std::string target = dataDirectory + "/" + name;
+    std::string::size_type slash = name.find('/');
+    if (slash != std::string::npos) {
+      std::string run = name.substr(0, slash);
+      if (runs.find(run) == runs.end()) {
+        runs[run] = ClaimDirectory(dataDirectory + "/" + run);
+      }
+      if (runs[run].empty()) return false;
+      target = runs[run] + name.substr(slash);
+    }
+    if (!CopyBytes(path + "/files/" + name, 0, target,
+                   mode == "append")) return false;
+  }
+
+  // Last use, for the eviction order
+  utime((path + "/summary.txt").c_str(), 0);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResultCache::Snapshot(const std::string& dataDirectory)
+{
+  fSizesBefore = ListFiles(dataDirectory);
+  fDirectoriesBefore = ListDirectories(dataDirectory);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool ResultCache::Store(const std::string& keyText,
+                        const std::string& dataDirectory, double seconds)
+{
+  mkdir(fDirectory.c_str(), 0755);
+
+  std::string path = EntryPath(keyText);
+  std::ostringstream temporary;
+  temporary << path << ".tmp" << getpid();
+  std::string staging = temporary.str();
+  RemoveDirectory(staging);
+  if (mkdir(staging.c_str(), 0755) != 0
+      || mkdir((staging + "/files").c_str(), 0755) != 0) return false;
+
+  std::ofstream manifest((staging + "/manifest.txt").c_str());
+  long long stored = 0;
+  std::map<std::string, long long> after = ListFiles(dataDirectory);
+  for (std::map<std::string, long long>::const_iterator it = after.begin();
+       it != after.end(); ++it) {
+    std::map<std::string, long long>::const_iterator before
+      = fSizesBefore.find(it->first);
+
+    // Grown files are replayed by appending, new or rewritten ones whole
+    bool append = before != fSizesBefore.end() && it->second > before->second;
+    bool create = before == fSizesBefore.end() || it->second < before->second;
+    if (!append && !create) continue;
+
+    long long offset = append ? before->second : 0;
+    if (!CopyBytes(dataDirectory + "/" + it->first, offset,
+                   staging + "/files/" + it->first, false)) {
+      RemoveDirectory(staging);
+      return false;
+    }
+    manifest << (append ? "append " : "create ") << it->second - offset
+             << " " << it->first << "\n";
+    stored += it->second - offset;
+  }
+
+  // Directories the run created, with all of their files
+  std::set<std::string> runs = ListDirectories(dataDirectory);
+  for (std::set<std::string>::const_iterator run = runs.begin();
+       run != runs.end(); ++run) {
+    if (fDirectoriesBefore.count(*run)) continue;
+    if (mkdir((staging + "/files/" + *run).c_str(), 0755) != 0) {
+      RemoveDirectory(staging);
+      return false;
+    }
+    std::map<std::string, long long> files
+      = ListFiles(dataDirectory + "/" + *run);
+    for (std::map<std::string, long long>::const_iterator it = files.begin();
+         it != files.end(); ++it) {
+      std::string name = *run + "/" + it->first;
+      if (!CopyBytes(dataDirectory + "/" + name, 0,
+                     staging + "/files/" + name, false)) {
+        RemoveDirectory(staging);
+        return false;
+      }
+      manifest << "create " << it->second << " " << name << "\n";
+      stored += it->second;
+    }
+  }
+  manifest.close();
+
+  std::ofstream keyFile((staging + "/key.txt").c_str());
+  keyFile << keyText;
+  keyFile.close();
+
+  std::ofstream summary((staging + "/summary.txt").c_str());
+  summary << "created " << std::time(0) << "\n"
+          << "seconds " << seconds << "\n"
+          << "bytes " << stored << "\n";
+  summary.close();
+
+  // Replace any previous entry for the same key
+  RemoveDirectory(path);
+  if (std::rename(staging.c_str(), path.c_str()) != 0) {
+    RemoveDirectory(staging);
+    return false;
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResultCache::Evict()
+{
+  std::vector<Entry> entries = ListEntries(fDirectory);
+  std::sort(entries.begin(), entries.end(), OlderUse);
+
+  long long total = 0;
+  for (std::size_t i = 0; i < entries.size(); i++) total += entries[i].bytes;
+
+  for (std::size_t i = 0; i < entries.size() && total > fMaxBytes; i++) {
+    RemoveDirectory(fDirectory + "/" + entries[i].hash);
+    total -= entries[i].bytes;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void ResultCache::List(std::ostream& out) const
+{
+  std::vector<Entry> entries = ListEntries(fDirectory);
+  std::sort(entries.begin(), entries.end(), OlderUse);
+
+  long long total = 0;
+  for (std::size_t i = 0; i < entries.size(); i++) {
+    const Entry& entry = entries[i];
+    std::string path = fDirectory + "/" + entry.hash;
+
+    std::ifstream summary((path + "/summary.txt").c_str());
+    std::string field;
+    double seconds = 0.;
+    while (summary >> field) {
+      if (field == "seconds") summary >> seconds;
+    }
+
+    // The macro name is the first "macro" line of the key
+    std::ifstream keyFile((path + "/key.txt").c_str());
+    std::string line, macro;
+    while (std::getline(keyFile, line)) {
+      if (line.compare(0, 6, "macro ") == 0) {
+        macro = line.substr(6);
+        break;
+      }
+    }
+
+    char lastUse[32];
+    std::strftime(lastUse, sizeof(lastUse), "%Y-%m-%d %H:%M:%S",
+                  std::localtime(&entry.lastUse));
+    out << entry.hash << "  " << std::setw(10) << entry.bytes << " B  "
+        << lastUse << "  " << std::setw(8) << seconds << " s  " << macro
+        << "\n";
+    total += entry.bytes;
+  }
+  out << entries.size() << " entries, " << total << " of "
+      << (long long)fMaxBytes << " bytes" << std::endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,165 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file Run.cc
+/// \brief Implementation of the Run class
+
+#include "Run.hh"
+#include "PixelImage.hh"
+#include "AngleEstimator.hh"
+#include "PerfCounters.hh"
+#include "RunAction.hh"
+#include "DetectorConstruction.hh"
+
+#include "G4RunManager.hh"
+#include "G4Event.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cmath>
+#include <istream>
+#include <ostream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Run::Run()
+: G4Run(),
+  fImage(0),
+  fEstimator(0),
+  fPerf(0),
+  fHitBuffer(0),
+  fFirstEventID(-1)
+{
+  const DetectorConstruction* detector
+    = static_cast<const DetectorConstruction*>
+        (G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+
+  // Virtual segmentation of detector1 into square pixels
+  G4double pitch = detector->GetReadoutPitch();
+  if (pitch > 0.) {
+    G4double halfX = detector->GetDetectorHalfX();
+    G4double halfZ = detector->GetDetectorHalfZ();
+    G4int nx = G4int(std::ceil(2.*halfX/pitch));
+    G4int nz = G4int(std::ceil(2.*halfZ/pitch));
+    fImage = new PixelImage(nx, nz, -halfX, -halfZ, pitch);
+  }
+
+  // Hit positions are fed in cm, like the hit files
+  if (RunAction::IsEstimatorEnabled()) {
+    fEstimator = new AngleEstimator(detector->GetAngleGap()/cm);
+  }
+
+  if (PerfCounters::IsEnabled()) fPerf = new PerfCounters();
+  if (RunAction::IsHitBufferEnabled()) fHitBuffer = new std::vector<HitRecord>;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Run::~Run()
+{
+  delete fImage;
+  delete fEstimator;
+  delete fPerf;
+  delete fHitBuffer;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::RecordEvent(const G4Event* event)
+{
+  G4int eventID = event->GetEventID();
+  if (fFirstEventID < 0 || eventID < fFirstEventID) {
+    fFirstEventID = eventID;
+    fSourceDirection
+      = event->GetPrimaryVertex()->GetPrimary()->GetMomentumDirection();
+  }
+
+  G4Run::RecordEvent(event);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::Merge(const G4Run* aRun)
+{
+  const Run* localRun = static_cast<const Run*>(aRun);
+
+  if (fImage && localRun->fImage) fImage->Add(*localRun->fImage);
+  if (fEstimator && localRun->fEstimator) {
+    fEstimator->Merge(*localRun->fEstimator);
+  }
+  if (fPerf && localRun->fPerf) fPerf->Merge(*localRun->fPerf);
+  if (fHitBuffer && localRun->fHitBuffer) {
+    fHitBuffer->insert(fHitBuffer->end(), localRun->fHitBuffer->begin(),
+                       localRun->fHitBuffer->end());
+  }
+
+  if (localRun->fFirstEventID >= 0
+      && (fFirstEventID < 0 || localRun->fFirstEventID < fFirstEventID)) {
+    fFirstEventID    = localRun->fFirstEventID;
+    fSourceDirection = localRun->fSourceDirection;
+  }
+
+  G4Run::Merge(aRun);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Run::WriteState(std::ostream& out) const
+{
+  G4double direction[3]
+    = { fSourceDirection.x(), fSourceDirection.y(), fSourceDirection.z() };
+  G4int hasImage     = fImage ? 1 : 0;
+  G4int hasEstimator = fEstimator ? 1 : 0;
+
+  out.write(reinterpret_cast<const char*>(&numberOfEvent), sizeof(G4int));
+  out.write(reinterpret_cast<const char*>(&fFirstEventID), sizeof(G4int));
+  out.write(reinterpret_cast<const char*>(direction), sizeof(direction));
+  out.write(reinterpret_cast<const char*>(&hasImage), sizeof(G4int));
+  out.write(reinterpret_cast<const char*>(&hasEstimator), sizeof(G4int));
+  if (fImage) fImage->Write(out);
+  if (fEstimator) fEstimator->Write(out);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool Run::ReadState(std::istream& in)
+{
+  G4double direction[3];
+  G4int hasImage = 0, hasEstimator = 0;
+
+  in.read(reinterpret_cast<char*>(&numberOfEvent), sizeof(G4int));
+  in.read(reinterpret_cast<char*>(&fFirstEventID), sizeof(G4int));
+  in.read(reinterpret_cast<char*>(direction), sizeof(direction));
+  in.read(reinterpret_cast<char*>(&hasImage), sizeof(G4int));
+  in.read(reinterpret_cast<char*>(&hasEstimator), sizeof(G4int));
+  if (!in || hasImage != (fImage ? 1 : 0)
+      || hasEstimator != (fEstimator ? 1 : 0)) return false;
+
+  fSourceDirection.set(direction[0], direction[1], direction[2]);
+  if (fImage && !fImage->Read(in)) return false;
+  if (fEstimator && !fEstimator->Read(in)) return false;
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -29,9 +29,22 @@
 /// \brief Implementation of the RunAction class
 
 #include "RunAction.hh"
+#include "EventAction.hh"
 #include "PrimaryGeneratorAction.hh"
 #include "DetectorConstruction.hh"
-// #include "Run.hh"
+#include "SourceDefinition.hh"
+#include "Run.hh"
+#include "PixelImage.hh"
+#include "HistoManager.hh"
+#include "RunMessenger.hh"
+#include "PerfMessenger.hh"
+#include "DigitizerMessenger.hh"
+#include "PerfCounters.hh"
+#include "AngleEstimator.hh"
+#include "ResponseBuilder.hh"
+#include "CheckpointManager.hh"
+#include "Telemetry.hh"
+#include "OutputManager.hh"
 // #include "DetectorAnalysis.hh"
 
 #include "G4RunManager.hh"
@@ -41,32 +54,111 @@
 #include "G4LogicalVolume.hh"
 #include "G4UnitsTable.hh"
 #include "G4SystemOfUnits.hh"
+#include "G4Threading.hh"
 // #include "HistoManager.hh"
 
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
 #include <fstream>
+#include <sstream>
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+G4bool   RunAction::fgEstimatorEnabled = false;
+G4String RunAction::fgResultsFileName  = "";
+G4bool   RunAction::fgHitBufferEnabled = false;
+
 
 
 RunAction::RunAction()
 : G4UserRunAction(),
   fEdep(0.),
-  fEdep2(0.)
-{}
+  fEdep2(0.),
+  fAccepted(0),
+  fHistoManager(0),
+  fMessenger(0),
+  fPerfMessenger(0),
+  fDigiMessenger(0),
+  fHitFile("hits"),
+  fTrackFile("tracks"),
+  fPrimaryFile("init_pos"),
+  fDigiFile("digis")
+{
+  fHistoManager = new HistoManager();
+
+  G4AccumulableManager* accumulableManager = G4AccumulableManager::Instance();
+  for (G4int i = 0; i < EventAction::kNEventClasses; i++) {
+    fClassCounts.push_back(new G4Accumulable<G4int>(0));
+    accumulableManager->RegisterAccumulable(*fClassCounts.back());
+  }
+  accumulableManager->RegisterAccumulable(fAccepted);
+
+  // Job-wide settings, only the master instance takes commands
+  if (G4Threading::IsMasterThread()) {
+    fMessenger     = new RunMessenger();
+    fPerfMessenger = new PerfMessenger();
+    fDigiMessenger = new DigitizerMessenger();
+  }
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 RunAction::~RunAction()
-{}
+{
+  delete fHistoManager;
+  delete fMessenger;
+  delete fPerfMessenger;
+  delete fDigiMessenger;
+  for (size_t i = 0; i < fClassCounts.size(); i++) delete fClassCounts[i];
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void RunAction::BeginOfRunAction(const G4Run*)
+G4Run* RunAction::GenerateRun()
 {
+  return new Run;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::BeginOfRunAction(const G4Run* aRun)
+{
+  // The master picks the run directory before the workers start the run
+  OutputManager* output = OutputManager::Instance();
+  if (IsMaster()) output->BeginRun(aRun->GetRunID());
+
+  G4int thread = std::max(G4Threading::G4GetThreadId(), 0);
+  G4bool perThread = output->IsPerRun();
+  fHitFile.Open(output->GetRunDirectory(), perThread, thread,
+                output->GetRotateBytes());
+  fTrackFile.Open(output->GetRunDirectory(), perThread, thread,
+                  output->GetRotateBytes());
+  fPrimaryFile.Open(output->GetRunDirectory(), perThread, thread,
+                    output->GetRotateBytes());
+  fDigiFile.Open(output->GetRunDirectory(), perThread, thread,
+                 output->GetRotateBytes());
 
-  std::ofstream hitFile;
-  hitFile.open("../analysis/data/hits.csv", std::ios_base::app);
+  fHistoManager->Open(aRun->GetRunID());
+  G4AccumulableManager::Instance()->Reset();
+
+  if (IsMaster()) {
+    Telemetry::Instance()->BeginRun(aRun->GetRunID(),
+                                    aRun->GetNumberOfEventToBeProcessed());
+  }
+
+  // The shared hits.csv exists even if nothing is accepted
+  if (IsMaster() && !perThread) {
+    std::ofstream hitFile(output->GetRunPath("hits.csv").c_str(),
+                          std::ios_base::app);
+  }
+
+  // Reference spectrum of a multi-energy run, read back by tools/reweight
+  const SourceDefinition* source = SourceDefinition::Instance();
+  if (IsMaster() && source->IsMultiEnergy()) {
+    std::ofstream spectrumFile(output->GetRunPath("spectrum.txt").c_str());
+    spectrumFile << source->GetReferenceSpectrum().ToString() << "\n";
+  }
 
   /*
   if (!fFileName.empty()){
@@ -86,9 +178,118 @@ void RunAction::BeginOfRunAction(const G4Run*)
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void RunAction::EndOfRunAction(const G4Run*)
+void RunAction::EndOfRunAction(const G4Run* aRun)
 {
+  // Complete before the master checkpoints or the driver reads them
+  fHitFile.Close();
+  fTrackFile.Close();
+  fPrimaryFile.Close();
+  fDigiFile.Close();
+
+  // Worker histograms are merged into the master's by Geant4 on Save()
+  fHistoManager->Save();
+
+  // Worker trigger counts into the master's
+  G4AccumulableManager::Instance()->Merge();
+
+  if (!IsMaster()) return;
+
+  Telemetry::Instance()->EndRun();
+
+  if (aRun->GetNumberOfEvent() > 0) {
+    G4cout << "Trigger: " << fAccepted.GetValue() << " of "
+           << aRun->GetNumberOfEvent() << " events accepted (";
+    for (G4int i = 0; i < EventAction::kNEventClasses; i++) {
+      G4cout << (i > 0 ? ", " : "") << EventAction::GetClassName(i) << " "
+             << fClassCounts[i]->GetValue();
+    }
+    G4cout << ")" << G4endl;
+  }
+
+  // Worker images have been merged into the master run by now
+  const Run* run = static_cast<const Run*>(aRun);
+  if (run->GetPerf()) PerfCounters::AddToTotal(*run->GetPerf());
+
+  // Chunk of a checkpointed job: outputs are written once for the job
+  if (CheckpointManager::IsRunning()) {
+    CheckpointManager::Instance()->Collect(run);
+    return;
+  }
+
+  if (run->GetImage() && ResponseBuilder::IsCollecting()) {
+    ResponseBuilder::Instance()->Collect(*run->GetImage(),
+                                         run->GetNumberOfEvent());
+  }
+  else if (run->GetImage()) {
+    WriteImage(*run->GetImage(), run->GetRunID());
+  }
+
+  if (run->GetEstimator()) {
+    WriteResults(*run->GetEstimator(), run->GetSourceDirection(),
+                 run->GetNumberOfEvent());
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::WriteImage(const PixelImage& image, G4int runID)
+{
+  std::ostringstream name;
+  name << "detector1_image_run" << runID << ".npy";
+  G4String fileName = OutputManager::Instance()->GetRunPath(name.str());
+
+  // Readers never see a partly written image
+  G4String part = fileName + ".part";
+  if (!image.WriteNpy(part)
+      || std::rename(part.c_str(), fileName.c_str()) != 0) {
+    G4cerr << "RunAction: could not write " << fileName << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String RunAction::GetResultsFileName()
+{
+  if (!fgResultsFileName.empty()) return fgResultsFileName;
+  return OutputManager::Instance()->GetJobPath("results.txt");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunAction::WriteResults(const AngleEstimator& estimator,
+                             const G4ThreeVector& dir, G4int nEvents)
+{
+  if (estimator.GetEntries() == 0) {
+    G4cerr << "RunAction: no particle hits on detector, no results row"
+           << G4endl;
+    return;
+  }
+
+  // Same definition as fnc_findSourceAngle.py
+  G4double thetaActual = std::atan2(dir.z(), dir.y())/deg;
+  G4double phiActual   = std::atan2(dir.x(), dir.y())/deg;
+
+  G4String resultsFileName = GetResultsFileName();
+  std::ifstream existing(resultsFileName.c_str());
+  G4bool needsHeader = !existing.is_open()
+                       || existing.peek() == std::ifstream::traits_type::eof();
+  existing.close();
+
+  std::ofstream resultsFile(resultsFileName.c_str(), std::ios_base::app);
+  if (needsHeader) resultsFile << AngleEstimator::Header() << "\n";
+  resultsFile << estimator.FormatRow(nEvents, thetaActual, phiActual) << "\n";
+
+  G4cout << "Angle estimate (deg): theta = " << estimator.GetThetaMedian()
+         << " +- " << estimator.GetThetaSigmaG()
+         << ", phi = " << estimator.GetPhiMedian()
+         << " +- " << estimator.GetPhiSigmaG()
+         << ", correlation " << estimator.GetCorrelation()
+         << " (" << estimator.GetEntries() << " hits)" << G4endl;
 
+  G4double sigma1, sigma2, alpha;
+  estimator.GetNormFit(sigma1, sigma2, alpha);
+  G4cout << "Robust bivariate fit (deg): sigma1 = " << sigma1
+         << ", sigma2 = " << sigma2 << ", alpha = " << alpha << G4endl;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
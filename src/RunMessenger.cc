@@ -0,0 +1,185 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file RunMessenger.cc
+/// \brief Implementation of the RunMessenger class
+
+#include "RunMessenger.hh"
+#include "RunAction.hh"
+#include "EventAction.hh"
+#include "CheckpointManager.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIparameter.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunMessenger::RunMessenger()
+: G4UImessenger()
+{
+  fEstimatorDir = new G4UIdirectory("/pinhole/estimator/", false);
+  fEstimatorDir->SetGuidance("Online source angle estimation.");
+
+  fEstimatorCmd = new G4UIcmdWithABool("/pinhole/estimator/enable", this);
+  fEstimatorCmd->SetGuidance("Estimate the source angles during the run and");
+  fEstimatorCmd->SetGuidance("append one results.txt row at the end of it.");
+  fEstimatorCmd->SetParameterName("enable", true);
+  fEstimatorCmd->SetDefaultValue(true);
+  fEstimatorCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fEstimatorCmd->SetToBeBroadcasted(false);
+
+  fResultsFileCmd = new G4UIcmdWithAString("/pinhole/estimator/file", this);
+  fResultsFileCmd->SetGuidance("results.txt file the rows are appended to.");
+  fResultsFileCmd->SetGuidance("A header line is written if it is empty.");
+  fResultsFileCmd->SetParameterName("file", false);
+  fResultsFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fResultsFileCmd->SetToBeBroadcasted(false);
+
+  fBeamOnUntilCmd = new G4UIcommand("/pinhole/estimator/beamOnUntil", this);
+  fBeamOnUntilCmd->SetGuidance("Simulate until the standard errors of the");
+  fBeamOnUntilCmd->SetGuidance("mean theta and phi are below the target, or");
+  fBeamOnUntilCmd->SetGuidance("at most maxEvents. Convergence is checked");
+  fBeamOnUntilCmd->SetGuidance("after every /pinhole/checkpoint/events chunk");
+  fBeamOnUntilCmd->SetGuidance("and the job can be resumed like a checkpointed");
+  fBeamOnUntilCmd->SetGuidance("one. Enables the estimator.");
+  G4UIparameter* errorPrm = new G4UIparameter("error", 'd', false);
+  errorPrm->SetParameterRange("error>0");
+  fBeamOnUntilCmd->SetParameter(errorPrm);
+  G4UIparameter* maxPrm = new G4UIparameter("maxEvents", 'i', false);
+  maxPrm->SetParameterRange("maxEvents>0");
+  fBeamOnUntilCmd->SetParameter(maxPrm);
+  G4UIparameter* unitPrm = new G4UIparameter("unit", 's', true);
+  unitPrm->SetDefaultValue("deg");
+  fBeamOnUntilCmd->SetParameter(unitPrm);
+  fBeamOnUntilCmd->AvailableForStates(G4State_Idle);
+  fBeamOnUntilCmd->SetToBeBroadcasted(false);
+
+  fTriggerDir = new G4UIdirectory("/pinhole/trigger/", false);
+  fTriggerDir->SetGuidance("Event classification and output trigger.");
+
+  fAcceptCmd = new G4UIcmdWithAString("/pinhole/trigger/accept", this);
+  fAcceptCmd->SetGuidance("Event classes written to the outputs, any of");
+  fAcceptCmd->SetGuidance("  none      nothing entered detector1");
+  fAcceptCmd->SetGuidance("  single    the primary entered once, nothing else");
+  fAcceptCmd->SetGuidance("  double    the primary entered more than once");
+  fAcceptCmd->SetGuidance("  secondary only secondaries entered");
+  fAcceptCmd->SetGuidance("  multi     the primary and secondaries entered");
+  fAcceptCmd->SetGuidance("or all. Default: single double secondary multi.");
+  fAcceptCmd->SetParameterName("classes", false);
+  fAcceptCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fAcceptCmd->SetToBeBroadcasted(false);
+
+  fFilterPrimariesCmd
+    = new G4UIcmdWithABool("/pinhole/trigger/filterPrimaries", this);
+  fFilterPrimariesCmd->SetGuidance("Write init_pos.csv rows for accepted");
+  fFilterPrimariesCmd->SetGuidance("events only. The number of simulated");
+  fFilterPrimariesCmd->SetGuidance("events is then only in the run summary.");
+  fFilterPrimariesCmd->SetParameterName("filter", true);
+  fFilterPrimariesCmd->SetDefaultValue(true);
+  fFilterPrimariesCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fFilterPrimariesCmd->SetToBeBroadcasted(false);
+
+  fTracksDir = new G4UIdirectory("/pinhole/tracks/", false);
+  fTracksDir->SetGuidance("Track records of a multi-layer telescope.");
+
+  fRawHitsCmd = new G4UIcmdWithABool("/pinhole/tracks/rawHits", this);
+  fRawHitsCmd->SetGuidance("Also write the layer-tagged hits of accepted");
+  fRawHitsCmd->SetGuidance("events to hits.csv, not only tracks.csv.");
+  fRawHitsCmd->SetParameterName("write", true);
+  fRawHitsCmd->SetDefaultValue(true);
+  fRawHitsCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fRawHitsCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunMessenger::~RunMessenger()
+{
+  delete fEstimatorCmd;
+  delete fResultsFileCmd;
+  delete fBeamOnUntilCmd;
+  delete fEstimatorDir;
+  delete fAcceptCmd;
+  delete fFilterPrimariesCmd;
+  delete fTriggerDir;
+  delete fRawHitsCmd;
+  delete fTracksDir;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fEstimatorCmd) {
+    RunAction::SetEstimatorEnabled(fEstimatorCmd->GetNewBoolValue(newValue));
+  }
+  else if (command == fResultsFileCmd) {
+    RunAction::SetResultsFileName(newValue);
+  }
+  else if (command == fBeamOnUntilCmd) {
+    G4double error;
+    G4int maxEvents;
+    G4String unit;
+    std::istringstream is(newValue);
+    is >> error >> maxEvents >> unit;
+    RunAction::SetEstimatorEnabled(true);
+    CheckpointManager::Instance()->BeamOn(
+      maxEvents, error*G4UIcommand::ValueOf(unit)/deg);
+  }
+  else if (command == fAcceptCmd) {
+    G4int mask = 0;
+    std::istringstream names(newValue);
+    G4String name;
+    while (names >> name) {
+      G4int eventClass = EventAction::GetClassByName(name);
+      if (name == "all") {
+        mask = (1 << EventAction::kNEventClasses) - 1;
+      }
+      else if (eventClass >= 0) {
+        mask |= 1 << eventClass;
+      }
+      else {
+        G4cerr << "/pinhole/trigger/accept: unknown event class " << name
+               << ", trigger unchanged" << G4endl;
+        return;
+      }
+    }
+    EventAction::SetTriggerMask(mask);
+  }
+  else if (command == fFilterPrimariesCmd) {
+    EventAction::SetFilterPrimaries(
+      fFilterPrimariesCmd->GetNewBoolValue(newValue));
+  }
+  else if (command == fRawHitsCmd) {
+    EventAction::SetWriteRawHits(fRawHitsCmd->GetNewBoolValue(newValue));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
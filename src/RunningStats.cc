@@ -0,0 +1,215 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file RunningStats.cc
+/// \brief Implementation of the RunningStats and QuantileSketch classes
+
+#include "RunningStats.hh"
+
+#include <cmath>
+#include <istream>
+#include <limits>
+#include <ostream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+RunningStats::RunningStats()
+{
+  Reset();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunningStats::Reset()
+{
+  fN    = 0;
+  fMean = 0.;
+  fM2   = 0.;
+  fMin  = std::numeric_limits<double>::max();
+  fMax  = -std::numeric_limits<double>::max();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunningStats::Merge(const RunningStats& other)
+{
+  if (other.fN == 0) return;
+  if (fN == 0) {
+    *this = other;
+    return;
+  }
+
+  long   n     = fN + other.fN;
+  double delta = other.fMean - fMean;
+  fMean += delta*other.fN/n;
+  fM2   += other.fM2 + delta*delta*double(fN)*double(other.fN)/n;
+  fN     = n;
+  if (other.fMin < fMin) fMin = other.fMin;
+  if (other.fMax > fMax) fMax = other.fMax;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void RunningStats::Write(std::ostream& out) const
+{
+  out.write(reinterpret_cast<const char*>(&fN), sizeof(fN));
+  out.write(reinterpret_cast<const char*>(&fMean), sizeof(fMean));
+  out.write(reinterpret_cast<const char*>(&fM2), sizeof(fM2));
+  out.write(reinterpret_cast<const char*>(&fMin), sizeof(fMin));
+  out.write(reinterpret_cast<const char*>(&fMax), sizeof(fMax));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool RunningStats::Read(std::istream& in)
+{
+  in.read(reinterpret_cast<char*>(&fN), sizeof(fN));
+  in.read(reinterpret_cast<char*>(&fMean), sizeof(fMean));
+  in.read(reinterpret_cast<char*>(&fM2), sizeof(fM2));
+  in.read(reinterpret_cast<char*>(&fMin), sizeof(fMin));
+  in.read(reinterpret_cast<char*>(&fMax), sizeof(fMax));
+  return bool(in);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double RunningStats::GetStdDev() const
+{
+  return std::sqrt(GetVariance());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+QuantileSketch::QuantileSketch(double min, double max, double binWidth)
+: fMin(min),
+  fMax(max),
+  fInvWidth(1./binWidth),
+  fWidth(binWidth),
+  fBins(size_t(std::ceil((max - min)/binWidth)), 0.)
+{
+  Reset();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void QuantileSketch::Reset()
+{
+  fUnderflow = 0.;
+  fOverflow  = 0.;
+  fTotal     = 0.;
+  fLowest    = std::numeric_limits<double>::max();
+  fHighest   = -std::numeric_limits<double>::max();
+  for (size_t i = 0; i < fBins.size(); i++) fBins[i] = 0.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void QuantileSketch::Merge(const QuantileSketch& other)
+{
+  if (other.fBins.size() != fBins.size()) return;
+
+  for (size_t i = 0; i < fBins.size(); i++) fBins[i] += other.fBins[i];
+  fUnderflow += other.fUnderflow;
+  fOverflow  += other.fOverflow;
+  fTotal     += other.fTotal;
+  if (other.fLowest < fLowest) fLowest = other.fLowest;
+  if (other.fHighest > fHighest) fHighest = other.fHighest;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void QuantileSketch::Write(std::ostream& out) const
+{
+  unsigned long long nBins = fBins.size();
+  out.write(reinterpret_cast<const char*>(&nBins), sizeof(nBins));
+  out.write(reinterpret_cast<const char*>(&fUnderflow), sizeof(fUnderflow));
+  out.write(reinterpret_cast<const char*>(&fOverflow), sizeof(fOverflow));
+  out.write(reinterpret_cast<const char*>(&fTotal), sizeof(fTotal));
+  out.write(reinterpret_cast<const char*>(&fLowest), sizeof(fLowest));
+  out.write(reinterpret_cast<const char*>(&fHighest), sizeof(fHighest));
+  out.write(reinterpret_cast<const char*>(&fBins[0]), nBins*sizeof(double));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool QuantileSketch::Read(std::istream& in)
+{
+  unsigned long long nBins = 0;
+  in.read(reinterpret_cast<char*>(&nBins), sizeof(nBins));
+  if (!in || nBins != fBins.size()) return false;
+
+  in.read(reinterpret_cast<char*>(&fUnderflow), sizeof(fUnderflow));
+  in.read(reinterpret_cast<char*>(&fOverflow), sizeof(fOverflow));
+  in.read(reinterpret_cast<char*>(&fTotal), sizeof(fTotal));
+  in.read(reinterpret_cast<char*>(&fLowest), sizeof(fLowest));
+  in.read(reinterpret_cast<char*>(&fHighest), sizeof(fHighest));
+  in.read(reinterpret_cast<char*>(&fBins[0]), nBins*sizeof(double));
+  return bool(in);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double QuantileSketch::Quantile(double q) const
+{
+  if (fTotal <= 0.) return std::numeric_limits<double>::quiet_NaN();
+
+  double target = q*fTotal;
+
+  // Out-of-range entries are only known through the extreme values
+  if (target <= fUnderflow) return fUnderflow > 0. ? fLowest : fMin;
+
+  double cumulative = fUnderflow;
+  for (size_t i = 0; i < fBins.size(); i++) {
+    if (fBins[i] > 0. && cumulative + fBins[i] >= target) {
+      double low  = fMin + i*fWidth;
+      double high = low + fWidth;
+      // Do not interpolate past the data actually seen
+      if (low < fLowest) low = fLowest;
+      if (high > fHighest) high = fHighest;
+      return low + (target - cumulative)/fBins[i]*(high - low);
+    }
+    cumulative += fBins[i];
+  }
+  return fHighest;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double QuantileSketch::Cumulative(double value) const
+{
+  // Out-of-range entries have no position, count them at the range ends
+  if (value < fMin) return 0.;
+  if (value >= fMax) return fTotal - fOverflow;
+
+  double position = (value - fMin)*fInvWidth;
+  size_t bin = size_t(position);
+  if (bin >= fBins.size()) bin = fBins.size() - 1;
+
+  double cumulative = fUnderflow;
+  for (size_t i = 0; i < bin; i++) cumulative += fBins[i];
+  return cumulative + (position - bin)*fBins[bin];
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,102 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file SchedulerMessenger.cc
+/// \brief Implementation of the SchedulerMessenger class
+
+#include "SchedulerMessenger.hh"
+#include "PinholeMTRunManager.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWithAnInteger.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SchedulerMessenger::SchedulerMessenger(PinholeMTRunManager* runManager)
+: G4UImessenger(),
+  fRunManager(runManager)
+{
+  fScheduleDir = new G4UIdirectory("/pinhole/schedule/", false);
+  fScheduleDir->SetGuidance("Hand-out of event batches to the worker threads.");
+
+  fModeCmd = new G4UIcmdWithAString("/pinhole/schedule/mode", this);
+  fModeCmd->SetGuidance("fixed: batches of the event modulo, as in");
+  fModeCmd->SetGuidance("G4MTRunManager. guided: batches shrink with the");
+  fModeCmd->SetGuidance("events left, so that threads finish together");
+  fModeCmd->SetGuidance("when event cost varies a lot.");
+  fModeCmd->SetParameterName("mode", false);
+  fModeCmd->SetCandidates("fixed guided");
+  fModeCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fModeCmd->SetToBeBroadcasted(false);
+
+  fMinBatchCmd = new G4UIcmdWithAnInteger("/pinhole/schedule/minBatch", this);
+  fMinBatchCmd->SetGuidance("Smallest guided batch. Raise it when events");
+  fMinBatchCmd->SetGuidance("are so cheap that fetching them is noticeable.");
+  fMinBatchCmd->SetParameterName("events", false);
+  fMinBatchCmd->SetRange("events>=1");
+  fMinBatchCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fMinBatchCmd->SetToBeBroadcasted(false);
+
+  fChunksCmd = new G4UIcmdWithAnInteger("/pinhole/schedule/chunks", this);
+  fChunksCmd->SetGuidance("Guided batches are the remaining events over");
+  fChunksCmd->SetGuidance("chunks x threads; more chunks shrink them sooner.");
+  fChunksCmd->SetParameterName("chunks", false);
+  fChunksCmd->SetRange("chunks>=1");
+  fChunksCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fChunksCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SchedulerMessenger::~SchedulerMessenger()
+{
+  delete fModeCmd;
+  delete fMinBatchCmd;
+  delete fChunksCmd;
+  delete fScheduleDir;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SchedulerMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  // Sequential build: one thread, nothing to schedule
+  if (!fRunManager) return;
+
+  if (command == fModeCmd) {
+    fRunManager->SetScheduling(newValue == "guided"
+                               ? PinholeMTRunManager::kGuided
+                               : PinholeMTRunManager::kFixed);
+  }
+  else if (command == fMinBatchCmd) {
+    fRunManager->SetMinBatch(fMinBatchCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fChunksCmd) {
+    fRunManager->SetChunksPerThread(fChunksCmd->GetNewIntValue(newValue));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,241 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file SourceDefinition.cc
+/// \brief Implementation of the SourceDefinition class
+
+#include "SourceDefinition.hh"
+#include "SourceMessenger.hh"
+
+#include "G4ParticleTable.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4Electron.hh"
+#include "G4SystemOfUnits.hh"
+#include "G4UnitsTable.hh"
+
+#include <algorithm>
+
+SourceDefinition* SourceDefinition::fgInstance = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SourceDefinition* SourceDefinition::Instance()
+{
+  if (!fgInstance) fgInstance = new SourceDefinition();
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SourceDefinition::SourceDefinition()
+: fMessenger(0),
+  fEnabled(false),
+  fParticle(G4Electron::Definition()),
+  fCentre(0., -9.5*cm, 0.),
+  fRotation1(1., 0., 0.),
+  fRotation2(0., 0., 1.),
+  fRadius(1.5*mm),
+  fSigmaR(0.75*mm),
+  fDirection(0., 1., 0.),
+  fMonoEnergy(100.*keV),
+  fMultiEnergy(false),
+  fBlockSize(0)
+{
+  BuildAxes();
+  fMessenger = new SourceMessenger(this);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SourceDefinition::~SourceDefinition()
+{
+  delete fMessenger;
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SourceDefinition::SetParticle(const G4String& name)
+{
+  G4ParticleDefinition* particle =
+    G4ParticleTable::GetParticleTable()->FindParticle(name);
+
+  if (!particle) {
+    G4cerr << "SourceDefinition: unknown particle " << name
+           << ", keeping " << fParticle->GetParticleName() << G4endl;
+    return;
+  }
+  fParticle = particle;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SourceDefinition::SetRotation1(const G4ThreeVector& rot1)
+{
+  fRotation1 = rot1;
+  BuildAxes();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SourceDefinition::SetRotation2(const G4ThreeVector& rot2)
+{
+  fRotation2 = rot2;
+  BuildAxes();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SourceDefinition::BuildAxes()
+{
+  // Same convention as G4SPSPosDistribution::GenerateRotationMatrices()
+  fAxisX = fRotation1.unit();
+  G4ThreeVector axisZ = fRotation1.cross(fRotation2).unit();
+  fAxisY = axisZ.cross(fAxisX).unit();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SourceDefinition::SetMonoEnergy(G4double energy)
+{
+  fMonoEnergy = energy;
+  ResetEnergyHistogram();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SourceDefinition::SetReferenceSpectrum(const EnergySpectrum& spectrum)
+{
+  fHistEnergies.clear();
+  fHistWeights.clear();
+  BuildEnergyTable();
+
+  fReference   = spectrum;
+  fMultiEnergy = true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SourceDefinition::AddEnergyHistogramPoint(G4double energy, G4double weight)
+{
+  // As with /gps/hist/point, the first point is the lower edge of the first
+  // bin and every following point the upper edge and weight of a bin
+  if (!fHistEnergies.empty() && energy <= fHistEnergies.back()) {
+    G4cerr << "SourceDefinition: histogram energies must increase, point "
+           << G4BestUnit(energy, "Energy") << " ignored" << G4endl;
+    return;
+  }
+  fHistEnergies.push_back(energy);
+  fHistWeights.push_back(fHistEnergies.size() == 1 ? 0. : weight);
+  fMultiEnergy = false;
+  BuildEnergyTable();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SourceDefinition::ResetEnergyHistogram()
+{
+  fHistEnergies.clear();
+  fHistWeights.clear();
+  fMultiEnergy = false;
+  BuildEnergyTable();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SourceDefinition::BuildEnergyTable()
+{
+  fEnergyEdges.clear();
+  fEnergyCDF.clear();
+
+  if (fHistEnergies.size() < 2) return;
+
+  G4double sum = 0.;
+  for (size_t i = 0; i < fHistWeights.size(); i++) sum += fHistWeights[i];
+  if (sum <= 0.) return;
+
+  fEnergyEdges = fHistEnergies;
+  fEnergyCDF.resize(fHistWeights.size());
+
+  G4double cumulative = 0.;
+  for (size_t i = 0; i < fHistWeights.size(); i++) {
+    cumulative += fHistWeights[i];
+    fEnergyCDF[i] = cumulative/sum;
+  }
+  fEnergyCDF.back() = 1.;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double SourceDefinition::SampleEnergy(G4double u) const
+{
+  if (fMultiEnergy) return fReference.Sample(u)*MeV;
+
+  if (fEnergyCDF.empty()) return fMonoEnergy;
+
+  // Uniform within the selected bin, as for a GPS user histogram
+  size_t bin = std::upper_bound(fEnergyCDF.begin(), fEnergyCDF.end(), u)
+               - fEnergyCDF.begin();
+  if (bin == 0) bin = 1;
+  if (bin >= fEnergyCDF.size()) bin = fEnergyCDF.size() - 1;
+
+  G4double width = fEnergyCDF[bin] - fEnergyCDF[bin-1];
+  G4double frac  = width > 0. ? (u - fEnergyCDF[bin-1])/width : 0.5;
+
+  return fEnergyEdges[bin-1] + frac*(fEnergyEdges[bin] - fEnergyEdges[bin-1]);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SourceDefinition::Print() const
+{
+  G4cout << "\n----------------- Shared source definition -----------------"
+         << "\n Enabled   : " << (fEnabled ? "yes" : "no")
+         << "\n Particle  : " << fParticle->GetParticleName()
+         << "\n Centre    : " << G4BestUnit(fCentre, "Length")
+         << "\n Direction : " << fDirection
+         << "\n Radius    : " << G4BestUnit(fRadius, "Length")
+         << "\n Sigma_r   : " << G4BestUnit(fSigmaR, "Length");
+
+  if (fBlockSize > 0) {
+    G4cout << "\n Sampling  : blocks of " << fBlockSize << " per thread";
+  }
+
+  if (fMultiEnergy) {
+    G4cout << "\n Energy    : reference " << fReference.ToString() << " (MeV)";
+  }
+  else if (fEnergyCDF.empty()) {
+    G4cout << "\n Energy    : " << G4BestUnit(fMonoEnergy, "Energy");
+  }
+  else {
+    G4cout << "\n Energy    : histogram, " << fEnergyCDF.size() - 1
+           << " bins from " << G4BestUnit(fEnergyEdges.front(), "Energy")
+           << " to " << G4BestUnit(fEnergyEdges.back(), "Energy");
+  }
+  G4cout << "\n------------------------------------------------------------"
+         << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,289 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file SourceMessenger.cc
+/// \brief Implementation of the SourceMessenger class
+
+#include "SourceMessenger.hh"
+#include "SourceDefinition.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcommand.hh"
+#include "G4UIparameter.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4UIcmdWith3Vector.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithoutParameter.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UnitsTable.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SourceMessenger::SourceMessenger(SourceDefinition* source)
+: G4UImessenger(),
+  fSource(source)
+{
+  fPinholeDir = new G4UIdirectory("/pinhole/", false);
+  fPinholeDir->SetGuidance("Pinhole detector simulation control.");
+
+  fSourceDir = new G4UIdirectory("/pinhole/source/", false);
+  fSourceDir->SetGuidance("Shared primary source, built on the master thread.");
+
+  fEnableCmd = new G4UIcmdWithABool("/pinhole/source/enable", this);
+  fEnableCmd->SetGuidance("Use the shared source instead of a per-thread GPS.");
+  fEnableCmd->SetGuidance("Set before /run/initialize so that the workers never");
+  fEnableCmd->SetGuidance("build their GPS in the first place.");
+  fEnableCmd->SetParameterName("enable", true);
+  fEnableCmd->SetDefaultValue(true);
+  fEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fParticleCmd = new G4UIcmdWithAString("/pinhole/source/particle", this);
+  fParticleCmd->SetGuidance("Primary particle name.");
+  fParticleCmd->SetParameterName("particle", false);
+  fParticleCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fCentreCmd = new G4UIcmdWith3VectorAndUnit("/pinhole/source/centre", this);
+  fCentreCmd->SetGuidance("Centre of the beam spot.");
+  fCentreCmd->SetParameterName("X", "Y", "Z", false);
+  fCentreCmd->SetDefaultUnit("cm");
+  fCentreCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fDirectionCmd = new G4UIcmdWith3Vector("/pinhole/source/direction", this);
+  fDirectionCmd->SetGuidance("Beam momentum direction (normalised internally).");
+  fDirectionCmd->SetParameterName("Px", "Py", "Pz", false);
+  fDirectionCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fRot1Cmd = new G4UIcmdWith3Vector("/pinhole/source/rot1", this);
+  fRot1Cmd->SetGuidance("First vector spanning the beam spot plane.");
+  fRot1Cmd->SetParameterName("R1x", "R1y", "R1z", false);
+  fRot1Cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fRot2Cmd = new G4UIcmdWith3Vector("/pinhole/source/rot2", this);
+  fRot2Cmd->SetGuidance("Second vector spanning the beam spot plane.");
+  fRot2Cmd->SetParameterName("R2x", "R2y", "R2z", false);
+  fRot2Cmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fRadiusCmd = new G4UIcmdWithADoubleAndUnit("/pinhole/source/radius", this);
+  fRadiusCmd->SetGuidance("Radius of the circular beam spot.");
+  fRadiusCmd->SetParameterName("radius", false);
+  fRadiusCmd->SetRange("radius>=0.");
+  fRadiusCmd->SetDefaultUnit("mm");
+  fRadiusCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fSigmaRCmd = new G4UIcmdWithADoubleAndUnit("/pinhole/source/sigma_r", this);
+  fSigmaRCmd->SetGuidance("Gaussian smearing of the beam spot.");
+  fSigmaRCmd->SetParameterName("sigma_r", false);
+  fSigmaRCmd->SetRange("sigma_r>=0.");
+  fSigmaRCmd->SetDefaultUnit("mm");
+  fSigmaRCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fEnergyCmd = new G4UIcmdWithADoubleAndUnit("/pinhole/source/energy", this);
+  fEnergyCmd->SetGuidance("Mono-energetic beam (clears any histogram).");
+  fEnergyCmd->SetParameterName("energy", false);
+  fEnergyCmd->SetRange("energy>0.");
+  fEnergyCmd->SetDefaultUnit("keV");
+  fEnergyCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fHistPointCmd = new G4UIcommand("/pinhole/source/hist/point", this);
+  fHistPointCmd->SetGuidance("Add a point to the energy histogram.");
+  fHistPointCmd->SetGuidance("The first point is the lower edge of the first bin,");
+  fHistPointCmd->SetGuidance("later points are bin upper edges with their weight.");
+  G4UIparameter* energyPrm = new G4UIparameter("energy", 'd', false);
+  fHistPointCmd->SetParameter(energyPrm);
+  G4UIparameter* weightPrm = new G4UIparameter("weight", 'd', true);
+  weightPrm->SetDefaultValue(0.);
+  fHistPointCmd->SetParameter(weightPrm);
+  G4UIparameter* unitPrm = new G4UIparameter("unit", 's', true);
+  unitPrm->SetDefaultValue("keV");
+  fHistPointCmd->SetParameter(unitPrm);
+  fHistPointCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fHistResetCmd = new G4UIcmdWithoutParameter("/pinhole/source/hist/reset", this);
+  fHistResetCmd->SetGuidance("Clear the energy histogram (back to mono).");
+  fHistResetCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fReferenceCmd = new G4UIcommand("/pinhole/source/reference", this);
+  fReferenceCmd->SetGuidance("Multi-energy mode: sample primaries from a broad");
+  fReferenceCmd->SetGuidance("reference spectrum and tag every hit with the");
+  fReferenceCmd->SetGuidance("primary energy and weight for later reweighting.");
+  fReferenceCmd->SetGuidance("param is the power-law index, or the e-folding");
+  fReferenceCmd->SetGuidance("energy (in the given unit) for an exponential.");
+  G4UIparameter* shapePrm = new G4UIparameter("shape", 's', false);
+  shapePrm->SetParameterCandidates("powerlaw exponential");
+  fReferenceCmd->SetParameter(shapePrm);
+  G4UIparameter* eminPrm = new G4UIparameter("emin", 'd', false);
+  fReferenceCmd->SetParameter(eminPrm);
+  G4UIparameter* emaxPrm = new G4UIparameter("emax", 'd', false);
+  fReferenceCmd->SetParameter(emaxPrm);
+  G4UIparameter* paramPrm = new G4UIparameter("param", 'd', true);
+  paramPrm->SetDefaultValue(1.);
+  fReferenceCmd->SetParameter(paramPrm);
+  G4UIparameter* refUnitPrm = new G4UIparameter("unit", 's', true);
+  refUnitPrm->SetDefaultValue("keV");
+  fReferenceCmd->SetParameter(refUnitPrm);
+  fReferenceCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fBlockCmd = new G4UIcmdWithAnInteger("/pinhole/source/block", this);
+  fBlockCmd->SetGuidance("Pre-sample primaries in blocks of this many per");
+  fBlockCmd->SetGuidance("thread, with array RNG draws and transforms, and");
+  fBlockCmd->SetGuidance("serve each event from the block. Same distribution,");
+  fBlockCmd->SetGuidance("but events no longer own their primary's random");
+  fBlockCmd->SetGuidance("numbers. 0 samples every event on its own.");
+  fBlockCmd->SetParameterName("events", false);
+  fBlockCmd->SetRange("events>=0");
+  fBlockCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fListCmd = new G4UIcmdWithoutParameter("/pinhole/source/list", this);
+  fListCmd->SetGuidance("Print the shared source definition.");
+
+  // Workers read the master's definition, nothing to replay on them
+  fEnableCmd->SetToBeBroadcasted(false);
+  fParticleCmd->SetToBeBroadcasted(false);
+  fCentreCmd->SetToBeBroadcasted(false);
+  fDirectionCmd->SetToBeBroadcasted(false);
+  fRot1Cmd->SetToBeBroadcasted(false);
+  fRot2Cmd->SetToBeBroadcasted(false);
+  fRadiusCmd->SetToBeBroadcasted(false);
+  fSigmaRCmd->SetToBeBroadcasted(false);
+  fEnergyCmd->SetToBeBroadcasted(false);
+  fHistPointCmd->SetToBeBroadcasted(false);
+  fHistResetCmd->SetToBeBroadcasted(false);
+  fReferenceCmd->SetToBeBroadcasted(false);
+  fBlockCmd->SetToBeBroadcasted(false);
+  fListCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+SourceMessenger::~SourceMessenger()
+{
+  delete fEnableCmd;
+  delete fParticleCmd;
+  delete fCentreCmd;
+  delete fDirectionCmd;
+  delete fRot1Cmd;
+  delete fRot2Cmd;
+  delete fRadiusCmd;
+  delete fSigmaRCmd;
+  delete fEnergyCmd;
+  delete fHistPointCmd;
+  delete fHistResetCmd;
+  delete fReferenceCmd;
+  delete fBlockCmd;
+  delete fListCmd;
+  delete fSourceDir;
+  delete fPinholeDir;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void SourceMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fEnableCmd) {
+    fSource->SetEnabled(fEnableCmd->GetNewBoolValue(newValue));
+  }
+  else if (command == fParticleCmd) {
+    fSource->SetParticle(newValue);
+  }
+  else if (command == fCentreCmd) {
+    fSource->SetCentre(fCentreCmd->GetNew3VectorValue(newValue));
+  }
+  else if (command == fDirectionCmd) {
+    fSource->SetDirection(fDirectionCmd->GetNew3VectorValue(newValue));
+  }
+  else if (command == fRot1Cmd) {
+    fSource->SetRotation1(fRot1Cmd->GetNew3VectorValue(newValue));
+  }
+  else if (command == fRot2Cmd) {
+    fSource->SetRotation2(fRot2Cmd->GetNew3VectorValue(newValue));
+  }
+  else if (command == fRadiusCmd) {
+    fSource->SetRadius(fRadiusCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == fSigmaRCmd) {
+    fSource->SetSigmaR(fSigmaRCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == fEnergyCmd) {
+    fSource->SetMonoEnergy(fEnergyCmd->GetNewDoubleValue(newValue));
+  }
+  else if (command == fHistPointCmd) {
+    G4double energy, weight;
+    G4String unit;
+    std::istringstream is(newValue);
+    is >> energy >> weight >> unit;
+    fSource->AddEnergyHistogramPoint(energy*G4UIcommand::ValueOf(unit), weight);
+  }
+  else if (command == fHistResetCmd) {
+    fSource->ResetEnergyHistogram();
+  }
+  else if (command == fReferenceCmd) {
+    G4String shape, unit;
+    G4double emin, emax, param;
+    std::istringstream is(newValue);
+    is >> shape >> emin >> emax >> param >> unit;
+
+    // Rejected like the range-checked commands: the spectrum could not be
+    // normalised (an exponential needs a positive e-folding energy)
+    if (emin <= 0. || emax <= emin) {
+      G4Exception("SourceMessenger::SetNewValue()", "Source001", JustWarning,
+                  "/pinhole/source/reference needs 0 < emin < emax,"
+                  " command ignored.");
+      return;
+    }
+    if (shape == "exponential" && !(param > 0.)) {
+      G4Exception("SourceMessenger::SetNewValue()", "Source002", JustWarning,
+                  "/pinhole/source/reference exponential needs an e-folding"
+                  " energy > 0, command ignored.");
+      return;
+    }
+
+    // The reference spectrum is kept in MeV, like the hit energies
+    G4double toMeV = G4UIcommand::ValueOf(unit)/MeV;
+    EnergySpectrum spectrum;
+    if (shape == "exponential") {
+      spectrum = EnergySpectrum(EnergySpectrum::kExponential,
+                                emin*toMeV, emax*toMeV, param*toMeV);
+    }
+    else {
+      spectrum = EnergySpectrum(EnergySpectrum::kPowerLaw,
+                                emin*toMeV, emax*toMeV, param);
+    }
+
+    fSource->SetReferenceSpectrum(spectrum);
+  }
+  else if (command == fBlockCmd) {
+    fSource->SetBlockSize(fBlockCmd->GetNewIntValue(newValue));
+  }
+  else if (command == fListCmd) {
+    fSource->Print();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
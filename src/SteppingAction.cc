@@ -30,7 +30,13 @@
 
 #include "SteppingAction.hh"
 #include "EventAction.hh"
+#include "RunAction.hh"
 #include "DetectorConstruction.hh"
+#include "Run.hh"
+#include "PixelImage.hh"
+#include "PixelDigitizer.hh"
+#include "Telemetry.hh"
+#include "PerfCounters.hh"
 // #include "DetectorAnalysis.hh"
 #include "G4Step.hh"
 #include "G4Track.hh"
@@ -45,7 +51,8 @@
 
 SteppingAction::SteppingAction(EventAction* eventAction)
 : G4UserSteppingAction(),
-  fEventAction(eventAction)
+  fEventAction(eventAction),
+  fDetector(0)
 {}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -57,37 +64,70 @@ SteppingAction::~SteppingAction()
 
 void SteppingAction::UserSteppingAction(const G4Step* step)
 {
+  // Profiling: the time since the previous step goes to this step's volume
+  if (PerfCounters* perf = fEventAction->GetPerf()) {
+    perf->CountStep(
+      step->GetPreStepPoint()->GetPhysicalVolume()->GetLogicalVolume());
+  }
 
-
-  G4bool isEnteringDetector1;
+  // The geometry only exists once the run manager is initialised
+  if (!fDetector) {
+    fDetector = static_cast<const DetectorConstruction*>
+      (G4RunManager::GetRunManager()->GetUserDetectorConstruction());
+  }
 
   G4Track* track = step->GetTrack();
   const G4StepPoint* postPoint = step->GetPostStepPoint();
 
-  G4String volName;
-  if (track->GetVolume()) {volName = track->GetVolume()->GetName();}
-  G4String nextVolName;
-  if (track->GetNextVolume()) {nextVolName = track->GetNextVolume()->GetName();}
-
-
-  isEnteringDetector1 = (volName != "detector1" && nextVolName == "detector1");
-
-  // Detector 1 particles
-  if (isEnteringDetector1){
-
-    fEventAction->incrementDetector1Flag();
-
-    G4ThreeVector pos = postPoint->GetPosition();
-    G4double ene = postPoint->GetKineticEnergy();
+  // Layer being entered in this step, -1 if none
+  const G4VPhysicalVolume* volume     = track->GetVolume();
+  const G4VPhysicalVolume* nextVolume = track->GetNextVolume();
+  G4int enteredLayer = nextVolume != volume
+                     ? fDetector->GetLayerIndex(nextVolume) : -1;
+
+  G4bool isEnteringDetector1 = enteredLayer == 0;
+  G4bool isInDetector1       = volume == fDetector->GetLayerVolume(0);
+
+  // Pixelated readout: entries and deposited energy per pixel
+  Run* run = 0;
+  PixelImage* image = 0;
+  if (isEnteringDetector1 || isInDetector1) {
+    run = static_cast<Run*>(
+      G4RunManager::GetRunManager()->GetNonConstCurrentRun());
+    image = run->GetImage();
+  }
 
-    std::ofstream hitFile_detector1;
-    hitFile_detector1.open("../analysis/data/hits.csv", std::ios_base::app);
-    hitFile_detector1 << "\n" << pos.x()/cm << "," << pos.y()/cm << "," << pos.z()/cm << ","
-    << ene;
-    hitFile_detector1.close();
+  if (image) {
+    if (isEnteringDetector1) {
+      const G4ThreeVector& pos = postPoint->GetPosition();
+      image->Fill(pos.x(), pos.z(), 1., 0.);
+    }
+
+    G4double edep = step->GetTotalEnergyDeposit();
+    if (edep > 0. && isInDetector1) {
+      G4ThreeVector mid = 0.5*(step->GetPreStepPoint()->GetPosition()
+                               + postPoint->GetPosition());
+      image->Fill(mid.x(), mid.z(), 0., edep);
+    }
   }
 
+  // Deposits for the digitization of accepted events
+  if (isInDetector1 && PixelDigitizer::IsEnabled()) {
+    G4double edep = step->GetTotalEnergyDeposit();
+    if (edep > 0.) {
+      fEventAction->AddDeposit(0.5*(step->GetPreStepPoint()->GetPosition()
+                                    + postPoint->GetPosition()), edep);
+    }
+  }
 
+  // Layer entries, buffered for the trigger in EndOfEventAction
+  if (enteredLayer >= 0) {
+    if (isEnteringDetector1) Telemetry::CountHit();
+    fEventAction->AddHit(enteredLayer, postPoint->GetPosition(),
+                         postPoint->GetMomentumDirection(),
+                         postPoint->GetKineticEnergy(),
+                         track->GetParentID() == 0);
+  }
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,312 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file Telemetry.cc
+/// \brief Implementation of the Telemetry class
+
+#include "Telemetry.hh"
+#include "TelemetryMessenger.hh"
+#include "OutputManager.hh"
+
+#include "G4RunManager.hh"
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+#include <sys/time.h>
+#include <unistd.h>
+
+Telemetry*          Telemetry::fgInstance = 0;
+Telemetry::Counters Telemetry::fgCounters[Telemetry::kMaxSlots];
+
+namespace
+{
+  G4double WallSeconds()
+  {
+    timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec + 1.e-6*now.tv_usec;
+  }
+
+  // Resident set size from /proc, 0 where it is not available
+  G4double ResidentMB()
+  {
+    std::ifstream statm("/proc/self/statm");
+    long pages = 0, resident = 0;
+    if (!(statm >> pages >> resident)) return 0.;
+    return resident*G4double(sysconf(_SC_PAGESIZE))/(1024.*1024.);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Telemetry* Telemetry::Instance()
+{
+  if (!fgInstance) fgInstance = new Telemetry();
+  return fgInstance;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Telemetry::Telemetry()
+: fMessenger(0),
+  fStop(false),
+  fFileName(OutputManager::Instance()->GetJobPath("status.json")),
+  fFollowOutput(true),
+  fInterval(2.),
+  fRunID(-1),
+  fEventsToProcess(0),
+  fRunning(false),
+  fFirstSlot(0),
+  fNSlots(1),
+  fRunStart(WallSeconds()),
+  fRunEnd(fRunStart),
+  fJobEvents(0),
+  fJobDone(0),
+  fJobFirstDone(0),
+  fJobStart(fRunStart),
+  fRunEvents(1, 0),
+  fRunHits(1, 0),
+  fLastEvents(1, 0),
+  fLastProgress(1, fRunStart),
+  fLastHits(0),
+  fLastSample(fRunStart)
+{
+  fMessenger = new TelemetryMessenger(this);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+Telemetry::~Telemetry()
+{
+  if (fPublisher.joinable()) {
+    SetEnabled(false);
+    std::lock_guard<std::mutex> lock(fMutex);
+    Sample("finished");
+  }
+  delete fMessenger;
+  fgInstance = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Telemetry::SetEnabled(G4bool enabled)
+{
+  if (enabled && !fPublisher.joinable()) {
+    fStop = false;
+    fPublisher = std::thread(&Telemetry::Publish, this);
+  }
+  else if (!enabled && fPublisher.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(fMutex);
+      fStop = true;
+    }
+    fWakeUp.notify_all();
+    fPublisher.join();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Telemetry::SetFileName(const G4String& name)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fFileName     = name;
+  fFollowOutput = false;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Telemetry::SetInterval(G4double seconds)
+{
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fInterval = seconds;
+  }
+  fWakeUp.notify_all();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Telemetry::BeginRun(G4int runID, G4int nEvents)
+{
+  G4int nThreads = 0;
+#ifdef G4MULTITHREADED
+  G4MTRunManager* mtRunManager
+    = dynamic_cast<G4MTRunManager*>(G4RunManager::GetRunManager());
+  if (mtRunManager) nThreads = mtRunManager->GetNumberOfThreads();
+#endif
+
+  std::lock_guard<std::mutex> lock(fMutex);
+  if (fFollowOutput) {
+    fFileName = OutputManager::Instance()->GetJobPath("status.json");
+  }
+  fRunID           = runID;
+  fEventsToProcess = nEvents;
+  fRunning         = true;
+
+  // Workers use slots 1..n, a sequential run the master's slot 0
+  fFirstSlot = nThreads > 0 ? 1 : 0;
+  fNSlots    = nThreads > 0 ? std::min(nThreads, kMaxSlots - 1) : 1;
+  fRunStart  = WallSeconds();
+  fLastSample = fRunStart;
+  fLastHits   = 0;
+
+  fRunEvents.assign(fNSlots, 0);
+  fRunHits.assign(fNSlots, 0);
+  fLastEvents.assign(fNSlots, 0);
+  fLastProgress.assign(fNSlots, fRunStart);
+  for (G4int i = 0; i < fNSlots; i++) {
+    fRunEvents[i] = fgCounters[fFirstSlot + i].fEvents.load(std::memory_order_relaxed);
+    fRunHits[i]   = fgCounters[fFirstSlot + i].fHits.load(std::memory_order_relaxed);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Telemetry::EndRun()
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fRunning = false;
+  fRunEnd  = WallSeconds();
+  if (fPublisher.joinable()) Sample("idle");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Telemetry::SetJob(G4int nEvents, G4int nDone)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  if (fJobEvents == 0) {
+    fJobStart     = WallSeconds();
+    fJobFirstDone = nDone;
+  }
+  fJobEvents = nEvents;
+  fJobDone   = nDone;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Telemetry::EndJob()
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fJobEvents = 0;
+  fJobDone   = 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Telemetry::Publish()
+{
+  std::unique_lock<std::mutex> lock(fMutex);
+  while (!fStop) {
+    Sample(fRunning ? "running" : "idle");
+    fWakeUp.wait_for(lock, std::chrono::duration<double>(fInterval));
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void Telemetry::Sample(const char* state)
+{
+  // Called with fMutex held
+  G4double now = WallSeconds();
+  G4double dt  = now - fLastSample;
+
+  std::vector<long> events(fNSlots), hits(fNSlots);
+  long totalEvents = 0, totalHits = 0;
+  for (G4int i = 0; i < fNSlots; i++) {
+    const Counters& counters = fgCounters[fFirstSlot + i];
+    events[i] = counters.fEvents.load(std::memory_order_relaxed) - fRunEvents[i];
+    hits[i]   = counters.fHits.load(std::memory_order_relaxed) - fRunHits[i];
+    totalEvents += events[i];
+    totalHits   += hits[i];
+  }
+
+  // Events of the run, or of the checkpointed job between and across its
+  // chunks, not yet handed out or still being processed
+  G4bool   inJob     = fJobEvents > 0;
+  G4bool   active    = fRunning || inJob;
+  long     toProcess = inJob ? fJobEvents : fEventsToProcess;
+  long     done      = (inJob ? fJobDone : 0) + totalEvents;
+  long     started   = inJob ? fJobFirstDone : 0;
+  G4double elapsed   = (active ? now : fRunEnd) - (inJob ? fJobStart : fRunStart);
+  G4double average   = elapsed > 0. ? (done - started)/elapsed : 0.;
+  long     queued    = active ? std::max(toProcess - done, 0L) : 0;
+  G4double eta       = average > 0. ? queued/average : -1.;
+  G4double hitRate   = dt > 0. ? (totalHits - fLastHits)/dt : 0.;
+  long     lastTotal = 0;
+  for (G4int i = 0; i < fNSlots; i++) lastTotal += fLastEvents[i];
+  G4double eventRate = dt > 0. ? (totalEvents - lastTotal)/dt : 0.;
+
+  std::string temporary = fFileName + ".tmp";
+  std::ofstream out(temporary.c_str());
+  out << std::fixed << std::setprecision(3)
+      << "{\n"
+      << "  \"state\": \"" << state << "\",\n"
+      << "  \"pid\": " << getpid() << ",\n"
+      << "  \"updated\": " << now << ",\n"
+      << "  \"run\": " << fRunID << ",\n"
+      << "  \"eventsToProcess\": " << toProcess << ",\n"
+      << "  \"eventsDone\": " << done << ",\n"
+      << "  \"eventsQueued\": " << queued << ",\n"
+      << "  \"hits\": " << totalHits << ",\n"
+      << "  \"eventsPerSecond\": " << eventRate << ",\n"
+      << "  \"hitsPerSecond\": " << hitRate << ",\n"
+      << "  \"averageEventsPerSecond\": " << average << ",\n"
+      << "  \"secondsElapsed\": " << elapsed << ",\n"
+      << "  \"etaSeconds\": " << eta << ",\n"
+      << "  \"rssMB\": " << ResidentMB() << ",\n"
+      << "  \"threads\": [\n";
+
+  // One thread per line, so that tools/runstatus needs no JSON library
+  for (G4int i = 0; i < fNSlots; i++) {
+    if (events[i] != fLastEvents[i]) fLastProgress[i] = now;
+    G4double rate = dt > 0. ? (events[i] - fLastEvents[i])/dt : 0.;
+    out << "    {\"id\": " << i
+        << ", \"events\": " << events[i]
+        << ", \"hits\": " << hits[i]
+        << ", \"eventsPerSecond\": " << rate
+        << ", \"secondsSinceProgress\": "
+        << (fRunning ? now - fLastProgress[i] : 0.)
+        << "}" << (i + 1 < fNSlots ? "," : "") << "\n";
+    fLastEvents[i] = events[i];
+  }
+  out << "  ]\n}\n";
+  out.close();
+
+  if (out) std::rename(temporary.c_str(), fFileName.c_str());
+
+  fLastHits   = totalHits;
+  fLastSample = now;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
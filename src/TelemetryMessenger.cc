@@ -0,0 +1,97 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file TelemetryMessenger.cc
+/// \brief Implementation of the TelemetryMessenger class
+
+#include "TelemetryMessenger.hh"
+#include "Telemetry.hh"
+
+#include "G4UIdirectory.hh"
+#include "G4UIcmdWithABool.hh"
+#include "G4UIcmdWithADoubleAndUnit.hh"
+#include "G4UIcmdWithAString.hh"
+#include "G4SystemOfUnits.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TelemetryMessenger::TelemetryMessenger(Telemetry* telemetry)
+: G4UImessenger(),
+  fTelemetry(telemetry)
+{
+  fTelemetryDir = new G4UIdirectory("/pinhole/telemetry/", false);
+  fTelemetryDir->SetGuidance("Live progress in a JSON status file.");
+
+  fEnableCmd = new G4UIcmdWithABool("/pinhole/telemetry/enable", this);
+  fEnableCmd->SetGuidance("Start or stop rewriting the status file.");
+  fEnableCmd->SetGuidance("Watch it with tools/runstatus.");
+  fEnableCmd->SetParameterName("enable", true);
+  fEnableCmd->SetDefaultValue(true);
+  fEnableCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fEnableCmd->SetToBeBroadcasted(false);
+
+  fFileCmd = new G4UIcmdWithAString("/pinhole/telemetry/file", this);
+  fFileCmd->SetGuidance("Status file, replaced atomically on every update.");
+  fFileCmd->SetParameterName("file", false);
+  fFileCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fFileCmd->SetToBeBroadcasted(false);
+
+  fIntervalCmd
+    = new G4UIcmdWithADoubleAndUnit("/pinhole/telemetry/interval", this);
+  fIntervalCmd->SetGuidance("Time between updates of the status file.");
+  fIntervalCmd->SetParameterName("interval", false);
+  fIntervalCmd->SetRange("interval>0");
+  fIntervalCmd->SetUnitCategory("Time");
+  fIntervalCmd->SetDefaultUnit("s");
+  fIntervalCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+  fIntervalCmd->SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TelemetryMessenger::~TelemetryMessenger()
+{
+  delete fEnableCmd;
+  delete fFileCmd;
+  delete fIntervalCmd;
+  delete fTelemetryDir;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TelemetryMessenger::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if (command == fEnableCmd) {
+    fTelemetry->SetEnabled(fEnableCmd->GetNewBoolValue(newValue));
+  }
+  else if (command == fFileCmd) {
+    fTelemetry->SetFileName(newValue);
+  }
+  else if (command == fIntervalCmd) {
+    fTelemetry->SetInterval(fIntervalCmd->GetNewDoubleValue(newValue)/s);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
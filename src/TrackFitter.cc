@@ -0,0 +1,158 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file TrackFitter.cc
+/// \brief Implementation of the TrackFitter class
+
+#include "TrackFitter.hh"
+
+#include <algorithm>
+#include <cmath>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+TrackFitter::TrackFitter()
+{
+  fPoints.reserve(16);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TrackFitter::AddPoint(int layer, double x, double y, double z)
+{
+  Point point = { layer, x, y, z };
+  fPoints.push_back(point);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+bool TrackFitter::Fit(double yReference, Track& track) const
+{
+  // Layers that were hit, upstream first
+  fLayers.clear();
+  for (size_t i = 0; i < fPoints.size(); i++) fLayers.push_back(fPoints[i].layer);
+  std::sort(fLayers.begin(), fLayers.end());
+  fLayers.erase(std::unique(fLayers.begin(), fLayers.end()), fLayers.end());
+  if (fLayers.size() < 2) return false;
+
+  bool found = false;
+  for (size_t a = 0; a < fPoints.size(); a++) {
+    if (fPoints[a].layer != fLayers[0]) continue;
+    for (size_t b = 0; b < fPoints.size(); b++) {
+      if (fPoints[b].layer != fLayers[1]) continue;
+
+      const Point& pa = fPoints[a];
+      const Point& pb = fPoints[b];
+      double slopeX = (pb.x - pa.x)/(pb.y - pa.y);
+      double slopeZ = (pb.z - pa.z)/(pb.y - pa.y);
+
+      // Nearest hit to the seed line in every further layer
+      fSelection.assign(1, int(a));
+      fSelection.push_back(int(b));
+      for (size_t l = 2; l < fLayers.size(); l++) {
+        int nearest = -1;
+        double nearestDistance = 0.;
+        for (size_t i = 0; i < fPoints.size(); i++) {
+          if (fPoints[i].layer != fLayers[l]) continue;
+          double dx = fPoints[i].x - pa.x - slopeX*(fPoints[i].y - pa.y);
+          double dz = fPoints[i].z - pa.z - slopeZ*(fPoints[i].y - pa.y);
+          double distance = dx*dx + dz*dz;
+          if (nearest < 0 || distance < nearestDistance) {
+            nearest = int(i);
+            nearestDistance = distance;
+          }
+        }
+        fSelection.push_back(nearest);
+      }
+
+      Track candidate;
+      FitSelection(yReference, candidate);
+      if (!found || candidate.rms < track.rms) {
+        track = candidate;
+        track.firstPoint = int(a);
+        found = true;
+      }
+    }
+  }
+  return found;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void TrackFitter::FitSelection(double yReference, Track& track) const
+{
+  const double n = fSelection.size();
+  double meanX = 0., meanY = 0., meanZ = 0.;
+  for (size_t i = 0; i < fSelection.size(); i++) {
+    const Point& point = fPoints[fSelection[i]];
+    meanX += point.x;
+    meanY += point.y;
+    meanZ += point.z;
+  }
+  meanX /= n;
+  meanY /= n;
+  meanZ /= n;
+
+  // Least squares in x(y) and z(y) separately
+  double syy = 0., sxy = 0., szy = 0.;
+  for (size_t i = 0; i < fSelection.size(); i++) {
+    const Point& point = fPoints[fSelection[i]];
+    double dy = point.y - meanY;
+    syy += dy*dy;
+    sxy += dy*(point.x - meanX);
+    szy += dy*(point.z - meanZ);
+  }
+
+  track.nLayers = int(fSelection.size());
+  track.slopeX  = syy > 0. ? sxy/syy : 0.;
+  track.slopeZ  = syy > 0. ? szy/syy : 0.;
+  track.x       = meanX + track.slopeX*(yReference - meanY);
+  track.z       = meanZ + track.slopeZ*(yReference - meanY);
+
+  double sum2 = 0.;
+  for (size_t i = 0; i < fSelection.size(); i++) {
+    const Point& point = fPoints[fSelection[i]];
+    double dx = point.x - meanX - track.slopeX*(point.y - meanY);
+    double dz = point.z - meanZ - track.slopeZ*(point.y - meanY);
+    sum2 += dx*dx + dz*dz;
+  }
+  track.rms = std::sqrt(sum2/n);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double TrackFitter::GetTheta(const Track& track) const
+{
+  return std::atan(track.slopeZ)*180./3.14159265358979323846;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+double TrackFitter::GetPhi(const Track& track) const
+{
+  return std::atan(track.slopeX)*180./3.14159265358979323846;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
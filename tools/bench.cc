@@ -0,0 +1,649 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+/// \file bench.cc
+/// \brief Micro-benchmarks of the simulation hot path
+
+// Usage:
+//   bench [options]      (run from the build directory, like main)
+//
+//   -t <sec>     minimum measuring time per benchmark (default 0.5)
+//   -f <text>    only run benchmarks whose name contains text
+//   -o <file>    also append the results to file
+//
+// Prints one JSON object per benchmark and line:
+//   {"benchmark": "...", "ops": n, "ns_per_op": t, "allocs_per_op": a}
+// Allocations are counted by replacing the global operator new, so they
+// include those made inside Geant4. Compare runs of the same build host.
+//
+// The action and output benchmarks drive SteppingAction, EventAction and
+// OutputFile themselves, writing into a temporary directory under $TMPDIR
+// (or /tmp) that is removed afterwards.
+//
+// The primary_spot_* checks compare the beam spot moments of the shared
+// source, per event and in blocks, with GPS for the same beam and print
+//   {"check": "...", ..., "passed": true|false}
+// A failed check makes the exit status 1.
+
+#include "DetectorConstruction.hh"
+#include "PrimaryGeneratorAction.hh"
+#include "SourceDefinition.hh"
+#include "RunAction.hh"
+#include "EventAction.hh"
+#include "SteppingAction.hh"
+#include "OutputFile.hh"
+#include "OutputManager.hh"
+
+#include "G4RunManager.hh"
+#include "G4Run.hh"
+#include "G4UImanager.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4LogicalVolume.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4SolidStore.hh"
+#include "G4GeometryManager.hh"
+#include "G4Navigator.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4Box.hh"
+#include "G4Event.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4DynamicParticle.hh"
+#include "G4TouchableHandle.hh"
+#include "G4TouchableHistory.hh"
+#include "G4Electron.hh"
+#include "G4Geantino.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+// Every heap allocation of the process, Geant4 included
+namespace
+{
+  std::atomic<unsigned long> gAllocations(0);
+}
+
+void* operator new(std::size_t size)
+{
+  gAllocations.fetch_add(1, std::memory_order_relaxed);
+  void* memory = std::malloc(size ? size : 1);
+  if (!memory) throw std::bad_alloc();
+  return memory;
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+  double gMinSeconds = 0.5;
+  std::string gFilter;
+  std::ofstream gOutput;
+
+  // Keeps the compiler from dropping the measured work
+  volatile double gSink = 0.;
+
+  void Usage()
+  {
+    std::cerr << "usage: bench [-t seconds] [-f filter] [-o results.jsonl]"
+              << std::endl;
+  }
+
+  bool Selected(const std::string& name)
+  {
+    return gFilter.empty() || name.find(gFilter) != std::string::npos;
+  }
+
+  // Runs op(i) in growing batches until gMinSeconds have been measured
+  template <class Operation>
+  void Measure(const char* name, Operation op)
+  {
+    if (!Selected(name)) return;
+
+    typedef std::chrono::steady_clock Clock;
+    for (long i = 0; i < 1000; i++) op(i);   // warm-up
+
+    long ops = 0;
+    long batch = 1000;
+    double seconds = 0.;
+    unsigned long allocations = 0;
+    while (seconds < gMinSeconds) {
+      unsigned long allocationsBefore = gAllocations.load();
+      Clock::time_point start = Clock::now();
+      for (long i = 0; i < batch; i++) op(ops + i);
+      seconds += std::chrono::duration<double>(Clock::now() - start).count();
+      allocations += gAllocations.load() - allocationsBefore;
+      ops += batch;
+      if (batch < 10000000) batch *= 2;
+    }
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "{\"benchmark\": \"%s\", \"ops\": %ld,"
+                  " \"ns_per_op\": %.2f, \"allocs_per_op\": %.3f}", name, ops,
+                  1.e9*seconds/ops, double(allocations)/ops);
+    std::cout << line << std::endl;
+    if (gOutput.is_open()) gOutput << line << std::endl;
+  }
+
+  // Mean and variance of the primary vertex x and z (the beam plane of the
+  // sources below) over n generated events
+  struct SpotMoments
+  {
+    double mean[2];
+    double variance[2];
+    long   n;
+  };
+
+  SpotMoments MeasureSpot(PrimaryGeneratorAction* generator, long n)
+  {
+    double sum[2] = { 0., 0. }, sum2[2] = { 0., 0. };
+    for (long i = 0; i < n; i++) {
+      G4Event event(static_cast<G4int>(i));
+      generator->GeneratePrimaries(&event);
+      G4ThreeVector position = event.GetPrimaryVertex()->GetPosition();
+      double v[2] = { position.x()/mm, position.z()/mm };
+      for (int k = 0; k < 2; k++) {
+        sum[k]  += v[k];
+        sum2[k] += v[k]*v[k];
+      }
+    }
+    SpotMoments moments;
+    moments.n = n;
+    for (int k = 0; k < 2; k++) {
+      moments.mean[k] = sum[k]/n;
+      moments.variance[k] = sum2[k]/n - moments.mean[k]*moments.mean[k];
+    }
+    return moments;
+  }
+
+  // Differences of the spot moments in standard errors; the variance
+  // error assumes near-gaussian tails, so the bound is generous
+  bool CompareSpot(const char* name, const SpotMoments& reference,
+                   const SpotMoments& spot)
+  {
+    double worst = 0.;
+    for (int k = 0; k < 2; k++) {
+      double meanError = std::sqrt(reference.variance[k]/reference.n
+                                   + spot.variance[k]/spot.n);
+      double varianceError = std::sqrt(
+        2.*reference.variance[k]*reference.variance[k]/reference.n
+        + 2.*spot.variance[k]*spot.variance[k]/spot.n);
+      worst = std::max(worst, std::fabs(spot.mean[k] - reference.mean[k])
+                              /meanError);
+      worst = std::max(worst, std::fabs(spot.variance[k]
+                                        - reference.variance[k])
+                              /varianceError);
+    }
+    bool passed = worst < 5.;
+
+    char line[256];
+    std::snprintf(line, sizeof(line), "{\"check\": \"%s\", \"var_x_mm2\":"
+                  " %.4f, \"var_z_mm2\": %.4f, \"gps_var_x_mm2\": %.4f,"
+                  " \"gps_var_z_mm2\": %.4f, \"worst_sigma\": %.2f,"
+                  " \"passed\": %s}", name, spot.variance[0], spot.variance[1],
+                  reference.variance[0], reference.variance[1], worst,
+                  passed ? "true" : "false");
+    std::cout << line << std::endl;
+    if (gOutput.is_open()) gOutput << line << std::endl;
+    return passed;
+  }
+
+  // The actions find the geometry and the current run through the run
+  // manager; the bench hands them a run without an event loop or physics
+  class BenchRunManager : public G4RunManager
+  {
+    public:
+      void SetCurrentRun(G4Run* run) { currentRun = run; }
+  };
+
+  // Output directory of the action and output benchmarks
+  std::string MakeTempDirectory()
+  {
+    const char* tmp = std::getenv("TMPDIR");
+    std::string pattern = std::string(tmp ? tmp : "/tmp") + "/bench.XXXXXX";
+    std::vector<char> name(pattern.begin(), pattern.end());
+    name.push_back('\0');
+    return mkdtemp(&name[0]) ? std::string(&name[0]) : std::string();
+  }
+
+  void RemoveDirectory(const std::string& directory)
+  {
+    if (DIR* dir = opendir(directory.c_str())) {
+      while (dirent* entry = readdir(dir)) {
+        std::string name = entry->d_name;
+        if (name != "." && name != "..") {
+          std::remove((directory + "/" + name).c_str());
+        }
+      }
+      closedir(dir);
+    }
+    rmdir(directory.c_str());
+  }
+
+  // Step of a primary electron from one located point to another, the
+  // post-step point in the volume the track enters
+  G4Step* MakeStep(const G4TouchableHandle& volume,
+                   const G4TouchableHandle& nextVolume,
+                   const G4ThreeVector& from, const G4ThreeVector& to,
+                   G4double edep)
+  {
+    G4ThreeVector direction(0., 1., 0.);
+    G4Track* track = new G4Track(
+      new G4DynamicParticle(G4Electron::Definition(), direction, 100.*keV),
+      0., from);
+    track->SetParentID(0);
+    track->SetTouchableHandle(volume);
+    track->SetNextTouchableHandle(nextVolume);
+
+    G4Step* step = new G4Step();
+    step->SetTrack(track);
+    track->SetStep(step);
+    step->GetPreStepPoint()->SetPosition(from);
+    step->GetPreStepPoint()->SetTouchableHandle(volume);
+    step->GetPostStepPoint()->SetPosition(to);
+    step->GetPostStepPoint()->SetTouchableHandle(nextVolume);
+    step->GetPostStepPoint()->SetMomentumDirection(direction);
+    step->GetPostStepPoint()->SetKineticEnergy(100.*keV);
+    step->SetTotalEnergyDeposit(edep);
+    return step;
+  }
+
+  // Points in and around a solid of the given half size, half of them
+  // close to the y axis where the pinhole is, with isotropic directions
+  struct Sample
+  {
+    G4ThreeVector point;
+    G4ThreeVector direction;
+  };
+
+  void MakeSamples(const G4ThreeVector& halfSize, G4double core,
+                   std::vector<Sample>& inside, std::vector<Sample>& outside,
+                   const G4VSolid* solid)
+  {
+    while (inside.size() < 4096 || outside.size() < 4096) {
+      G4bool nearAxis = G4UniformRand() < 0.5;
+      G4double hx = nearAxis ? core : 1.2*halfSize.x();
+      G4double hz = nearAxis ? core : 1.2*halfSize.z();
+      Sample sample;
+      sample.point.set((2.*G4UniformRand() - 1.)*hx,
+                       (2.*G4UniformRand() - 1.)*1.2*halfSize.y(),
+                       (2.*G4UniformRand() - 1.)*hz);
+      G4double cosTheta = 2.*G4UniformRand() - 1.;
+      G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+      G4double phi = twopi*G4UniformRand();
+      sample.direction.set(sinTheta*std::cos(phi), cosTheta,
+                           sinTheta*std::sin(phi));
+
+      EInside where = solid->Inside(sample.point);
+      if (where == kInside && inside.size() < 4096) inside.push_back(sample);
+      if (where == kOutside && outside.size() < 4096) outside.push_back(sample);
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc) {
+      Usage();
+      return 1;
+    }
+    if      (!std::strcmp(argv[i], "-t")) gMinSeconds = std::atof(argv[i+1]);
+    else if (!std::strcmp(argv[i], "-f")) gFilter     = argv[i+1];
+    else if (!std::strcmp(argv[i], "-o")) {
+      gOutput.open(argv[i+1], std::ios_base::app);
+    }
+    else {
+      Usage();
+      return 1;
+    }
+  }
+
+  G4Random::setTheEngine(new CLHEP::RanecuEngine);
+  G4UImanager* UImanager = G4UImanager::GetUIpointer();
+  G4Electron::Definition();
+  G4Geantino::Definition();
+
+  // Checks run along with the benchmarks fail the exit status
+  G4bool spotPassed = true;
+
+  // Geometry of ../src/pinhole_config.txt, owned by the run manager
+  BenchRunManager* runManager = new BenchRunManager();
+  DetectorConstruction* detector = new DetectorConstruction();
+  runManager->SetUserInitialization(detector);
+  G4VPhysicalVolume* world = detector->Construct();
+
+  std::string outputDirectory = MakeTempDirectory();
+  if (outputDirectory.empty()) {
+    std::cerr << "bench: cannot create a temporary directory" << std::endl;
+    return 1;
+  }
+  OutputManager::Instance()->SetRootDirectory(outputDirectory);
+
+  // ----------------------------------------------------------------
+  // Worker actions of a run writing to the temporary directory: the
+  // stepping action on steps before, into and inside detector1, and the
+  // end of an accepted event with one detector1 hit (trigger, init_pos.csv
+  // and hits.csv rows, flush)
+  // ----------------------------------------------------------------
+  {
+    RunAction* runAction = new RunAction();
+    EventAction* eventAction = new EventAction(runAction);
+    SteppingAction* steppingAction = new SteppingAction(eventAction);
+
+    G4Run* run = runAction->GenerateRun();
+    runManager->SetCurrentRun(run);
+    runAction->BeginOfRunAction(run);
+
+    G4Event event(0);
+    G4PrimaryVertex* vertex
+      = new G4PrimaryVertex(G4ThreeVector(0., -9.5*cm, 0.), 0.);
+    G4PrimaryParticle* primary = new G4PrimaryParticle();
+    primary->SetMomentumDirection(G4ThreeVector(0., 1., 0.));
+    primary->SetKineticEnergy(100.*keV);
+    vertex->SetPrimary(primary);
+    event.AddPrimaryVertex(vertex);
+
+    // Touchables in front of and inside detector1, as the navigator
+    // leaves them for the tracking
+    G4double layerY = detector->GetLayerPosition(0);
+    G4double face = layerY - 0.5*detector->GetLayerThickness(0);
+    G4ThreeVector start(0., face - 2.*mm, 0.);
+    G4ThreeVector before(0., face - 1.*mm, 0.);
+    G4ThreeVector entry(0., face, 0.);
+    G4ThreeVector inside(0., layerY, 0.);
+    G4Navigator navigator;
+    navigator.SetWorldVolume(world);
+    navigator.LocateGlobalPointAndSetup(before, 0, false);
+    G4TouchableHandle outsideTouchable = navigator.CreateTouchableHistory();
+    navigator.LocateGlobalPointAndSetup(inside, 0, false);
+    G4TouchableHandle layerTouchable = navigator.CreateTouchableHistory();
+
+    // One step in ten enters detector1 and one deposits inside it
+    G4Step* steps[3] = {
+      MakeStep(outsideTouchable, outsideTouchable, start, before, 0.),
+      MakeStep(outsideTouchable, layerTouchable, before, entry, 0.),
+      MakeStep(layerTouchable, layerTouchable, entry, inside, 1.*keV) };
+
+    eventAction->BeginOfEventAction(&event);
+    Measure("stepping_action", [&](long i) {
+      // Keeps the event's hit buffer at a realistic size
+      if ((i & 1023) == 0) eventAction->BeginOfEventAction(&event);
+      long k = i % 10;
+      steppingAction->UserSteppingAction(steps[k < 2 ? k + 1 : 0]);
+    });
+
+    Measure("event_action_write", [&](long i) {
+      eventAction->BeginOfEventAction(&event);
+      G4ThreeVector position(0.001*(i & 1023)*cm, face, -0.002*(i & 511)*cm);
+      eventAction->AddHit(0, position, G4ThreeVector(0., 1., 0.), 98.7654*keV,
+                          true);
+      eventAction->EndOfEventAction(&event);
+    });
+
+    runAction->EndOfRunAction(run);
+    runManager->SetCurrentRun(0);
+    delete run;
+
+    for (size_t i = 0; i < 3; i++) {
+      delete steps[i]->GetTrack();
+      delete steps[i];
+    }
+    delete steppingAction;
+    delete eventAction;
+    delete runAction;
+  }
+
+  // ----------------------------------------------------------------
+  // Pinhole window solid
+  // ----------------------------------------------------------------
+  {
+    G4LogicalVolume* window
+      = G4LogicalVolumeStore::GetInstance()->GetVolume("window");
+    const G4VSolid* solid = window->GetSolid();
+
+    // The window is the window box intersected with the knife-edge cone,
+    // which opens to ten pinhole radii; the core spans the pinhole itself
+    G4double radius = detector->GetPinholeRadius();
+    G4ThreeVector halfSize(10.*radius, detector->GetWindowThickness(),
+                           10.*radius);
+    std::vector<Sample> inside, outside;
+    MakeSamples(halfSize, 2.*radius, inside, outside, solid);
+
+    Measure("window_inside", [&](long i) {
+      const Sample& sample = (i & 1) ? inside[(i >> 1) & 4095]
+                                     : outside[(i >> 1) & 4095];
+      gSink = gSink + solid->Inside(sample.point);
+    });
+    Measure("window_distance_to_in", [&](long i) {
+      const Sample& sample = outside[i & 4095];
+      gSink = gSink + solid->DistanceToIn(sample.point, sample.direction);
+    });
+    Measure("window_distance_to_out", [&](long i) {
+      const Sample& sample = inside[i & 4095];
+      gSink = gSink + solid->DistanceToOut(sample.point, sample.direction);
+    });
+  }
+
+  // ----------------------------------------------------------------
+  // Primary sampling: GPS as in run_over_angles, then the shared source
+  // ----------------------------------------------------------------
+  {
+    const char* commands[] = { "/gps/particle e-", "/gps/pos/type Beam",
+      "/gps/pos/shape Circle", "/gps/pos/radius 1.5 mm",
+      "/gps/pos/sigma_r 0.75 mm", "/gps/pos/rot1 1 0 0",
+      "/gps/pos/rot2 0 0 1", "/gps/energy 100 keV",
+      "/gps/pos/centre 0. -9.5 0. cm", "/gps/direction 0 1 0" };
+
+    PrimaryGeneratorAction* gps = new PrimaryGeneratorAction();
+    for (size_t i = 0; i < sizeof(commands)/sizeof(commands[0]); i++) {
+      UImanager->ApplyCommand(commands[i]);
+    }
+    Measure("primary_gps", [&](long i) {
+      G4Event* event = new G4Event(G4int(i));
+      gps->GeneratePrimaries(event);
+      delete event;
+    });
+
+    // The shared source and its blocks must reproduce the GPS beam spot
+    const long spotEvents = 200000;
+    G4bool checkSpot = Selected("primary_spot_shared")
+                    || Selected("primary_spot_block");
+    SpotMoments gpsSpot = { { 0., 0. }, { 0., 0. }, 0 };
+    if (checkSpot) gpsSpot = MeasureSpot(gps, spotEvents);
+    delete gps;
+
+    SourceDefinition* source = SourceDefinition::Instance();
+    source->SetEnabled(true);
+    source->SetParticle("e-");
+    source->SetRadius(1.5*mm);
+    source->SetSigmaR(0.75*mm);
+    source->SetCentre(G4ThreeVector(0., -9.5*cm, 0.));
+    source->SetDirection(G4ThreeVector(0., 1., 0.));
+    source->SetMonoEnergy(100.*keV);
+
+    PrimaryGeneratorAction* shared = new PrimaryGeneratorAction();
+    Measure("primary_shared_source", [&](long i) {
+      G4Event* event = new G4Event(G4int(i));
+      shared->GeneratePrimaries(event);
+      delete event;
+    });
+    if (Selected("primary_spot_shared")) {
+      spotPassed = CompareSpot("primary_spot_shared", gpsSpot,
+                               MeasureSpot(shared, spotEvents)) && spotPassed;
+    }
+
+    source->SetBlockSize(4096);
+    Measure("primary_shared_source_block", [&](long i) {
+      G4Event* event = new G4Event(G4int(i));
+      shared->GeneratePrimaries(event);
+      delete event;
+    });
+    if (Selected("primary_spot_block")) {
+      spotPassed = CompareSpot("primary_spot_block", gpsSpot,
+                               MeasureSpot(shared, spotEvents)) && spotPassed;
+    }
+    delete shared;
+    delete source;
+  }
+
+  // ----------------------------------------------------------------
+  // Event streams: one row per event into the shared file, flushed at
+  // every event boundary, and into a per-thread file
+  // ----------------------------------------------------------------
+  {
+    const char* row = "\n0.0123,0.1,-0.0456,0.0987654";
+
+    OutputFile shared("bench_shared");
+    shared.Open(outputDirectory, false, 0, 0);
+    Measure("output_file_shared", [&](long) {
+      shared.Stream() << row;
+      shared.EndEvent();
+    });
+    shared.Close();
+
+    OutputFile perThread("bench_per_thread");
+    perThread.Open(outputDirectory, true, 0, 0);
+    Measure("output_file_per_thread", [&](long) {
+      perThread.Stream() << row;
+      perThread.EndEvent();
+    });
+    perThread.Close();
+  }
+  RemoveDirectory(outputDirectory);
+
+  // ----------------------------------------------------------------
+  // Navigation through the window: straight rays from in front of it to
+  // past detector1, one op per geometric step, for the single pinhole and
+  // MURA masks of growing aperture count (steps/s = 1e9/ns_per_op)
+  // ----------------------------------------------------------------
+  {
+    // Rank 0 is the single pinhole; pitch and radius let rank 101 fit
+    const G4int ranks[] = { 0, 5, 13, 29, 53, 101 };
+    detector->SetMaskPitch(1.2*mm);
+    detector->SetApertureRadius(0.4*mm);
+
+    std::vector<Sample> rays(4096);
+    G4double yStart = -detector->GetWindowGap()
+                    - detector->GetWindowThickness() - 1.*mm;
+    G4double yEnd = 1.*cm;
+    for (size_t i = 0; i < rays.size(); i++) {
+      G4double cosTheta = 1. - 0.05*G4UniformRand();
+      G4double sinTheta = std::sqrt(1. - cosTheta*cosTheta);
+      G4double phi = twopi*G4UniformRand();
+      rays[i].point.set((2.*G4UniformRand() - 1.)*6.*cm, yStart,
+                        (2.*G4UniformRand() - 1.)*6.*cm);
+      rays[i].direction.set(sinTheta*std::cos(phi), cosTheta,
+                            sinTheta*std::sin(phi));
+    }
+
+    for (size_t k = 0; k < sizeof(ranks)/sizeof(ranks[0]); k++) {
+      if (ranks[k] > 0) {
+        detector->SetMaskType(DetectorConstruction::kMURA);
+        detector->SetMaskRank(ranks[k]);
+      }
+      else {
+        detector->SetMaskType(DetectorConstruction::kPinhole);
+      }
+
+      // The aperture count is only known once built, so build first
+      G4GeometryManager::GetInstance()->OpenGeometry();
+      G4PhysicalVolumeStore::Clean();
+      G4LogicalVolumeStore::Clean();
+      G4SolidStore::Clean();
+      world = detector->Construct();
+
+      std::ostringstream name;
+      name << "navigation_apertures_" << detector->GetNumberOfApertures();
+      if (!Selected(name.str())) continue;
+
+      // Voxelised as for a run
+      G4GeometryManager::GetInstance()->CloseGeometry(true);
+
+      G4Navigator navigator;
+      navigator.SetWorldVolume(world);
+      size_t ray = 0;
+      G4ThreeVector point, direction;
+      auto startRay = [&]() {
+        point = rays[ray & 4095].point;
+        direction = rays[ray & 4095].direction;
+        ray++;
+        navigator.LocateGlobalPointAndSetup(point, &direction, false, false);
+      };
+      startRay();
+
+      Measure(name.str().c_str(), [&](long) {
+        G4double safety = 0.;
+        G4double step = navigator.ComputeStep(point, direction, kInfinity,
+                                              safety);
+        if (step == kInfinity) {
+          startRay();
+          return;
+        }
+        point += step*direction;
+        navigator.SetGeometricallyLimitedStep();
+        G4VPhysicalVolume* volume
+          = navigator.LocateGlobalPointAndSetup(point, &direction, true);
+        if (!volume || point.y() > yEnd) startRay();
+      });
+    }
+    G4GeometryManager::GetInstance()->OpenGeometry();
+  }
+
+  delete runManager;
+  return spotPassed ? 0 : 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
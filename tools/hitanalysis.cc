@@ -0,0 +1,296 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file hitanalysis.cc
+/// \brief Streaming angle analysis of hits.csv / init_pos.csv
+
+// Usage:
+//   hitanalysis [options]
+//
+//   -i <file>   hit file               (default ../analysis/data/hits.csv)
+//   -p <file>   primaries file         (default ../analysis/data/init_pos.csv)
+//   -o <file>   results file, appended (default ../analysis/data/results.txt)
+//   -c <file>   detector config        (default ../src/pinhole_config.txt)
+//   -g <gap>    angle gap in cm, overrides the one derived from -c
+//   -m <mode>   single: x,y,z,energy[,E0,w] hits on detector1
+//               pair:   det,x,y,z,energy, detector1 -> detector2 pairs
+//               (default: pair if the first line has 5 fields)
+//   -H <file>   write theta/phi histograms (density, as plt.hist)
+//   -n <bins>   histogram bins (default 100)
+//
+// Computes what fnc_calc_angle_per_particle.py (single) and
+// calc_angle_per_particle (pair) compute, in one pass and bounded memory,
+// and appends one results.txt row in the run_over_angles schema.
+
+#include "CsvReader.hh"
+#include "AngleEstimator.hh"
+#include "RunningStats.hh"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+  void Usage()
+  {
+    std::cerr << "usage: hitanalysis [-i hits.csv] [-p init_pos.csv]"
+              << " [-o results.txt] [-c pinhole_config.txt] [-g gap_cm]"
+              << " [-m single|pair] [-H histograms.csv] [-n bins]"
+              << std::endl;
+  }
+
+  // Same gap as run_over_angles passes to calculateAnglePerParticle, in cm
+  bool ReadConfigGap(const std::string& fileName, double& gap)
+  {
+    std::ifstream configFile(fileName.c_str());
+    double pinholeRadius, windowGap, windowThickness, foilThickness;
+    if (!(configFile >> pinholeRadius >> windowGap >> windowThickness
+                     >> foilThickness)) return false;
+    gap = windowGap*0.1 - windowThickness*1.e-4/2 - 0.05;
+    return true;
+  }
+
+  struct DetectorStats
+  {
+    RunningStats x;
+    RunningStats z;
+    RunningStats energy;
+  };
+
+  void WriteHistogram(std::ostream& out, const char* name,
+                      const QuantileSketch& sketch, const RunningStats& stats,
+                      int nBins)
+  {
+    double low = stats.GetMin();
+    double width = (stats.GetMax() - low)/nBins;
+    if (width <= 0.) width = 1.;
+    double total = sketch.GetEntries();
+
+    double previous = sketch.Cumulative(low);
+    for (int i = 0; i < nBins; i++) {
+      double high = low + (i + 1)*width;
+      double current = (i == nBins - 1) ? total : sketch.Cumulative(high);
+      out << name << "," << low + i*width << "," << high << ","
+          << (current - previous)/(total*width) << "\n";
+      previous = current;
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  std::string hitsName      = "../analysis/data/hits.csv";
+  std::string primariesName = "../analysis/data/init_pos.csv";
+  std::string resultsName   = "../analysis/data/results.txt";
+  std::string configName    = "../src/pinhole_config.txt";
+  std::string histogramName;
+  std::string mode;
+  double gap = 0.;
+  int nBins = 100;
+
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc) {
+      Usage();
+      return 1;
+    }
+    if      (!std::strcmp(argv[i], "-i")) hitsName      = argv[i+1];
+    else if (!std::strcmp(argv[i], "-p")) primariesName = argv[i+1];
+    else if (!std::strcmp(argv[i], "-o")) resultsName   = argv[i+1];
+    else if (!std::strcmp(argv[i], "-c")) configName    = argv[i+1];
+    else if (!std::strcmp(argv[i], "-g")) gap           = std::atof(argv[i+1]);
+    else if (!std::strcmp(argv[i], "-m")) mode          = argv[i+1];
+    else if (!std::strcmp(argv[i], "-H")) histogramName = argv[i+1];
+    else if (!std::strcmp(argv[i], "-n")) nBins         = std::atoi(argv[i+1]);
+    else {
+      Usage();
+      return 1;
+    }
+  }
+  if (!mode.empty() && mode != "single" && mode != "pair") {
+    Usage();
+    return 1;
+  }
+  if (nBins < 1) nBins = 1;
+
+  // ----------------------------------------------------------------
+  // Source angles and number of particles, as fnc_findSourceAngle.py
+  // ----------------------------------------------------------------
+  CsvReader primaries(primariesName);
+  if (!primaries.IsOpen()) {
+    std::cerr << "hitanalysis: cannot open " << primariesName << std::endl;
+    return 1;
+  }
+
+  const double toDeg = 180./3.14159265358979323846;
+  double thetaActual = 0., phiActual = 0.;
+  long nParticles = 0;
+  double values[8];
+  int nFields;
+  while ((nFields = primaries.ReadLine(values, 8)) >= 0) {
+    if (nFields < 6) continue;
+    if (nParticles == 0) {
+      thetaActual = std::atan2(values[5], values[4])*toDeg;
+      phiActual   = std::atan2(values[3], values[4])*toDeg;
+    }
+    nParticles++;
+  }
+
+  // ----------------------------------------------------------------
+  // Hits
+  // ----------------------------------------------------------------
+  CsvReader hits(hitsName);
+  if (!hits.IsOpen()) {
+    std::cerr << "hitanalysis: cannot open " << hitsName << std::endl;
+    return 1;
+  }
+
+  std::map<int, DetectorStats> detectors;
+  AngleEstimator* estimator = 0;
+
+  // Previous line of a possible detector1 -> detector2 pair
+  bool   havePrevious = false;
+  int    previousDet = 0;
+  double previousX = 0., previousZ = 0.;
+
+  while ((nFields = hits.ReadLine(values, 8)) >= 0) {
+    if (mode.empty()) mode = (nFields == 5) ? "pair" : "single";
+    if (!estimator) {
+      if (gap <= 0.) {
+        if (mode == "pair") {
+          gap = 0.52;
+        }
+        else if (!ReadConfigGap(configName, gap)) {
+          std::cerr << "hitanalysis: cannot read " << configName
+                    << ", give the gap with -g" << std::endl;
+          return 1;
+        }
+      }
+      // Finer sketch than the per-thread one, the tool holds only one
+      estimator = new AngleEstimator(gap, 0.001);
+    }
+
+    if (mode == "single") {
+      if (nFields < 4) continue;
+      DetectorStats& det = detectors[1];
+      det.x.Add(values[0]);
+      det.z.Add(values[2]);
+      det.energy.Add(values[3]);
+      estimator->AddHit(values[0], values[2]);
+    }
+    else {
+      if (nFields < 5) continue;
+      int detID = int(values[0]);
+      DetectorStats& det = detectors[detID];
+      det.x.Add(values[1]);
+      det.z.Add(values[3]);
+      det.energy.Add(values[4]);
+
+      // Same pairing rule as calc_angle_per_particle
+      if (havePrevious && previousDet == 1 && detID == 2) {
+        estimator->AddHit(values[1] - previousX, values[3] - previousZ);
+        havePrevious = false;
+      }
+      else {
+        havePrevious = true;
+        previousDet  = detID;
+        previousX    = values[1];
+        previousZ    = values[3];
+      }
+    }
+  }
+
+  if (!estimator || estimator->GetEntries() == 0) {
+    std::cerr << "hitanalysis: no particle hits on detector in " << hitsName
+              << std::endl;
+    delete estimator;
+    return 1;
+  }
+
+  // ----------------------------------------------------------------
+  // Output
+  // ----------------------------------------------------------------
+  std::ifstream existing(resultsName.c_str());
+  bool needsHeader = !existing.is_open()
+                     || existing.peek() == std::ifstream::traits_type::eof();
+  existing.close();
+
+  std::ofstream resultsFile(resultsName.c_str(), std::ios_base::app);
+  if (!resultsFile.is_open()) {
+    std::cerr << "hitanalysis: cannot write " << resultsName << std::endl;
+    delete estimator;
+    return 1;
+  }
+  if (needsHeader) resultsFile << AngleEstimator::Header() << "\n";
+  resultsFile << estimator->FormatRow(nParticles, thetaActual, phiActual)
+              << "\n";
+
+  if (!histogramName.empty()) {
+    std::ofstream histogramFile(histogramName.c_str());
+    histogramFile << "angle,low,high,density\n";
+    WriteHistogram(histogramFile, "theta", estimator->GetThetaSketch(),
+                   estimator->GetTheta(), nBins);
+    WriteHistogram(histogramFile, "phi", estimator->GetPhiSketch(),
+                   estimator->GetPhi(), nBins);
+  }
+
+  std::cout << std::fixed << std::setprecision(4)
+            << "Number of particles: " << nParticles << "\n"
+            << "Hit lines: " << hits.GetLines()
+            << " (" << hits.GetBadLines() << " skipped), mode " << mode
+            << ", gap " << gap << " cm\n";
+  for (std::map<int, DetectorStats>::const_iterator it = detectors.begin();
+       it != detectors.end(); ++it) {
+    const DetectorStats& det = it->second;
+    std::cout << "Detector " << it->first << ": " << det.x.GetEntries()
+              << " hits, x = " << det.x.GetMean() << " +- "
+              << det.x.GetStdDev() << " cm, z = " << det.z.GetMean()
+              << " +- " << det.z.GetStdDev() << " cm, energy = "
+              << det.energy.GetMean() << " +- " << det.energy.GetStdDev()
+              << " MeV\n";
+  }
+  std::cout << "Actual [degrees]: theta=" << thetaActual
+            << ", phi=" << phiActual << "\n"
+            << "Experimental (mean) [degrees]: theta="
+            << estimator->GetTheta().GetMean()
+            << ", phi=" << estimator->GetPhi().GetMean() << "\n"
+            << "Experimental (median) [degrees]: theta="
+            << estimator->GetThetaMedian()
+            << ", phi=" << estimator->GetPhiMedian() << std::endl;
+
+  delete estimator;
+  return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
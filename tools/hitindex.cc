@@ -0,0 +1,176 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+/// \file hitindex.cc
+/// \brief Build and query the spatial index of a hit file
+
+// Usage:
+//   hitindex build [options]
+//     -i <file>   hit file                (default ../analysis/data/hits.csv)
+//     -o <file>   index file              (default ../analysis/data/hits.idx)
+//     -g <bits>   2^bits x 2^bits grid cells (default 8)
+//
+//   hitindex query [options]
+//     -f <file>           index file      (default ../analysis/data/hits.idx)
+//     -b <x0 x1 z0 z1>    box (cm)
+//     -r <x z r>          circle (cm)
+//     -e <e0 e1>          energy range (MeV)
+//     -l                  list the selected hits as x,y,z,energy[,E0,w]
+//
+// Without -b or -r the query covers the whole detector. The summary line
+// gives the number of selected hits, their mean position and energy, and
+// how many cells and hits the query had to touch.
+
+#include "HitIndex.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+  void Usage()
+  {
+    std::cerr << "usage: hitindex build [-i hits.csv] [-o hits.idx] [-g bits]\n"
+              << "       hitindex query [-f hits.idx] [-b x0 x1 z0 z1]"
+              << " [-r x z r] [-e e0 e1] [-l]" << std::endl;
+  }
+
+  // Number of values after each option
+  int Arguments(const char* option)
+  {
+    if (!std::strcmp(option, "-b")) return 4;
+    if (!std::strcmp(option, "-r")) return 3;
+    if (!std::strcmp(option, "-e")) return 2;
+    if (!std::strcmp(option, "-l")) return 0;
+    return 1;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  if (argc < 2 || (std::strcmp(argv[1], "build") && std::strcmp(argv[1], "query"))) {
+    Usage();
+    return 1;
+  }
+  bool build = !std::strcmp(argv[1], "build");
+
+  std::string csvName   = "../analysis/data/hits.csv";
+  std::string indexName = "../analysis/data/hits.idx";
+  int  bits = 8;
+  bool list = false;
+  HitIndex::Query query;
+
+  for (int i = 2; i < argc; i++) {
+    int n = Arguments(argv[i]);
+    if (i + n >= argc) {
+      Usage();
+      return 1;
+    }
+    const char* option = argv[i];
+    char** value = argv + i + 1;
+    i += n;
+
+    if      (build && !std::strcmp(option, "-i")) csvName   = value[0];
+    else if (build && !std::strcmp(option, "-o")) indexName = value[0];
+    else if (build && !std::strcmp(option, "-g")) bits = std::atoi(value[0]);
+    else if (!build && !std::strcmp(option, "-f")) indexName = value[0];
+    else if (!build && !std::strcmp(option, "-b")) {
+      query.SetBox(std::atof(value[0]), std::atof(value[1]),
+                   std::atof(value[2]), std::atof(value[3]));
+    }
+    else if (!build && !std::strcmp(option, "-r")) {
+      query.SetCircle(std::atof(value[0]), std::atof(value[1]),
+                      std::atof(value[2]));
+    }
+    else if (!build && !std::strcmp(option, "-e")) {
+      query.SetEnergy(std::atof(value[0]), std::atof(value[1]));
+    }
+    else if (!build && !std::strcmp(option, "-l")) list = true;
+    else {
+      Usage();
+      return 1;
+    }
+  }
+
+  std::string error;
+  if (build) {
+    if (!HitIndex::Build(csvName, indexName, bits, error)) {
+      std::cerr << "hitindex: " << error << std::endl;
+      return 2;
+    }
+    HitIndex index;
+    index.Open(indexName, error);
+    double xMin, xMax, zMin, zMax;
+    index.GetExtent(xMin, xMax, zMin, zMax);
+    std::cout << indexName << ": " << index.GetNumberOfHits() << " hits in "
+              << index.GetCellsPerSide() << "x" << index.GetCellsPerSide()
+              << " cells over x " << xMin << " .. " << xMax << ", z " << zMin
+              << " .. " << zMax << " cm" << std::endl;
+    return 0;
+  }
+
+  HitIndex index;
+  if (!index.Open(indexName, error)) {
+    std::cerr << "hitindex: " << error << std::endl;
+    return 2;
+  }
+
+  std::vector<HitIndex::Hit> hits;
+  HitIndex::Result result = index.Select(query, &hits);
+
+  double sumX = 0., sumZ = 0., sumE = 0.;
+  for (size_t i = 0; i < hits.size(); i++) {
+    sumX += hits[i].x;
+    sumZ += hits[i].z;
+    sumE += hits[i].energy;
+    if (list) {
+      std::cout << hits[i].x << "," << hits[i].y << "," << hits[i].z << ","
+                << hits[i].energy;
+      if (hits[i].primaryEnergy > 0.) {
+        std::cout << "," << hits[i].primaryEnergy << "," << hits[i].weight;
+      }
+      std::cout << "\n";
+    }
+  }
+
+  std::ostream& summary = list ? std::cerr : std::cout;
+  summary << result.hits << " hits selected";
+  if (result.hits > 0) {
+    summary << ", mean x " << sumX/result.hits << " z " << sumZ/result.hits
+            << " cm, mean energy " << sumE/result.hits << " MeV";
+  }
+  summary << " (" << result.cellsVisited << " cells visited, "
+          << result.hitsScanned << " of " << index.GetNumberOfHits()
+          << " hits scanned)" << std::endl;
+  return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
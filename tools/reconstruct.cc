@@ -0,0 +1,283 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file reconstruct.cc
+/// \brief Maximum-likelihood source angles of detector1 images
+
+// Usage:
+//   reconstruct <library> [options] <image.npy> [<image.npy> ...]
+//
+//   -e <energy>   template energy in keV      (default first library node)
+//   -t <tol>      angle tolerance in degrees  (default 0.01)
+//   -j <threads>  worker threads              (default: hardware threads)
+//   -c <file>     also reconstruct a hit file (x,y,z,... in cm), binned on
+//                 the library pixel grid
+//   -o <file>     output CSV                  (default: standard output)
+//
+// Images are .npy float64 arrays of shape (nz, nx), as written by
+// surrogate, or (2, nz, nx), as written by the detector1 readout (the
+// counts plane is used). One CSV line is written per image, in input order.
+
+#include "ResponseLibrary.hh"
+#include "AngleReconstructor.hh"
+#include "CsvReader.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+  struct Task
+  {
+    std::string name;
+    std::vector<double> image;
+    bool   valid;
+    AngleReconstructor::Result result;
+    double microseconds;
+  };
+
+  void Usage()
+  {
+    std::cerr << "usage: reconstruct <library> [-e keV] [-t tol] [-j threads]"
+              << " [-c hits.csv] [-o results.csv] <image.npy> ..."
+              << std::endl;
+  }
+
+  // Reads the first nz*nx values of a little-endian float64 .npy array
+  // whose last two dimensions are (nz, nx)
+  bool ReadNpy(const std::string& fileName, int nx, int nz,
+               std::vector<double>& image)
+  {
+    std::ifstream file(fileName.c_str(), std::ios::binary);
+    char magic[8];
+    if (!file.read(magic, 8) || std::memcmp(magic, "\x93NUMPY", 6) != 0) {
+      return false;
+    }
+
+    std::size_t headerLength = 0;
+    unsigned char lengthBytes[4] = { 0, 0, 0, 0 };
+    if (magic[6] == 1) {
+      file.read(reinterpret_cast<char*>(lengthBytes), 2);
+      headerLength = lengthBytes[0] | (lengthBytes[1] << 8);
+    }
+    else {
+      file.read(reinterpret_cast<char*>(lengthBytes), 4);
+      headerLength = lengthBytes[0] | (lengthBytes[1] << 8)
+                   | (lengthBytes[2] << 16) | (std::size_t(lengthBytes[3]) << 24);
+    }
+    std::string header(headerLength, ' ');
+    if (!file.read(&header[0], headerLength)) return false;
+
+    if (header.find("'<f8'") == std::string::npos
+        || header.find("'fortran_order': False") == std::string::npos) {
+      return false;
+    }
+
+    std::size_t open = header.find("'shape': (");
+    std::size_t close = header.find(')', open);
+    if (open == std::string::npos || close == std::string::npos) return false;
+    std::string shapeText = header.substr(open + 10, close - open - 10);
+    for (std::size_t i = 0; i < shapeText.size(); i++) {
+      if (shapeText[i] == ',') shapeText[i] = ' ';
+    }
+    std::vector<long> shape;
+    std::istringstream is(shapeText);
+    long dimension;
+    while (is >> dimension) shape.push_back(dimension);
+    if (shape.size() < 2 || shape[shape.size()-1] != nx
+        || shape[shape.size()-2] != nz) {
+      return false;
+    }
+
+    image.resize(std::size_t(nx)*nz);
+    return bool(file.read(reinterpret_cast<char*>(&image[0]),
+                          image.size()*sizeof(double)));
+  }
+
+  // Bins hit positions (cm) on the library grid
+  bool BinHits(const std::string& fileName, const ResponseLibrary& library,
+               std::vector<double>& image)
+  {
+    CsvReader reader(fileName);
+    if (!reader.IsOpen()) return false;
+
+    int nx = library.GetNx(), nz = library.GetNz();
+    image.assign(std::size_t(nx)*nz, 0.);
+    double invPitch = 1./library.GetPitch();
+
+    double values[8];
+    int nFields;
+    while ((nFields = reader.ReadLine(values, 8)) >= 0) {
+      if (nFields < 4) continue;
+      double u = (values[0] - library.GetXmin())*invPitch;
+      double v = (values[2] - library.GetZmin())*invPitch;
+      if (u < 0. || v < 0. || u >= nx || v >= nz) continue;
+      image[std::size_t(v)*nx + std::size_t(u)] += 1.;
+    }
+    return true;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  if (argc < 3) {
+    Usage();
+    return 1;
+  }
+
+  std::string libraryName = argv[1];
+  std::string outputName;
+  std::string hitsName;
+  std::vector<std::string> imageNames;
+  double energy = -1.;
+  double tolerance = 0.01;
+  int nThreads = int(std::thread::hardware_concurrency());
+
+  for (int i = 2; i < argc; i++) {
+    std::string option = argv[i];
+    bool hasValue = i + 1 < argc;
+    if      (option == "-e" && hasValue) energy    = std::atof(argv[++i]);
+    else if (option == "-t" && hasValue) tolerance = std::atof(argv[++i]);
+    else if (option == "-j" && hasValue) nThreads  = std::atoi(argv[++i]);
+    else if (option == "-c" && hasValue) hitsName  = argv[++i];
+    else if (option == "-o" && hasValue) outputName = argv[++i];
+    else if (option[0] == '-') {
+      Usage();
+      return 1;
+    }
+    else imageNames.push_back(option);
+  }
+  if (nThreads < 1) nThreads = 1;
+
+  ResponseLibrary library;
+  if (!library.Open(libraryName)) {
+    std::cerr << "reconstruct: cannot open response library " << libraryName
+              << std::endl;
+    return 1;
+  }
+  if (energy <= 0.) energy = library.GetEnergies().front();
+
+  AngleReconstructor reconstructor(library, energy);
+  reconstructor.SetTolerance(tolerance);
+
+  // ----------------------------------------------------------------
+  // Inputs
+  // ----------------------------------------------------------------
+  std::vector<Task> tasks;
+  if (!hitsName.empty()) {
+    Task task;
+    task.name = hitsName;
+    task.valid = BinHits(hitsName, library, task.image);
+    tasks.push_back(task);
+  }
+  for (std::size_t i = 0; i < imageNames.size(); i++) {
+    Task task;
+    task.name = imageNames[i];
+    task.valid = ReadNpy(imageNames[i], library.GetNx(), library.GetNz(),
+                         task.image);
+    tasks.push_back(task);
+  }
+  if (tasks.empty()) {
+    Usage();
+    return 1;
+  }
+
+  // ----------------------------------------------------------------
+  // Fits, images handed out to the threads one at a time
+  // ----------------------------------------------------------------
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point start = Clock::now();
+
+  std::atomic<std::size_t> next(0);
+  std::vector<std::thread> workers;
+  if (nThreads > int(tasks.size())) nThreads = int(tasks.size());
+  for (int t = 0; t < nThreads; t++) {
+    workers.push_back(std::thread([&]() {
+      std::size_t i;
+      while ((i = next++) < tasks.size()) {
+        Task& task = tasks[i];
+        if (!task.valid) continue;
+        Clock::time_point begin = Clock::now();
+        task.result = reconstructor.Fit(&task.image[0]);
+        task.microseconds = std::chrono::duration<double, std::micro>(
+          Clock::now() - begin).count();
+      }
+    }));
+  }
+  for (std::size_t t = 0; t < workers.size(); t++) workers[t].join();
+
+  double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+
+  // ----------------------------------------------------------------
+  // Output
+  // ----------------------------------------------------------------
+  std::ofstream outputFile;
+  if (!outputName.empty()) {
+    outputFile.open(outputName.c_str());
+    if (!outputFile.is_open()) {
+      std::cerr << "reconstruct: cannot write " << outputName << std::endl;
+      return 1;
+    }
+  }
+  std::ostream& out = outputName.empty() ? std::cout : outputFile;
+
+  out << "Image,Counts,Theta,Theta_err,Phi,Phi_err,LogL,Evaluations,Time_us\n";
+  int nFailed = 0;
+  for (std::size_t i = 0; i < tasks.size(); i++) {
+    const Task& task = tasks[i];
+    if (!task.valid) {
+      std::cerr << "reconstruct: cannot read " << task.name
+                << " on the library grid" << std::endl;
+      nFailed++;
+      continue;
+    }
+    const AngleReconstructor::Result& r = task.result;
+    out << task.name << "," << r.counts << "," << r.theta << ","
+        << r.sigmaTheta << "," << r.phi << "," << r.sigmaPhi << ","
+        << r.logLikelihood << "," << r.evaluations << ","
+        << task.microseconds << "\n";
+  }
+
+  std::cerr << "reconstruct: " << tasks.size() - nFailed << " images in "
+            << elapsed << " s (" << (tasks.size() - nFailed)/elapsed
+            << " images/s, " << nThreads << " threads, E = " << energy
+            << " keV)" << std::endl;
+
+  return nFailed > 0 ? 1 : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,474 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file regress.cc
+/// \brief Statistical regression check of the simulation against golden distributions
+
+// Usage:
+//   regress record [options]   store the golden distributions
+//   regress check  [options]   compare a fresh run against them
+//                              (run from the build directory, like main)
+//
+//   -g <dir>     golden files                      (default ../tools/regression)
+//   -c <file>    geometry configuration            (default ../src/pinhole_config.txt)
+//   -w <names>   comma separated workloads         (default: all)
+//   -n <events>  events per workload (default 20000 when recording, the
+//                golden count when checking)
+//   -j <n>       threads                           (default 4)
+//   -a <alpha>   significance level of each test   (default 0.001)
+//   -y <frac>    yield tolerance, relative         (default 0.01)
+//   -l <label>   label stored with the results, e.g. the commit
+//   -o <file>    JSON report of a check            (default regression.json)
+//   -m <action>  missing golden file when checking: fail (default) or
+//                skip the workload
+//
+// Each workload is a fixed-seed run of the in-process simulation at one
+// energy/angle/geometry point: the GPS beams of scaling (100 keV and 1 MeV
+// through the pinhole, a 3 MeV point source with fine cuts) and a 300 keV
+// beam through a MURA mask. Recording writes <workload>.golden with the
+// detector1 x, z and entry energy histograms, the yield of detector1
+// entries per primary and the run time.
+//
+// A check runs the same workloads and compares each histogram with the
+// golden one by a two-sample chi-square and Kolmogorov-Smirnov test, and
+// the yield per primary by a Poisson rate test. A difference fails when
+// its p-value is below alpha; for the yield the relative difference must
+// also exceed the tolerance. The speedup is the golden over the current
+// time per event, so it only means something for the same host and -j.
+// Exit status: 0 all passed, 1 a significant difference, 2 an error,
+// including a missing golden file unless -m skip.
+//
+// Record the golden files from the reference commit and commit them with
+// the change that needs them; physics changes that are meant to change the
+// distributions re-record them.
+
+#include "PinholeSimulation.hh"
+#include "DistributionTest.hh"
+#include "ResultCache.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+  struct Workload
+  {
+    const char* name;
+    const char* commands;
+    double      maxEnergy;   // MeV, upper edge of the energy histogram
+    bool        mask;
+  };
+
+  const Workload kWorkloads[] = {
+    { "pinhole_100keV",
+      "/gps/particle e-\n/gps/pos/type Beam\n/gps/pos/shape Circle\n"
+      "/gps/pos/radius 1.65 mm\n/gps/pos/sigma_r 0.75 mm\n"
+      "/gps/pos/rot1 1 0 0\n/gps/pos/rot2 0 0 1\n/gps/energy 100 keV\n"
+      "/gps/pos/centre 0.0 -9.5 2.3112 cm\n/gps/direction 0 1 -0.36397\n",
+      0.1, false },
+    { "pinhole_1MeV",
+      "/gps/particle e-\n/gps/pos/type Beam\n/gps/pos/shape Circle\n"
+      "/gps/pos/radius 1.65 mm\n/gps/pos/sigma_r 0.75 mm\n"
+      "/gps/pos/rot1 1 0 0\n/gps/pos/rot2 0 0 1\n/gps/energy 1000 keV\n"
+      "/gps/pos/centre 0.0 -9.5 2.3112 cm\n/gps/direction 0 1 -0.36397\n",
+      1., false },
+    { "point_3MeV",
+      "/run/setCut 0.05 mm\n/gps/particle e-\n/gps/position 0 -5 -3 cm\n"
+      "/gps/pos/type Point\n/gps/direction 0 1 -0.1\n/gps/energy 3000 keV\n",
+      3., false },
+    { "mask_300keV",
+      "/pinhole/mask/type mura\n/pinhole/mask/rank 13\n"
+      "/pinhole/mask/pitch 2.5 mm\n/pinhole/mask/radius 0.5 mm\n"
+      "/gps/particle e-\n/gps/pos/type Beam\n/gps/pos/shape Circle\n"
+      "/gps/pos/radius 2 cm\n/gps/pos/sigma_r 0.75 mm\n"
+      "/gps/pos/rot1 1 0 0\n/gps/pos/rot2 0 0 1\n/gps/energy 300 keV\n"
+      "/gps/pos/centre 0.0 -9.5 0.0 cm\n/gps/direction 0 1 0\n",
+      0.3, true }
+  };
+  const int kNWorkloads = sizeof(kWorkloads)/sizeof(kWorkloads[0]);
+
+  // Same seeds for every workload and every run
+  const char* kSeedCommand = "/random/setSeeds 12345 67890";
+  // Production cut of the physics list, restored before every workload
+  const char* kCutCommand  = "/run/setCut 0.7 mm";
+
+  // Detector1 is 12.6 cm wide, 1 mm bins
+  const int    kPositionBins = 126;
+  const double kHalfWidth    = 6.3;    // cm
+  const int    kEnergyBins   = 100;
+
+  struct Result
+  {
+    int    events;
+    int    threads;
+    double seconds;
+    double hits;           // detector1 entries
+    std::string label;
+    std::string config;    // hash of the geometry configuration
+    std::vector<DistributionTest> histograms;
+  };
+
+  void Usage()
+  {
+    std::cerr << "usage: regress record|check [-g golden_dir] [-c config]"
+              << " [-w workloads] [-n events] [-j threads] [-a alpha]"
+              << " [-y yield_tolerance] [-l label] [-o regression.json]"
+              << " [-m fail|skip]"
+              << std::endl;
+  }
+
+  bool Selected(const std::string& selection, const char* name)
+  {
+    return selection.empty()
+        || ("," + selection + ",").find(std::string(",") + name + ",")
+           != std::string::npos;
+  }
+
+  std::string GoldenFileName(const std::string& dir, const Workload& workload)
+  {
+    return dir + "/" + workload.name + ".golden";
+  }
+
+  bool Execute(PinholeSimulation& simulation, const std::string& commands)
+  {
+    std::istringstream lines(commands);
+    std::string line;
+    while (std::getline(lines, line)) {
+      if (line.empty()) continue;
+      if (simulation.Execute(line) != 0) {
+        std::cerr << "regress: command failed: " << line << std::endl;
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Runs a workload and histograms the detector1 entries of its hits
+  bool Run(PinholeSimulation& simulation, const Workload& workload,
+           bool& masked, int events, int threads, Result& result)
+  {
+    std::string commands = std::string(kCutCommand) + "\n";
+    if (masked && !workload.mask) commands += "/pinhole/mask/type pinhole\n";
+    commands += workload.commands;
+    commands += std::string(kSeedCommand) + "\n";
+    if (!Execute(simulation, commands)) return false;
+    masked = workload.mask;
+
+    const PinholeSimulation::Summary& summary = simulation.BeamOn(events);
+    PinholeSimulation::HitBufferPtr hits = simulation.GetHits();
+
+    result.events  = summary.events;
+    result.threads = threads;
+    result.seconds = summary.seconds;
+    result.histograms.clear();
+    result.histograms.push_back(
+      DistributionTest("x", kPositionBins, -kHalfWidth, kHalfWidth));
+    result.histograms.push_back(
+      DistributionTest("z", kPositionBins, -kHalfWidth, kHalfWidth));
+    result.histograms.push_back(
+      DistributionTest("energy", kEnergyBins, 0., workload.maxEnergy));
+
+    result.hits = 0.;
+    for (size_t i = 0; i < hits->size(); i++) {
+      const HitRecord& hit = (*hits)[i];
+      if (hit.layer != 0) continue;
+      result.hits += 1.;
+      result.histograms[0].Fill(hit.x);
+      result.histograms[1].Fill(hit.z);
+      result.histograms[2].Fill(hit.energy);
+    }
+    return true;
+  }
+
+  bool WriteGolden(const std::string& fileName, const Workload& workload,
+                   const Result& result)
+  {
+    std::ofstream file(fileName.c_str());
+    file << "# Golden distributions of the " << workload.name
+         << " regression workload, written by regress record\n"
+         << "label "   << (result.label.empty() ? "-" : result.label) << "\n"
+         << "config "  << result.config << "\n"
+         << "events "  << result.events << "\n"
+         << "threads " << result.threads << "\n"
+         << "seconds " << std::setprecision(6) << result.seconds << "\n"
+         << "hits "    << std::setprecision(17) << result.hits << "\n";
+    for (size_t i = 0; i < result.histograms.size(); i++) {
+      result.histograms[i].Write(file);
+    }
+    return bool(file);
+  }
+
+  bool ReadGolden(const std::string& fileName, Result& result)
+  {
+    std::ifstream file(fileName.c_str());
+    if (!file) return false;
+
+    result.histograms.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+      std::istringstream fields(line);
+      std::string key;
+      if (!(fields >> key) || key[0] == '#') continue;
+      if      (key == "label")   fields >> result.label;
+      else if (key == "config")  fields >> result.config;
+      else if (key == "events")  fields >> result.events;
+      else if (key == "threads") fields >> result.threads;
+      else if (key == "seconds") fields >> result.seconds;
+      else if (key == "hits")    fields >> result.hits;
+      else if (key == "histogram") {
+        std::istringstream histogram(line);
+        DistributionTest test;
+        if (!test.Read(histogram)) return false;
+        result.histograms.push_back(test);
+      }
+    }
+    return result.events > 0 && result.histograms.size() == 3;
+  }
+
+  std::string JsonNumber(double value)
+  {
+    std::ostringstream text;
+    text << std::setprecision(6) << value;
+    return text.str();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  if (argc < 2) {
+    Usage();
+    return 2;
+  }
+  std::string mode = argv[1];
+  if (mode != "record" && mode != "check") {
+    Usage();
+    return 2;
+  }
+
+  std::string goldenDir  = "../tools/regression";
+  std::string configName = "../src/pinhole_config.txt";
+  std::string reportName = "regression.json";
+  std::string selection;
+  std::string label;
+  std::string missing = "fail";
+  int    events    = 0;
+  int    threads   = 4;
+  double alpha     = 0.001;
+  double tolerance = 0.01;
+
+  for (int i = 2; i < argc; i += 2) {
+    if (i + 1 >= argc) {
+      Usage();
+      return 2;
+    }
+    if      (!std::strcmp(argv[i], "-g")) goldenDir  = argv[i+1];
+    else if (!std::strcmp(argv[i], "-c")) configName = argv[i+1];
+    else if (!std::strcmp(argv[i], "-w")) selection  = argv[i+1];
+    else if (!std::strcmp(argv[i], "-n")) events     = std::atoi(argv[i+1]);
+    else if (!std::strcmp(argv[i], "-j")) threads    = std::atoi(argv[i+1]);
+    else if (!std::strcmp(argv[i], "-a")) alpha      = std::atof(argv[i+1]);
+    else if (!std::strcmp(argv[i], "-y")) tolerance  = std::atof(argv[i+1]);
+    else if (!std::strcmp(argv[i], "-l")) label      = argv[i+1];
+    else if (!std::strcmp(argv[i], "-o")) reportName = argv[i+1];
+    else if (!std::strcmp(argv[i], "-m")) missing    = argv[i+1];
+    else {
+      Usage();
+      return 2;
+    }
+  }
+  if (events < 0 || threads < 1 || !(alpha > 0.) || tolerance < 0.
+      || (missing != "fail" && missing != "skip")) {
+    Usage();
+    return 2;
+  }
+
+  std::string config = ResultCache::ToHex(ResultCache::HashFile(configName));
+
+  // Golden files first, so a missing one fails before any run
+  std::vector<Result> golden(kNWorkloads);
+  std::vector<bool>   skipped(kNWorkloads, false);
+  if (mode == "check") {
+    for (int w = 0; w < kNWorkloads; w++) {
+      if (!Selected(selection, kWorkloads[w].name)) continue;
+      std::string fileName = GoldenFileName(goldenDir, kWorkloads[w]);
+      if (ReadGolden(fileName, golden[w])) continue;
+      if (missing == "skip" && !std::ifstream(fileName.c_str())) {
+        std::cout << kWorkloads[w].name << ": no golden file " << fileName
+                  << ", skipped" << std::endl;
+        skipped[w] = true;
+        continue;
+      }
+      std::cerr << "regress: cannot read " << fileName
+                << ", record it with regress record" << std::endl;
+      return 2;
+    }
+  }
+
+  PinholeSimulation simulation(threads);
+  simulation.SetGeometryFile(configName);
+  simulation.SetKeepHits(true);
+  simulation.SetFileOutput(false);
+  simulation.Execute("/control/verbose 0");
+  simulation.Execute("/run/verbose 0");
+  simulation.Execute("/event/verbose 0");
+  simulation.Execute("/tracking/verbose 0");
+  simulation.Initialize();
+
+  std::ostringstream report;
+  report << std::setprecision(6)
+         << "{\n"
+         << "  \"label\": \"" << label << "\",\n"
+         << "  \"created\": " << std::chrono::duration_cast<std::chrono::seconds>(
+              std::chrono::system_clock::now().time_since_epoch()).count()
+         << ",\n"
+         << "  \"alpha\": " << alpha << ",\n"
+         << "  \"yieldTolerance\": " << tolerance << ",\n"
+         << "  \"workloads\": [\n";
+
+  bool masked = false;
+  bool failed = false;
+  bool first  = true;
+  for (int w = 0; w < kNWorkloads; w++) {
+    const Workload& workload = kWorkloads[w];
+    if (!Selected(selection, workload.name) || skipped[w]) continue;
+
+    int n = events > 0 ? events : (mode == "check" ? golden[w].events : 20000);
+    Result result;
+    result.label  = label;
+    result.config = config;
+    if (!Run(simulation, workload, masked, n, threads, result)) return 2;
+
+    if (mode == "record") {
+      std::string fileName = GoldenFileName(goldenDir, workload);
+      if (!WriteGolden(fileName, workload, result)) {
+        std::cerr << "regress: cannot write " << fileName << std::endl;
+        return 2;
+      }
+      std::cout << workload.name << ": " << result.events << " events, "
+                << long(result.hits) << " detector1 entries, "
+                << std::setprecision(3) << result.seconds << " s -> "
+                << fileName << std::endl;
+      continue;
+    }
+
+    // Check against the golden run
+    const Result& reference = golden[w];
+    if (reference.config != config) {
+      std::cout << workload.name << ": geometry configuration differs from"
+                << " the golden run, differences are expected" << std::endl;
+    }
+
+    report << (first ? "" : ",\n")
+           << "    {\"name\": \"" << workload.name << "\", \"tests\": [\n";
+    first = false;
+
+    for (size_t h = 0; h < result.histograms.size(); h++) {
+      const DistributionTest& current = result.histograms[h];
+      const DistributionTest& expected = reference.histograms[h];
+      double chi2 = 0., distance = 0.;
+      int ndf = 0;
+      double pChi2 = DistributionTest::ChiSquare(expected, current, chi2, ndf);
+      double pKS = DistributionTest::KolmogorovSmirnov(expected, current,
+                                                       distance);
+      bool ok = pChi2 >= alpha && pKS >= alpha;
+      failed = failed || !ok;
+
+      std::cout << std::left << std::setw(16) << workload.name
+                << std::setw(8) << current.GetName() << std::right
+                << std::setprecision(4) << "chi2 " << chi2 << "/" << ndf
+                << "  p " << pChi2 << "   KS " << distance << "  p " << pKS
+                << "   " << (ok ? "ok" : "DIFFERS") << std::endl;
+      report << "      {\"histogram\": \"" << current.GetName()
+             << "\", \"chi2\": " << JsonNumber(chi2)
+             << ", \"ndf\": " << ndf
+             << ", \"pChi2\": " << JsonNumber(pChi2)
+             << ", \"ksDistance\": " << JsonNumber(distance)
+             << ", \"pKS\": " << JsonNumber(pKS)
+             << ", \"passed\": " << (ok ? "true" : "false") << "},\n";
+    }
+
+    double yield = result.hits/result.events;
+    double expectedYield = reference.hits/reference.events;
+    double pYield = DistributionTest::RateDifference(
+      reference.hits, reference.events, result.hits, result.events);
+    double relative = expectedYield > 0. ? yield/expectedYield - 1. : 0.;
+    bool yieldOk = pYield >= alpha || std::abs(relative) <= tolerance;
+    failed = failed || !yieldOk;
+
+    double speedup = result.seconds > 0.
+                   ? (reference.seconds/reference.events)
+                     /(result.seconds/result.events) : 0.;
+
+    std::cout << std::left << std::setw(16) << workload.name
+              << std::setw(8) << "yield" << std::right << std::setprecision(5)
+              << yield << " per primary (golden " << expectedYield << ")  p "
+              << std::setprecision(4) << pYield << "   "
+              << (yieldOk ? "ok" : "DIFFERS") << std::endl;
+    std::cout << std::left << std::setw(16) << workload.name
+              << std::setw(8) << "speedup" << std::right
+              << std::setprecision(3) << speedup << "x";
+    if (reference.threads != threads) {
+      std::cout << "  (golden run used " << reference.threads << " threads)";
+    }
+    std::cout << std::endl;
+
+    report << "      {\"yield\": " << JsonNumber(yield)
+           << ", \"goldenYield\": " << JsonNumber(expectedYield)
+           << ", \"pYield\": " << JsonNumber(pYield)
+           << ", \"passed\": " << (yieldOk ? "true" : "false") << "}],\n"
+           << "      \"events\": " << result.events
+           << ", \"seconds\": " << JsonNumber(result.seconds)
+           << ", \"goldenSeconds\": " << JsonNumber(reference.seconds)
+           << ", \"goldenLabel\": \"" << reference.label << "\""
+           << ", \"speedup\": " << JsonNumber(speedup) << "}";
+  }
+
+  if (mode == "record") return 0;
+
+  report << "\n  ],\n  \"passed\": " << (failed ? "false" : "true") << "\n}\n";
+  std::ofstream out(reportName.c_str());
+  out << report.str();
+  if (!out) {
+    std::cerr << "regress: cannot write " << reportName << std::endl;
+    return 2;
+  }
+  std::cout << (failed ? "FAILED" : "PASSED") << ", report written to "
+            << reportName << std::endl;
+  return failed ? 1 : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,192 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file reweight.cc
+/// \brief Reweights a multi-energy hit file to a target spectrum
+
+// Usage:
+//   reweight <powerlaw|exponential> <emin> <emax> <param> [options]
+//
+//   -i <file>   tagged hit file          (default ../analysis/data/hits.csv)
+//   -s <file>   reference spectrum file  (default ../analysis/data/spectrum.txt)
+//   -p <file>   primaries file           (default ../analysis/data/init_pos.csv)
+//   -o <file>   reweighted hit output    (default ../analysis/data/hits_reweighted.csv)
+//
+// Energies are in MeV, as in the hit files. Each hit of a multi-energy run
+// (x,y,z,energy,E0,w) is given the weight w*f_target(E0)/f_reference(E0),
+// so one transport pass serves any target spectrum inside the reference
+// energy range.
+
+#include "EnergySpectrum.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+  void Usage()
+  {
+    std::cerr << "usage: reweight <powerlaw|exponential> <emin> <emax> <param>"
+              << " [-i hits.csv] [-s spectrum.txt] [-p init_pos.csv]"
+              << " [-o hits_reweighted.csv]" << std::endl;
+  }
+
+  long CountLines(const std::string& fileName)
+  {
+    std::ifstream in(fileName.c_str());
+    if (!in.is_open()) return -1;
+
+    long n = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+      if (!line.empty()) n++;
+    }
+    return n;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  if (argc < 5) {
+    Usage();
+    return 1;
+  }
+
+  std::string targetText = std::string(argv[1]) + " " + argv[2] + " "
+                         + argv[3] + " " + argv[4];
+  std::string hitsName      = "../analysis/data/hits.csv";
+  std::string spectrumName  = "../analysis/data/spectrum.txt";
+  std::string primariesName = "../analysis/data/init_pos.csv";
+  std::string outputName    = "../analysis/data/hits_reweighted.csv";
+
+  for (int i = 5; i + 1 < argc; i += 2) {
+    if      (!std::strcmp(argv[i], "-i")) hitsName      = argv[i+1];
+    else if (!std::strcmp(argv[i], "-s")) spectrumName  = argv[i+1];
+    else if (!std::strcmp(argv[i], "-p")) primariesName = argv[i+1];
+    else if (!std::strcmp(argv[i], "-o")) outputName    = argv[i+1];
+    else {
+      Usage();
+      return 1;
+    }
+  }
+
+  EnergySpectrum target;
+  if (!EnergySpectrum::FromString(targetText, target)) {
+    std::cerr << "reweight: invalid target spectrum '" << targetText << "'"
+              << std::endl;
+    return 1;
+  }
+
+  EnergySpectrum reference;
+  std::ifstream spectrumFile(spectrumName.c_str());
+  std::string referenceText;
+  std::getline(spectrumFile, referenceText);
+  if (!EnergySpectrum::FromString(referenceText, reference)) {
+    std::cerr << "reweight: cannot read reference spectrum from "
+              << spectrumName << std::endl;
+    return 1;
+  }
+
+  if (target.GetMin() < reference.GetMin()
+      || target.GetMax() > reference.GetMax()) {
+    std::cerr << "reweight: warning, target range exceeds the reference range "
+              << "and will be truncated to it" << std::endl;
+  }
+
+  std::ifstream hitsFile(hitsName.c_str());
+  if (!hitsFile.is_open()) {
+    std::cerr << "reweight: cannot open " << hitsName << std::endl;
+    return 1;
+  }
+  std::ofstream outputFile(outputName.c_str());
+
+  long   nHits = 0, nSkipped = 0;
+  double sumW = 0., sumW2 = 0.;
+  double sumX = 0., sumX2 = 0., sumZ = 0., sumZ2 = 0.;
+
+  std::string line;
+  while (std::getline(hitsFile, line)) {
+    if (line.empty()) continue;
+
+    double x, y, z, energy, e0, w;
+    if (std::sscanf(line.c_str(), "%lf,%lf,%lf,%lf,%lf,%lf",
+                    &x, &y, &z, &energy, &e0, &w) != 6) {
+      nSkipped++;
+      continue;
+    }
+
+    double fRef = reference.Density(e0);
+    double weight = fRef > 0. ? w*target.Density(e0)/fRef : 0.;
+
+    outputFile << x << "," << y << "," << z << "," << energy << ","
+               << weight << "\n";
+
+    nHits++;
+    sumW  += weight;
+    sumW2 += weight*weight;
+    sumX  += weight*x;
+    sumX2 += weight*x*x;
+    sumZ  += weight*z;
+    sumZ2 += weight*z*z;
+  }
+
+  if (nHits == 0 || sumW <= 0.) {
+    std::cerr << "reweight: no tagged hits with non-zero target weight in "
+              << hitsName << std::endl;
+    return 1;
+  }
+
+  double meanX = sumX/sumW, meanZ = sumZ/sumW;
+  long nPrimaries = CountLines(primariesName);
+
+  std::cout << "Reference spectrum : " << reference.ToString() << "\n"
+            << "Target spectrum    : " << target.ToString() << "\n"
+            << "Tagged hits        : " << nHits
+            << " (" << nSkipped << " untagged lines skipped)\n"
+            << "Sum of weights     : " << sumW << "\n"
+            << "Effective entries  : " << sumW*sumW/sumW2 << "\n"
+            << "Weighted mean x, z : " << meanX << ", " << meanZ << " cm\n"
+            << "Weighted std x, z  : "
+            << std::sqrt(std::max(0., sumX2/sumW - meanX*meanX)) << ", "
+            << std::sqrt(std::max(0., sumZ2/sumW - meanZ*meanZ)) << " cm\n";
+  if (nPrimaries > 0) {
+    std::cout << "Hits per primary   : " << sumW/nPrimaries << "\n";
+  }
+  std::cout << "Output             : " << outputName << std::endl;
+
+  return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,223 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+/// \file runstatus.cc
+/// \brief Watch the telemetry status file of a running simulation
+
+// Usage:
+//   runstatus [options]
+//
+//   -f <file>   status file       (default ../analysis/data/status.json)
+//   -i <sec>    polling interval  (default 2)
+//   -s <sec>    a thread without progress for this long is stalled, and a
+//               status file this old belongs to a dead job (default 60)
+//   -n <count>  number of updates, 0 until the job finishes (default 0)
+//
+// Prints one progress line per update and flags stalled threads and
+// stragglers (below half the median thread rate). The exit status of the
+// last update is 0 if all is well, 2 if a thread is stalled and 3 if the
+// status file is missing or stale, so scripts can poll with -n 1.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <sys/time.h>
+#include <unistd.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+  void Usage()
+  {
+    std::cerr << "usage: runstatus [-f status.json] [-i seconds]"
+              << " [-s stall_seconds] [-n count]" << std::endl;
+  }
+
+  // Number after "key": in the flat JSON written by Telemetry
+  double Field(const std::string& text, const char* key, double fallback)
+  {
+    std::string pattern = std::string("\"") + key + "\": ";
+    size_t position = text.find(pattern);
+    if (position == std::string::npos) return fallback;
+    return std::strtod(text.c_str() + position + pattern.size(), 0);
+  }
+
+  std::string StringField(const std::string& text, const char* key)
+  {
+    std::string pattern = std::string("\"") + key + "\": \"";
+    size_t position = text.find(pattern);
+    if (position == std::string::npos) return "";
+    position += pattern.size();
+    return text.substr(position, text.find('"', position) - position);
+  }
+
+  std::string Duration(double seconds)
+  {
+    if (seconds < 0.) return "?";
+    long s = long(seconds + 0.5);
+    std::ostringstream out;
+    if (s >= 3600) out << s/3600 << "h" << std::setw(2) << std::setfill('0')
+                       << (s/60)%60 << "m";
+    else if (s >= 60) out << s/60 << "m" << std::setw(2) << std::setfill('0')
+                          << s%60 << "s";
+    else out << s << "s";
+    return out.str();
+  }
+
+  double Now()
+  {
+    timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec + 1.e-6*now.tv_usec;
+  }
+
+  struct ThreadStatus
+  {
+    int    id;
+    double rate;
+    double sinceProgress;
+  };
+
+  // Prints one update, returns the exit status it stands for
+  int Report(const std::string& fileName, double stallSeconds,
+             std::string& state)
+  {
+    std::ifstream file(fileName.c_str());
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    state = StringField(text, "state");
+    if (state.empty()) {
+      std::cout << "no status in " << fileName << std::endl;
+      return 3;
+    }
+
+    double age = Now() - Field(text, "updated", 0.);
+    long   done  = long(Field(text, "eventsDone", 0.));
+    long   total = long(Field(text, "eventsToProcess", 0.));
+
+    std::cout << "run " << int(Field(text, "run", -1.)) << " " << state
+              << "  " << done << "/" << total << " events";
+    if (total > 0) {
+      std::cout << " (" << std::fixed << std::setprecision(1)
+                << 100.*done/total << "%)";
+    }
+    std::cout << std::fixed << std::setprecision(0)
+              << "  " << Field(text, "eventsPerSecond", 0.) << " ev/s"
+              << "  " << Field(text, "hitsPerSecond", 0.) << " hits/s";
+    if (state == "running") {
+      std::cout << "  ETA " << Duration(Field(text, "etaSeconds", -1.));
+    }
+    std::cout << "  RSS " << Field(text, "rssMB", 0.) << " MB" << std::endl;
+
+    if (state != "finished" && age > stallSeconds) {
+      std::cout << "  status file not updated for " << Duration(age)
+                << ", job " << long(Field(text, "pid", 0.))
+                << " is probably dead" << std::endl;
+      return 3;
+    }
+    if (state != "running") return 0;
+
+    std::vector<ThreadStatus> threads;
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+      if (line.find("{\"id\"") == std::string::npos) continue;
+      ThreadStatus thread;
+      thread.id            = int(Field(line, "id", -1.));
+      thread.rate          = Field(line, "eventsPerSecond", 0.);
+      thread.sinceProgress = Field(line, "secondsSinceProgress", 0.);
+      threads.push_back(thread);
+    }
+    if (threads.empty()) return 0;
+
+    std::vector<double> rates;
+    for (size_t i = 0; i < threads.size(); i++) rates.push_back(threads[i].rate);
+    std::nth_element(rates.begin(), rates.begin() + rates.size()/2, rates.end());
+    double median = rates[rates.size()/2];
+
+    int status = 0;
+    for (size_t i = 0; i < threads.size(); i++) {
+      if (threads[i].sinceProgress >= stallSeconds) {
+        std::cout << "  thread " << threads[i].id << ": stalled, no event"
+                  << " finished for " << Duration(threads[i].sinceProgress)
+                  << std::endl;
+        status = 2;
+      }
+      else if (threads.size() > 1 && threads[i].rate < 0.5*median) {
+        std::cout << "  thread " << threads[i].id << ": straggler, "
+                  << threads[i].rate << " ev/s against a median of "
+                  << median << std::endl;
+      }
+    }
+    return status;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  std::string fileName = "../analysis/data/status.json";
+  double interval     = 2.;
+  double stallSeconds = 60.;
+  int    count        = 0;
+
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc) {
+      Usage();
+      return 1;
+    }
+    if      (!std::strcmp(argv[i], "-f")) fileName     = argv[i+1];
+    else if (!std::strcmp(argv[i], "-i")) interval     = std::atof(argv[i+1]);
+    else if (!std::strcmp(argv[i], "-s")) stallSeconds = std::atof(argv[i+1]);
+    else if (!std::strcmp(argv[i], "-n")) count        = std::atoi(argv[i+1]);
+    else {
+      Usage();
+      return 1;
+    }
+  }
+
+  int status = 0;
+  std::string state;
+  for (int update = 0; count <= 0 || update < count; update++) {
+    if (update > 0) usleep(useconds_t(interval*1.e6));
+    status = Report(fileName, stallSeconds, state);
+    if (state == "finished") break;
+  }
+
+  return status;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,386 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+/// \file scaling.cc
+/// \brief Thread scaling benchmark of the simulation
+
+// Usage:
+//   scaling [options]    (run from the build directory, next to main)
+//
+//   -m <path>    simulation executable             (default ./main)
+//   -j <n>       largest number of threads         (default: all cores)
+//   -n <events>  events of the strong scaling runs, and per thread of the
+//                weak scaling runs                 (default 20000)
+//   -w <names>   comma separated workloads         (default: all)
+//   -r <n>       repetitions, the fastest counts   (default 1)
+//   -l <label>   label stored in the report, e.g. the commit
+//   -o <file>    JSON report                       (default scaling.json)
+//
+// Workloads mirror the production macros: pinhole_100keV and pinhole_1MeV
+// use the beam of auto_run_file.mac, point_3MeV the point source of
+// run_1_angle.mac. Each is run at 1, 2, 4, ... threads up to -j, once with
+// a fixed number of events (strong scaling) and once with a fixed number
+// per thread (weak scaling).
+//
+// Every run is a separate main process in scaling_work/run, so its outputs
+// land in scaling_work/analysis/data and are cleared between runs; the
+// geometry is copied from ../src/pinhole_config.txt. Event and hit counts
+// and the run time come from the telemetry status file, peak RSS from the
+// process accounting. Startup is the wall time outside the run: geometry,
+// physics tables, worker start-up and teardown.
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+  struct Workload
+  {
+    const char* name;
+    const char* commands;
+  };
+
+  const Workload kWorkloads[] = {
+    { "pinhole_100keV",
+      "/gps/particle e-\n/gps/pos/type Beam\n/gps/pos/shape Circle\n"
+      "/gps/pos/radius 1.65 mm\n/gps/pos/sigma_r 0.75 mm\n"
+      "/gps/pos/rot1 1 0 0\n/gps/pos/rot2 0 0 1\n/gps/energy 100 keV\n"
+      "/gps/pos/centre 0.0 -9.5 2.3112 cm\n/gps/direction 0 1 -0.36397\n" },
+    { "pinhole_1MeV",
+      "/gps/particle e-\n/gps/pos/type Beam\n/gps/pos/shape Circle\n"
+      "/gps/pos/radius 1.65 mm\n/gps/pos/sigma_r 0.75 mm\n"
+      "/gps/pos/rot1 1 0 0\n/gps/pos/rot2 0 0 1\n/gps/energy 1000 keV\n"
+      "/gps/pos/centre 0.0 -9.5 2.3112 cm\n/gps/direction 0 1 -0.36397\n" },
+    { "point_3MeV",
+      "/run/setCut 0.05 mm\n/gps/particle e-\n/gps/position 0 -5 -3 cm\n"
+      "/gps/pos/type Point\n/gps/direction 0 1 -0.1\n/gps/energy 3000 keV\n" }
+  };
+  const int kNWorkloads = sizeof(kWorkloads)/sizeof(kWorkloads[0]);
+
+  const char* kWorkDirectory = "scaling_work";
+  const char* kDataDirectory = "scaling_work/analysis/data";
+
+  struct Measurement
+  {
+    int    threads;
+    long   events;
+    long   hits;
+    double wallSeconds;
+    double runSeconds;
+    double peakRssMB;
+  };
+
+  void Usage()
+  {
+    std::cerr << "usage: scaling [-m main] [-j threads] [-n events]"
+              << " [-w workloads] [-r repetitions] [-l label]"
+              << " [-o scaling.json]" << std::endl;
+  }
+
+  double Now()
+  {
+    timeval now;
+    gettimeofday(&now, 0);
+    return now.tv_sec + 1.e-6*now.tv_usec;
+  }
+
+  // Number after "key": in the flat JSON written by Telemetry
+  double Field(const std::string& text, const char* key, double fallback)
+  {
+    std::string pattern = std::string("\"") + key + "\": ";
+    size_t position = text.find(pattern);
+    if (position == std::string::npos) return fallback;
+    return std::strtod(text.c_str() + position + pattern.size(), 0);
+  }
+
+  bool CopyFile(const std::string& from, const std::string& to)
+  {
+    std::ifstream in(from.c_str(), std::ios_base::binary);
+    std::ofstream out(to.c_str(), std::ios_base::binary);
+    if (!in.is_open() || !out.is_open()) return false;
+    out << in.rdbuf();
+    return bool(out);
+  }
+
+  // The output directory is flat, see EventAction and RunAction
+  void ClearDirectory(const std::string& name)
+  {
+    DIR* directory = opendir(name.c_str());
+    if (!directory) return;
+    while (dirent* entry = readdir(directory)) {
+      if (entry->d_name[0] == '.') continue;
+      unlink((name + "/" + entry->d_name).c_str());
+    }
+    closedir(directory);
+  }
+
+  bool PrepareWorkDirectory()
+  {
+    const char* directories[] = { "scaling_work", "scaling_work/run",
+      "scaling_work/src", "scaling_work/analysis", kDataDirectory };
+    for (size_t i = 0; i < sizeof(directories)/sizeof(directories[0]); i++) {
+      if (mkdir(directories[i], 0755) != 0 && errno != EEXIST) {
+        std::cerr << "scaling: cannot create " << directories[i] << ": "
+                  << std::strerror(errno) << std::endl;
+        return false;
+      }
+    }
+    if (!CopyFile("../src/pinhole_config.txt",
+                  std::string(kWorkDirectory) + "/src/pinhole_config.txt")) {
+      std::cerr << "scaling: cannot copy ../src/pinhole_config.txt"
+                << std::endl;
+      return false;
+    }
+    return true;
+  }
+
+  // One main process on a generated macro, false if it failed
+  bool RunOnce(const std::string& mainPath, const Workload& workload,
+               int threads, long events, Measurement& result)
+  {
+    ClearDirectory(kDataDirectory);
+
+    std::string runDirectory = std::string(kWorkDirectory) + "/run";
+    std::ofstream macro((runDirectory + "/scaling.mac").c_str());
+    macro << "/run/numberOfThreads " << threads << "\n"
+          << "/pinhole/telemetry/file ../analysis/data/status.json\n"
+          << "/pinhole/telemetry/interval 1 s\n"
+          << "/pinhole/telemetry/enable true\n"
+          << "/run/initialize\n"
+          << "/control/verbose 0\n/run/verbose 0\n"
+          << "/event/verbose 0\n/tracking/verbose 0\n"
+          << workload.commands
+          << "/run/beamOn " << events << "\n";
+    macro.close();
+
+    double start = Now();
+    pid_t pid = fork();
+    if (pid < 0) {
+      std::cerr << "scaling: fork failed: " << std::strerror(errno)
+                << std::endl;
+      return false;
+    }
+    if (pid == 0) {
+      if (chdir(runDirectory.c_str()) != 0) _exit(127);
+      int log = open("main.log", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+      if (log >= 0) {
+        dup2(log, 1);
+        dup2(log, 2);
+        close(log);
+      }
+      execl(mainPath.c_str(), mainPath.c_str(), "scaling.mac", (char*)0);
+      _exit(127);
+    }
+
+    int status = 0;
+    rusage usage;
+    wait4(pid, &status, 0, &usage);
+    result.wallSeconds = Now() - start;
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      std::cerr << "scaling: " << workload.name << " at " << threads
+                << " threads failed, see " << runDirectory << "/main.log"
+                << std::endl;
+      return false;
+    }
+
+    std::ifstream file((std::string(kDataDirectory) + "/status.json").c_str());
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    result.threads    = threads;
+    result.events     = long(Field(text, "eventsDone", 0.));
+    result.hits       = long(Field(text, "hits", 0.));
+    result.runSeconds = Field(text, "secondsElapsed", result.wallSeconds);
+    result.peakRssMB  = usage.ru_maxrss/1024.;   // kB on Linux
+    return true;
+  }
+
+  void WriteMeasurements(std::ostream& out, const std::vector<Measurement>& runs,
+                         bool weak)
+  {
+    const Measurement& reference = runs.front();
+    for (size_t i = 0; i < runs.size(); i++) {
+      const Measurement& run = runs[i];
+      // Strong: same events, ideal time T1/N. Weak: N times the events,
+      // ideal time T1.
+      double efficiency = weak
+        ? reference.wallSeconds/run.wallSeconds
+        : reference.wallSeconds/(run.threads*run.wallSeconds);
+      double startup = std::max(0., run.wallSeconds - run.runSeconds);
+      out << "        {\"threads\": " << run.threads
+          << ", \"events\": " << run.events
+          << ", \"hits\": " << run.hits
+          << ", \"wallSeconds\": " << run.wallSeconds
+          << ", \"runSeconds\": " << run.runSeconds
+          << ", \"speedup\": "
+          << (weak ? run.threads : 1)*reference.wallSeconds/run.wallSeconds
+          << ", \"efficiency\": " << efficiency
+          << ", \"eventsPerSecond\": "
+          << (run.runSeconds > 0. ? run.events/run.runSeconds : 0.)
+          << ", \"hitsPerSecond\": "
+          << (run.runSeconds > 0. ? run.hits/run.runSeconds : 0.)
+          << ", \"startupShare\": " << startup/run.wallSeconds
+          << ", \"peakRssMB\": " << run.peakRssMB
+          << ", \"peakRssMBPerThread\": " << run.peakRssMB/run.threads
+          << "}" << (i + 1 < runs.size() ? "," : "") << "\n";
+    }
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  std::string mainPath   = "./main";
+  std::string reportName = "scaling.json";
+  std::string label;
+  std::string selection;
+  int  maxThreads  = int(sysconf(_SC_NPROCESSORS_ONLN));
+  long events      = 20000;
+  int  repetitions = 1;
+
+  for (int i = 1; i < argc; i += 2) {
+    if (i + 1 >= argc) {
+      Usage();
+      return 1;
+    }
+    if      (!std::strcmp(argv[i], "-m")) mainPath    = argv[i+1];
+    else if (!std::strcmp(argv[i], "-j")) maxThreads  = std::atoi(argv[i+1]);
+    else if (!std::strcmp(argv[i], "-n")) events      = std::atol(argv[i+1]);
+    else if (!std::strcmp(argv[i], "-w")) selection   = argv[i+1];
+    else if (!std::strcmp(argv[i], "-r")) repetitions = std::atoi(argv[i+1]);
+    else if (!std::strcmp(argv[i], "-l")) label       = argv[i+1];
+    else if (!std::strcmp(argv[i], "-o")) reportName  = argv[i+1];
+    else {
+      Usage();
+      return 1;
+    }
+  }
+  if (maxThreads < 1 || events < 1 || repetitions < 1) {
+    Usage();
+    return 1;
+  }
+
+  // The child changes directory before exec
+  char resolved[PATH_MAX];
+  if (!realpath(mainPath.c_str(), resolved)) {
+    std::cerr << "scaling: cannot find " << mainPath << std::endl;
+    return 1;
+  }
+  mainPath = resolved;
+  if (!PrepareWorkDirectory()) return 1;
+
+  std::vector<int> threadCounts;
+  for (int n = 1; n < maxThreads; n *= 2) threadCounts.push_back(n);
+  threadCounts.push_back(maxThreads);
+
+  std::ostringstream report;
+  report << std::setprecision(6)
+         << "{\n"
+         << "  \"label\": \"" << label << "\",\n"
+         << "  \"created\": " << long(Now()) << ",\n"
+         << "  \"cores\": " << sysconf(_SC_NPROCESSORS_ONLN) << ",\n"
+         << "  \"events\": " << events << ",\n"
+         << "  \"repetitions\": " << repetitions << ",\n"
+         << "  \"workloads\": [\n";
+
+  bool first = true;
+  for (int w = 0; w < kNWorkloads; w++) {
+    const Workload& workload = kWorkloads[w];
+    if (!selection.empty()
+        && ("," + selection + ",").find(std::string(",") + workload.name + ",")
+           == std::string::npos) continue;
+
+    std::vector<Measurement> strong, weak;
+    for (int mode = 0; mode < 2; mode++) {
+      for (size_t t = 0; t < threadCounts.size(); t++) {
+        int  threads = threadCounts[t];
+        long total   = mode == 0 ? events : events*threads;
+
+        // Fastest repetition, the others only add noise from the host
+        Measurement best;
+        best.wallSeconds = -1.;
+        for (int r = 0; r < repetitions; r++) {
+          Measurement run;
+          if (!RunOnce(mainPath, workload, threads, total, run)) return 2;
+          if (best.wallSeconds < 0. || run.wallSeconds < best.wallSeconds) {
+            best = run;
+          }
+        }
+        std::ios_base::fmtflags flags = std::cout.flags();
+        std::streamsize precision = std::cout.precision();
+        std::cout << workload.name << (mode == 0 ? " strong " : " weak ")
+                  << std::setw(3) << threads << " threads  " << std::fixed
+                  << std::setprecision(2) << best.wallSeconds << " s wall  "
+                  << std::setprecision(0)
+                  << (best.runSeconds > 0. ? best.events/best.runSeconds : 0.)
+                  << " ev/s  " << best.peakRssMB << " MB" << std::endl;
+        std::cout.flags(flags);
+        std::cout.precision(precision);
+        (mode == 0 ? strong : weak).push_back(best);
+      }
+    }
+
+    report << (first ? "" : ",\n")
+           << "    {\"name\": \"" << workload.name << "\",\n"
+           << "      \"strong\": [\n";
+    WriteMeasurements(report, strong, false);
+    report << "      ],\n      \"weak\": [\n";
+    WriteMeasurements(report, weak, true);
+    report << "      ]}";
+    first = false;
+  }
+  report << "\n  ]\n}\n";
+
+  std::ofstream out(reportName.c_str());
+  out << report.str();
+  if (!out) {
+    std::cerr << "scaling: cannot write " << reportName << std::endl;
+    return 1;
+  }
+  std::cout << "Report written to " << reportName << std::endl;
+  return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
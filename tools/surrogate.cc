@@ -0,0 +1,264 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file surrogate.cc
+/// \brief Samples synthetic detector1 images from a response library
+
+// Usage:
+//   surrogate <library> [options]
+//
+//   -a <theta> <phi>   point source angles in degrees     (default 0 0)
+//   -e <energy>        mono-energetic source, keV         (default first node)
+//   -S <shape> <emin> <emax> <param>
+//                      source spectrum, as for reweight (MeV)
+//   -s <file>          source list, lines "theta phi energy_keV weight"
+//   -N <primaries>     primaries reaching the pinhole plane (default 1e6)
+//   -r <seed>          random seed                        (default 1)
+//   -x                 write the expected image, no Poisson sampling
+//   -o <file>          output .npy, (nz, nx) float64
+//                      (default ../analysis/data/surrogate_image.npy)
+//
+// The expected image is N times the weighted sum of the library responses
+// interpolated at every source component; the synthetic image draws each
+// pixel from a Poisson distribution around it.
+
+#include "ResponseLibrary.hh"
+#include "EnergySpectrum.hh"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+namespace
+{
+  struct SourceComponent
+  {
+    double theta;
+    double phi;
+    double energy;   // keV
+    double weight;
+  };
+
+  void Usage()
+  {
+    std::cerr << "usage: surrogate <library> [-a theta phi] [-e keV]"
+              << " [-S shape emin emax param] [-s sources.txt] [-N primaries]"
+              << " [-r seed] [-x] [-o image.npy]" << std::endl;
+  }
+
+  bool WriteNpy(const std::string& fileName, const std::vector<double>& image,
+                int nx, int nz)
+  {
+    std::ofstream file(fileName.c_str(), std::ios::out | std::ios::binary);
+    if (!file.is_open()) return false;
+
+    // NPY format 1.0, as PixelImage::WriteNpy
+    std::ostringstream header;
+    header << "{'descr': '<f8', 'fortran_order': False, 'shape': ("
+           << nz << ", " << nx << "), }";
+    std::string dict = header.str();
+    std::size_t total = 10 + dict.size() + 1;
+    dict.append((64 - total % 64) % 64, ' ');
+    dict += '\n';
+
+    unsigned short headerLength = (unsigned short)dict.size();
+    file.write("\x93NUMPY\x01\x00", 8);
+    char lengthBytes[2] = { char(headerLength & 0xff), char(headerLength >> 8) };
+    file.write(lengthBytes, 2);
+    file.write(dict.data(), dict.size());
+    file.write(reinterpret_cast<const char*>(&image[0]),
+               image.size()*sizeof(double));
+    return file.good();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc, char** argv)
+{
+  if (argc < 2) {
+    Usage();
+    return 1;
+  }
+
+  std::string libraryName = argv[1];
+  std::string outputName  = "../analysis/data/surrogate_image.npy";
+  std::string sourcesName;
+  std::string spectrumText;
+  double theta = 0., phi = 0., energy = -1.;
+  double nPrimaries = 1.e6;
+  unsigned long seed = 1;
+  bool expectedOnly = false;
+
+  for (int i = 2; i < argc; i++) {
+    std::string option = argv[i];
+    int remaining = argc - i - 1;
+    if (option == "-a" && remaining >= 2) {
+      theta = std::atof(argv[++i]);
+      phi   = std::atof(argv[++i]);
+    }
+    else if (option == "-e" && remaining >= 1) energy = std::atof(argv[++i]);
+    else if (option == "-S" && remaining >= 4) {
+      spectrumText = std::string(argv[i+1]) + " " + argv[i+2] + " "
+                   + argv[i+3] + " " + argv[i+4];
+      i += 4;
+    }
+    else if (option == "-s" && remaining >= 1) sourcesName = argv[++i];
+    else if (option == "-N" && remaining >= 1) nPrimaries = std::atof(argv[++i]);
+    else if (option == "-r" && remaining >= 1) seed = std::strtoul(argv[++i], 0, 10);
+    else if (option == "-o" && remaining >= 1) outputName = argv[++i];
+    else if (option == "-x") expectedOnly = true;
+    else {
+      Usage();
+      return 1;
+    }
+  }
+
+  ResponseLibrary library;
+  if (!library.Open(libraryName)) {
+    std::cerr << "surrogate: cannot open response library " << libraryName
+              << std::endl;
+    return 1;
+  }
+
+  // ----------------------------------------------------------------
+  // Source components
+  // ----------------------------------------------------------------
+  std::vector<SourceComponent> sources;
+  if (!sourcesName.empty()) {
+    std::ifstream sourcesFile(sourcesName.c_str());
+    if (!sourcesFile.is_open()) {
+      std::cerr << "surrogate: cannot open " << sourcesName << std::endl;
+      return 1;
+    }
+    std::string line;
+    while (std::getline(sourcesFile, line)) {
+      std::istringstream is(line);
+      SourceComponent component;
+      if (is >> component.theta >> component.phi >> component.energy
+             >> component.weight) sources.push_back(component);
+    }
+  }
+  else if (!spectrumText.empty()) {
+    EnergySpectrum spectrum;
+    if (!EnergySpectrum::FromString(spectrumText, spectrum)) {
+      std::cerr << "surrogate: invalid spectrum '" << spectrumText << "'"
+                << std::endl;
+      return 1;
+    }
+    // Midpoint rule on a log grid, fine compared to the library spacing
+    const int nSteps = 64;
+    double logMin = std::log(spectrum.GetMin());
+    double logStep = (std::log(spectrum.GetMax()) - logMin)/nSteps;
+    for (int i = 0; i < nSteps; i++) {
+      double low  = std::exp(logMin + i*logStep);
+      double high = std::exp(logMin + (i + 1)*logStep);
+      double mid  = std::sqrt(low*high);
+      SourceComponent component = { theta, phi, mid*1000.,
+                                    spectrum.Density(mid)*(high - low) };
+      sources.push_back(component);
+    }
+  }
+  else {
+    if (energy <= 0.) energy = library.GetEnergies().front();
+    SourceComponent component = { theta, phi, energy, 1. };
+    sources.push_back(component);
+  }
+
+  double sumWeights = 0.;
+  for (std::size_t i = 0; i < sources.size(); i++) {
+    sumWeights += sources[i].weight;
+  }
+  if (sources.empty() || sumWeights <= 0.) {
+    std::cerr << "surrogate: no source components with positive weight"
+              << std::endl;
+    return 1;
+  }
+
+  // ----------------------------------------------------------------
+  // Expected and sampled image
+  // ----------------------------------------------------------------
+  typedef std::chrono::steady_clock Clock;
+  Clock::time_point start = Clock::now();
+
+  int nx = library.GetNx();
+  int nz = library.GetNz();
+  std::vector<double> image(std::size_t(nx)*nz, 0.);
+  for (std::size_t i = 0; i < sources.size(); i++) {
+    library.Accumulate(sources[i].theta, sources[i].phi, sources[i].energy,
+                       nPrimaries*sources[i].weight/sumWeights, &image[0]);
+  }
+
+  double expected = 0.;
+  for (std::size_t i = 0; i < image.size(); i++) expected += image[i];
+
+  double sampled = expected;
+  if (!expectedOnly) {
+    std::mt19937_64 engine(seed);
+    sampled = 0.;
+    for (std::size_t i = 0; i < image.size(); i++) {
+      if (image[i] <= 0.) continue;
+      std::poisson_distribution<long> poisson(image[i]);
+      image[i] = double(poisson(engine));
+      sampled += image[i];
+    }
+  }
+
+  double elapsed = std::chrono::duration<double, std::micro>(
+    Clock::now() - start).count();
+
+  if (!WriteNpy(outputName, image, nx, nz)) {
+    std::cerr << "surrogate: cannot write " << outputName << std::endl;
+    return 1;
+  }
+
+  const double* config = library.GetConfig();
+  std::cout << "Library   : " << library.GetThetas().size() << " x "
+            << library.GetPhis().size() << " x "
+            << library.GetEnergies().size() << " nodes, " << nx << " x " << nz
+            << " pixels of " << library.GetPitch() << " cm\n"
+            << "Config    : " << config[0] << " " << config[1] << " "
+            << config[2] << " " << config[3] << " (pinhole_config.txt)\n"
+            << "Sources   : " << sources.size() << " components, "
+            << nPrimaries << " primaries\n"
+            << "Hits      : " << expected << " expected";
+  if (!expectedOnly) std::cout << ", " << sampled << " sampled";
+  std::cout << "\n"
+            << "Time      : " << elapsed << " us\n"
+            << "Output    : " << outputName << std::endl;
+
+  return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......